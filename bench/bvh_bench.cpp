@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "mygl/bvh.h"
+#include "mygl/camera.h"
+#include "timing.h"
+
+/* BVH build, refit and query times for growing object counts, queries are checked against brute force */
+
+AABB randomBox(std::mt19937& random)
+{
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    float x = position(random);
+    float y = position(random);
+    float z = position(random);
+    float extent = size(random);
+    return {Vector3D(x - extent, y - extent, z - extent), Vector3D(x + extent, y + extent, z + extent)};
+}
+
+bool run(std::size_t count)
+{
+    std::mt19937 random(5);
+    std::vector<AABB> boxes(count);
+    for(AABB& box : boxes) { box = randomBox(random); }
+
+    BVHBuildOptions serial;
+    serial.threads = 1;
+    BVH bvh;
+    double buildSerial = bestOf(3, [&]() { bvh = bvhBuild(boxes, serial); });
+    double buildParallel = bestOf(3, [&]() { bvh = bvhBuild(boxes); });
+
+    /* move every object a bit, then 1% of them one at a time */
+    std::vector<AABB> moved = boxes;
+    for(AABB& box : moved)
+    {
+        box.min.y += 1.0f;
+        box.max.y += 1.0f;
+    }
+    double refit = bestOf(5, [&]() { bvhRefit(bvh, moved); });
+
+    std::size_t updates = std::max<std::size_t>(1, count / 100);
+    std::vector<uint32_t> updated(updates);
+    for(uint32_t& object : updated) { object = uint32_t(random() % count); }
+    double update = bestOf(5, [&]()
+    {
+        for(uint32_t object : updated)
+        {
+            AABB box = bvh.boxes[object];
+            box.min.x += 0.5f;
+            box.max.x += 0.5f;
+            bvhUpdate(bvh, object, box);
+        }
+    });
+    const std::vector<AABB>& current = bvh.boxes;
+
+    /* frustum query against the batch test of all boxes */
+    Camera camera = cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {10.0f, 14.0f, 10.0f}, {0.0f, 4.0f, 0.0f});
+    Frustum frustum = frustumExtract(cameraViewProjection(camera));
+
+    AABBSoA soa;
+    for(const AABB& box : current) { aabbSoAAppend(soa, box); }
+    std::vector<uint32_t> reference, visible;
+    double frustumBatch = bestOf(10, [&]() { frustumCullAABBs(frustum, soa, reference); });
+    double frustumTree = bestOf(10, [&]() { bvhQueryFrustum(bvh, frustum, visible); });
+    std::sort(visible.begin(), visible.end());
+    bool frustumMatch = reference == visible;
+
+    /* rays from the camera position, brute force keeps the first box in index order on equal distances */
+    const unsigned int rays = 1000;
+    std::uniform_real_distribution<float> target(-300.0f, 300.0f);
+    std::vector<Vector3D> directions(rays);
+    for(Vector3D& direction : directions)
+    {
+        float x = target(random);
+        float y = target(random);
+        float z = target(random);
+        direction = normalize(Vector3D(x, y, z) - camera.position);
+    }
+
+    std::vector<float> referenceDistances(rays, -1.0f), distances(rays, -1.0f);
+    double rayBrute = bestOf(3, [&]()
+    {
+        for(unsigned int r = 0; r < rays; r++)
+        {
+            float best = std::numeric_limits<float>::max();
+            for(const AABB& box : current)
+            {
+                float tMin = 0.0f, tMax = best;
+                for(unsigned int c = 0; c < 3; c++)
+                {
+                    float inverse = 1.0f / directions[r][c];
+                    float t0 = (box.min[c] - camera.position[c]) * inverse;
+                    float t1 = (box.max[c] - camera.position[c]) * inverse;
+                    tMin = std::max(tMin, std::min(t0, t1));
+                    tMax = std::min(tMax, std::max(t0, t1));
+                }
+                if(tMin <= tMax && tMin < best) { best = tMin; }
+            }
+            referenceDistances[r] = best < std::numeric_limits<float>::max() ? best : -1.0f;
+        }
+    });
+    double rayTree = bestOf(3, [&]()
+    {
+        for(unsigned int r = 0; r < rays; r++)
+        {
+            BVHRayHit hit;
+            distances[r] = bvhQueryRay(bvh, camera.position, directions[r], hit) ? hit.distance : -1.0f;
+        }
+    });
+    bool rayMatch = referenceDistances == distances;
+
+    std::printf("%zu objects, %zu nodes\n", count, bvh.nodes.size());
+    std::printf("  build 1 thread     %9.3f ms\n  build parallel     %9.3f ms (%.1fx)\n", buildSerial, buildParallel, buildSerial / buildParallel);
+    std::printf("  refit all          %9.3f ms\n  update %6zu       %9.3f ms\n", refit, updates, update);
+    std::printf("  frustum batch      %9.3f ms\n  frustum bvh        %9.3f ms (%.1fx, %zu visible)%s\n", frustumBatch, frustumTree,
+                frustumBatch / frustumTree, visible.size(), frustumMatch ? "" : "  MISMATCH");
+    std::printf("  %u rays brute     %9.3f ms\n  %u rays bvh       %9.3f ms (%.1fx)%s\n", rays, rayBrute, rays, rayTree, rayBrute / rayTree,
+                rayMatch ? "" : "  MISMATCH");
+    return frustumMatch && rayMatch;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::size_t> counts = {10000, 100000, 1000000};
+    if(argc > 1)
+    {
+        counts = {std::size_t(std::atoll(argv[1]))};
+    }
+
+    bool ok = true;
+    for(std::size_t count : counts)
+    {
+        ok = run(count) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
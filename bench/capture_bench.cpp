@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mygl/capture.h"
+#include "mygl/glstate.h"
+#include "timing.h"
+
+/*
+ * sustained frame capture: every frame is captured, once per format and backpressure mode, swapped with the window's vsync.
+ * Frames are a blit of a noisy gradient image that moves every frame, so the encoders get content that compresses about
+ * like a rendered scene. Reports render thread time per frame and dropped frames, captureDelete adds the encoder time
+ * per frame, from which the encoder threads needed for 60 fps follow.
+ */
+
+GLuint createSourceFramebuffer(int width, int height)
+{
+    std::vector<uint8_t> pixels(std::size_t(width) * height * 4);
+    uint32_t seed = 1;
+    for(int y = 0; y < height; y++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const int noise = int(seed >> 28);
+            uint8_t* pixel = &pixels[(std::size_t(y) * width + x) * 4];
+            pixel[0] = uint8_t(std::min(255, x * 255 / width + noise));
+            pixel[1] = uint8_t(std::min(255, y * 255 / height + noise));
+            pixel[2] = uint8_t(128 + 100 * std::sin(float(x + y) * 0.01f));
+            pixel[3] = 255;
+        }
+    }
+
+    GLuint texture, framebuffer;
+    glGenTextures(1, &texture);
+    glStateBindTexture(0, GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    return framebuffer;
+}
+
+void run(GLFWwindow* window, GLuint source, int width, int height, int frames, CaptureFormat format, CaptureBackpressure backpressure,
+         const char* name)
+{
+    CaptureOptions options;
+    options.directory = "bench_capture";
+    options.format = format;
+    options.backpressure = backpressure;
+    Capture* capture = captureCreate(options);
+
+    std::vector<double> frameMs;
+    for(int frame = 0; frame < frames; frame++)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        /* the image moves a few pixels per frame, the rest is cleared */
+        const int shift = (frame * 7) % (width / 4);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+        glBlitFramebuffer(0, 0, width - shift, height, shift, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+        captureFrame(capture);
+        glfwSwapBuffers(window);
+        frameMs.push_back(elapsedMs(start));
+    }
+
+    const uint64_t dropped = capture->dropped;
+    const double blocked = capture->blockedMs;
+    captureDelete(capture);
+
+    std::sort(frameMs.begin(), frameMs.end());
+    double sum = 0.0;
+    for(double ms : frameMs)
+    {
+        sum += ms;
+    }
+    std::printf("%-12s render thread mean %7.2f ms, p99 %7.2f ms, max %7.2f ms | dropped %4llu | blocked %8.1f ms\n", name,
+                sum / frames, frameMs[std::size_t(0.99 * (frames - 1))], frameMs.back(), (unsigned long long) dropped, blocked);
+    std::filesystem::remove_all(options.directory);
+}
+
+int main(int argc, char** argv)
+{
+    const int width = argc > 2 ? std::atoi(argv[1]) : 1920;
+    const int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    const int frames = argc > 3 ? std::atoi(argv[3]) : 300;
+
+    GLFWwindow* window = windowCreate("Capture Benchmark", unsigned(width), unsigned(height));
+    if(!window) { return EXIT_FAILURE; }
+    glViewport(0, 0, width, height);
+    GLuint source = createSourceFramebuffer(width, height);
+    std::printf("%dx%d, %d frames, %u hardware threads\n", width, height, frames, std::thread::hardware_concurrency());
+
+    /* encoder cost of one frame without the rest of the pipeline, which gives the threads needed for 60 fps */
+    std::vector<uint8_t> pixels(std::size_t(width) * height * 4), encoded;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    auto start = std::chrono::steady_clock::now();
+    captureEncodeQOI(pixels.data(), unsigned(width), unsigned(height), encoded);
+    const double qoiMs = elapsedMs(start);
+    std::printf("QOI: %.2f ms and %.1f MB per frame (raw %.1f MB), %.1f encoder threads for 60 fps\n", qoiMs,
+                double(encoded.size()) / 1e6, double(pixels.size()) / 1e6, qoiMs * 60.0 / 1000.0);
+
+    run(window, source, width, height, frames, CaptureFormat::QOI, CaptureBackpressure::Drop, "qoi drop");
+    run(window, source, width, height, frames, CaptureFormat::QOI, CaptureBackpressure::Block, "qoi block");
+    run(window, source, width, height, frames, CaptureFormat::Raw, CaptureBackpressure::Drop, "raw drop");
+    run(window, source, width, height, frames / 10, CaptureFormat::PNG, CaptureBackpressure::Drop, "png drop");
+
+    windowDelete(window);
+    return EXIT_SUCCESS;
+}
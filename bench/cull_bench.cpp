@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "mygl/camera.h"
+#include "mygl/frustum.h"
+#include "timing.h"
+
+/* frustum culling of 1M spheres and boxes, one object at a time and in SoA batches */
+
+int main(int argc, char** argv)
+{
+    std::size_t count = argc > 1 ? std::size_t(std::atoll(argv[1])) : 1000000;
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+
+    std::vector<BoundingSphere> sphereList(count);
+    std::vector<AABB> boxList(count);
+    SphereSoA spheres;
+    AABBSoA boxes;
+    for(std::size_t i = 0; i < count; i++)
+    {
+        Vector3D center(position(random), position(random), position(random));
+        float extent = size(random);
+        sphereList[i] = {center, extent};
+        boxList[i] = {center - Vector3D(extent, extent, extent), center + Vector3D(extent, 0.5f * extent, extent)};
+        sphereSoAAppend(spheres, sphereList[i]);
+        aabbSoAAppend(boxes, boxList[i]);
+    }
+
+    /* camera of the assignment scene */
+    Camera camera = cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {10.0f, 14.0f, 10.0f}, {0.0f, 4.0f, 0.0f});
+    Frustum frustum = frustumExtract(cameraViewProjection(camera));
+
+    std::vector<uint32_t> reference, visible;
+    FrustumCullStats stats;
+
+    double sphereScalar = bestOf(5, [&]()
+    {
+        reference.clear();
+        for(std::size_t i = 0; i < count; i++)
+        {
+            if(frustumTestSphere(frustum, sphereList[i])) { reference.push_back(uint32_t(i)); }
+        }
+    });
+    double sphereBatch = bestOf(20, [&]() { stats = FrustumCullStats(); frustumCullSpheres(frustum, spheres, visible, &stats); });
+    bool sphereMatch = reference == visible;
+    std::printf("spheres: %zu visible, %zu culled\n", stats.visible, stats.culled);
+    std::printf("  one at a time %8.3f ms\n  SoA batch     %8.3f ms (%.1fx)%s\n", sphereScalar, sphereBatch, sphereScalar / sphereBatch,
+                sphereMatch ? "" : "  MISMATCH");
+
+    double boxScalar = bestOf(5, [&]()
+    {
+        reference.clear();
+        for(std::size_t i = 0; i < count; i++)
+        {
+            if(frustumTestAABB(frustum, boxList[i])) { reference.push_back(uint32_t(i)); }
+        }
+    });
+    double boxBatch = bestOf(20, [&]() { stats = FrustumCullStats(); frustumCullAABBs(frustum, boxes, visible, &stats); });
+    bool boxMatch = reference == visible;
+    std::printf("boxes:   %zu visible, %zu culled\n", stats.visible, stats.culled);
+    std::printf("  one at a time %8.3f ms\n  SoA batch     %8.3f ms (%.1fx)%s\n", boxScalar, boxBatch, boxScalar / boxBatch,
+                boxMatch ? "" : "  MISMATCH");
+
+    return sphereMatch && boxMatch ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,60 @@
+#include "fixtures.h"
+
+#include <cmath>
+#include <cstdio>
+
+void gridMesh(unsigned int n, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    for(unsigned int z = 0; z < n; z++)
+    {
+        for(unsigned int x = 0; x < n; x++)
+        {
+            vertices.push_back({{float(x) * 0.1f, std::sin(float(x + z) * 0.05f), float(z) * 0.1f}, {float(x) / n, float(z) / n, 0.5f, 1.0f}});
+        }
+    }
+    for(unsigned int z = 0; z + 1 < n; z++)
+    {
+        for(unsigned int x = 0; x + 1 < n; x++)
+        {
+            unsigned int i = z * n + x;
+            indices.insert(indices.end(), {i, i + n, i + 1, i + 1, i + n, i + n + 1});
+        }
+    }
+}
+
+void sphereMesh(unsigned int rings, unsigned int segments, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float bump)
+{
+    for(unsigned int r = 0; r <= rings; r++)
+    {
+        float theta = float(M_PI) * float(r) / float(rings);
+        for(unsigned int s = 0; s <= segments; s++)
+        {
+            float phi = 2.0f * float(M_PI) * float(s) / float(segments);
+            float radius = 1.0f + bump * std::sin(6.0f * theta) * std::cos(8.0f * phi);
+            vertices.push_back({radius * Vector3D(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)), {1.0f, 1.0f, 1.0f, 1.0f}});
+        }
+    }
+    for(unsigned int r = 0; r < rings; r++)
+    {
+        for(unsigned int s = 0; s < segments; s++)
+        {
+            unsigned int i = r * (segments + 1) + s;
+            unsigned int j = i + segments + 1;
+            indices.insert(indices.end(), {i, i + 1, j, i + 1, j + 1, j});
+        }
+    }
+}
+
+void writeOBJ(const std::string& filepath, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    FILE* file = std::fopen(filepath.c_str(), "w");
+    for(const Vertex& v : vertices)
+    {
+        std::fprintf(file, "v %f %f %f %f %f %f\n", v.pos.x, v.pos.y, v.pos.z, v.color.x, v.color.y, v.color.z);
+    }
+    for(std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        std::fprintf(file, "f %u %u %u\n", indices[i] + 1, indices[i + 1] + 1, indices[i + 2] + 1);
+    }
+    std::fclose(file);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "mygl/mesh.h"
+
+#include <string>
+#include <vector>
+
+/* meshes and files shared by the benchmark programs (bench/fixtures.cpp) */
+
+/* n x n vertex grid with a sine height and a color gradient, two triangles per cell */
+void gridMesh(unsigned int n, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+/* UV sphere of radius 1, white; bump > 0 adds a sin/cos relief of that relative height so simplification has detail */
+void sphereMesh(unsigned int rings, unsigned int segments, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                float bump = 0.0f);
+
+/* OBJ file with "v x y z r g b" vertices and 1-based triangle faces */
+void writeOBJ(const std::string& filepath, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
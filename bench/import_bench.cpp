@@ -0,0 +1,94 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "mygl/importer.h"
+#include "fixtures.h"
+
+/* measures OBJ and PLY import throughput (MB/s) for different thread counts */
+
+void writePLY(const std::string& filepath, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, bool binary)
+{
+    FILE* file = std::fopen(filepath.c_str(), "wb");
+    std::fprintf(file, "ply\nformat %s 1.0\nelement vertex %zu\nproperty float x\nproperty float y\nproperty float z\n"
+                       "property uchar red\nproperty uchar green\nproperty uchar blue\nelement face %zu\n"
+                       "property list uchar int vertex_indices\nend_header\n",
+                 binary ? "binary_little_endian" : "ascii", vertices.size(), indices.size() / 3);
+
+    for(const Vertex& v : vertices)
+    {
+        unsigned char rgb[3] = {(unsigned char) (v.color.x * 255), (unsigned char) (v.color.y * 255), (unsigned char) (v.color.z * 255)};
+        if(binary)
+        {
+            std::fwrite(&v.pos, sizeof(float), 3, file);
+            std::fwrite(rgb, 1, 3, file);
+        }
+        else
+        {
+            std::fprintf(file, "%f %f %f %u %u %u\n", v.pos.x, v.pos.y, v.pos.z, rgb[0], rgb[1], rgb[2]);
+        }
+    }
+    for(std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        if(binary)
+        {
+            unsigned char count = 3;
+            std::fwrite(&count, 1, 1, file);
+            std::fwrite(&indices[i], sizeof(unsigned int), 3, file);
+        }
+        else
+        {
+            std::fprintf(file, "3 %u %u %u\n", indices[i], indices[i + 1], indices[i + 2]);
+        }
+    }
+    std::fclose(file);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int n = argc > 1 ? (unsigned int) std::atoi(argv[1]) : 1500;
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    gridMesh(n, vertices, indices);
+
+    auto dir = std::filesystem::temp_directory_path();
+    struct Input { const char* name; std::string path; };
+    Input inputs[] = {
+        {"obj",        (dir / "import_bench.obj").string()},
+        {"ply ascii",  (dir / "import_bench_ascii.ply").string()},
+        {"ply binary", (dir / "import_bench_binary.ply").string()},
+    };
+    writeOBJ(inputs[0].path, vertices, indices);
+    writePLY(inputs[1].path, vertices, indices, false);
+    writePLY(inputs[2].path, vertices, indices, true);
+
+    std::printf("mesh: %zu vertices, %zu triangles\n", vertices.size(), indices.size() / 3);
+    std::printf("%-12s %8s %10s %10s %10s %14s\n", "format", "threads", "size MB", "time ms", "MB/s", "buffered MB");
+
+    for(const Input& input : inputs)
+    {
+        for(unsigned int threads = 1; ; threads = std::min(threads * 2, maxThreads))
+        {
+            ImportOptions options;
+            options.threads = threads;
+            ImportStats stats;
+            std::vector<Vertex> v;
+            std::vector<unsigned int> i;
+            importMesh(input.path, v, i, options, &stats);
+
+            double bufferedMB = double(options.chunkSize) * 2 * threads / (1024.0 * 1024.0);
+            std::printf("%-12s %8u %10.1f %10.1f %10.1f %14.1f\n", input.name, threads, double(stats.bytes) / (1024.0 * 1024.0),
+                        stats.seconds * 1000.0, stats.megabytesPerSecond(), bufferedMB);
+
+            if(threads == maxThreads) { break; }
+        }
+        std::filesystem::remove(input.path);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "mygl/geometry.h"
+#include "mygl/glstate.h"
+#include "mygl/meshpool.h"
+#include "mygl/shader.h"
+#include "mygl/shadervariant.h"
+#include "mygl/camera.h"
+#include "mygl/uniformbuffer.h"
+#include "mygl/transform.h"
+#include "timing.h"
+
+/*
+ * spinning cubes drawn with one uniform upload + draw call per cube and with meshDrawInstanced, from 1 to 1M cubes.
+ * Has to be started from the build output directory so that the shader folder is found.
+ */
+
+/* cubes on a square grid in the xz plane, each spinning around the y axis with its own phase */
+void updateModels(std::vector<Matrix4D>& models, float time)
+{
+    unsigned int side = unsigned(std::ceil(std::sqrt(double(models.size()))));
+    for(std::size_t i = 0; i < models.size(); i++)
+    {
+        float x = (float(i % side) - side * 0.5f) * 3.0f;
+        float z = (float(i / side) - side * 0.5f) * 3.0f;
+        models[i] = Matrix4D::translation({x, 0.0f, z}) * Matrix4D::rotationY(time + float(i) * 0.01f);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    GLFWwindow* window = windowCreate("Instancing Benchmark", 1280, 720);
+    if(!window) { return EXIT_FAILURE; }
+    glfwSwapInterval(0);
+    glStateEnable(GL_DEPTH_TEST);
+
+    ShaderVariants shaders = shaderVariantsCreate("shader/default.vert", "shader/default.frag");
+    ShaderProgram& shaderColor = shaderVariant(shaders, {});
+    ShaderProgram& shaderInstanced = shaderVariant(shaders, {"INSTANCED"});
+    shaderWait(shaderColor);
+    shaderWait(shaderInstanced);
+    ShaderUniform<Matrix4D> mvpUniform = shaderUniformHandle<Matrix4D>(shaderColor, "uMVP");
+    Mesh cubeMesh = meshCreate(cube::vertices, cube::indices, GL_STATIC_DRAW, GL_STATIC_DRAW);
+    Camera camera = cameraCreate(1280, 720, to_radians(45.0f), 0.1f, 5000.0f, {0.0f, 800.0f, 1500.0f});
+
+    /* the camera doesn't move, both programs read the same block */
+    UniformRing cameraUniforms = uniformRingCreate(cameraBlockLayout(), SHADER_BINDING_CAMERA);
+    CameraBlock block = cameraBlock(camera, 0.0f);
+    uniformRingWrite(cameraUniforms, &block);
+
+    const std::size_t maxPerCubeDraws = 100000;
+    std::printf("%10s %12s %14s %14s\n", "cubes", "update ms", "instanced ms", "per cube ms");
+
+    for(std::size_t count = 1; count <= 1000000; count *= 10)
+    {
+        std::vector<Matrix4D> models(count);
+        const int frames = count >= 100000 ? 5 : 20;
+        double updateMs = 0.0, instancedMs = 0.0, perCubeMs = 0.0;
+
+        for(int frame = 0; frame < frames; frame++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            updateModels(models, float(frame) * 0.016f);
+            updateMs += elapsedMs(start);
+
+            /* instanced: one draw for all cubes */
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            start = std::chrono::steady_clock::now();
+            glStateUseProgram(shaderInstanced.id);
+            meshDrawInstanced(cubeMesh, models);
+            glFinish();
+            instancedMs += elapsedMs(start);
+
+            /* reference: one uniform upload and draw call per cube */
+            if(count <= maxPerCubeDraws)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                start = std::chrono::steady_clock::now();
+                glStateUseProgram(shaderColor.id);
+                glStateBindVertexArray(cubeMesh.vao);
+                for(const Matrix4D& model : models)
+                {
+                    shaderUniform(mvpUniform, matrixMultiply(cameraViewProjection(camera), model));
+                    meshDraw(cubeMesh);
+                }
+                glFinish();
+                perCubeMs += elapsedMs(start);
+            }
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        glCheckError();
+
+        if(count <= maxPerCubeDraws)
+        {
+            std::printf("%10zu %12.3f %14.3f %14.3f\n", count, updateMs / frames, instancedMs / frames, perCubeMs / frames);
+        }
+        else
+        {
+            std::printf("%10zu %12.3f %14.3f %14s\n", count, updateMs / frames, instancedMs / frames, "-");
+        }
+    }
+
+    shaderVariantsDelete(shaders);
+    meshDelete(cubeMesh);
+    meshPoolRelease();
+    uniformRingDelete(cameraUniforms);
+    windowDelete(window);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "mygl/jobs.h"
+#include "timing.h"
+
+/* job scheduler scaling from 1 to N workers: a parallel loop, many small jobs and dependency chains */
+
+int main(int argc, char** argv)
+{
+    unsigned int maxThreads = argc > 1 ? unsigned(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> threadCounts;
+    for(unsigned int threads = 1; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    const std::size_t count = 1 << 22;
+    std::vector<float> values(count);
+    const unsigned int smallJobs = 100000;
+
+    bool ok = true;
+    double singleLoop = 0.0, singleJobs = 0.0;
+    for(unsigned int threads : threadCounts)
+    {
+        JobScheduler* scheduler = jobSchedulerCreate(threads);
+
+        /* compute bound loop with automatic grain size */
+        jobSchedulerResetStats(scheduler);
+        double loop = bestOf(5, [&]()
+        {
+            jobParallelFor(scheduler, count, [&](std::size_t begin, std::size_t end)
+            {
+                for(std::size_t i = begin; i < end; i++)
+                {
+                    values[i] = std::sqrt(float(i)) * std::sin(float(i));
+                }
+            });
+        });
+        std::vector<JobWorkerStats> stats = jobSchedulerStats(scheduler);
+
+        /*
+         * scheduling overhead of tiny jobs, in batches that fit into the queue: jobs scheduled into a full queue run inline
+         * and would only measure a function call
+         */
+        std::atomic<unsigned int> executed{0};
+        double jobs = bestOf(5, [&]()
+        {
+            for(unsigned int batch = 0; batch < smallJobs; batch += unsigned(JOBQUEUE_CAPACITY))
+            {
+                JobCounter counter;
+                const unsigned int end = std::min(smallJobs, batch + unsigned(JOBQUEUE_CAPACITY));
+                for(unsigned int i = batch; i < end; i++)
+                {
+                    jobRun(scheduler, jobCreate([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }), &counter);
+                }
+                jobWait(scheduler, counter);
+            }
+        });
+        ok = executed == 5 * smallJobs && ok;
+
+        /* a -> (b, c) -> d, every stage has to see the results of the previous one */
+        int a = 0, b = 0, c = 0, d = 0;
+        JobCounter first, second, last;
+        jobRun(scheduler, jobCreate([&a]() { a = 1; }), &first);
+        jobRunAfter(scheduler, jobCreate([&a, &b]() { b = a + 1; }), first, &second);
+        jobRunAfter(scheduler, jobCreate([&a, &c]() { c = a + 2; }), first, &second);
+        jobRunAfter(scheduler, jobCreate([&b, &c, &d]() { d = b + c; }), second, &last);
+        jobWait(scheduler, last);
+        ok = d == 5 && ok;
+
+        if(threads == 1)
+        {
+            singleLoop = loop;
+            singleJobs = jobs;
+        }
+        std::printf("%2u workers: parallel for %8.3f ms (%.2fx), %u jobs %8.3f ms (%.3f us/job, %.2fx)\n", threads, loop, singleLoop / loop,
+                    smallJobs, jobs, 1000.0 * jobs / smallJobs, singleJobs / jobs);
+        for(unsigned int w = 0; w < stats.size(); w++)
+        {
+            std::printf("    worker %2u: %6llu jobs, %6llu stolen, %5.1f%% busy\n", w, (unsigned long long) stats[w].executed,
+                        (unsigned long long) stats[w].stolen, 100.0 * stats[w].utilization);
+        }
+
+        jobSchedulerDelete(scheduler);
+    }
+
+    std::printf("%s\n", ok ? "all jobs executed in order" : "MISMATCH");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "mygl/simplify.h"
+#include "fixtures.h"
+
+/* builds an LOD chain for a dense sphere and compares the triangles submitted for a scene of many distant copies */
+
+int main(int argc, char** argv)
+{
+    unsigned int copies = argc > 1 ? unsigned(std::atoi(argv[1])) : 2000;
+
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    sphereMesh(256, 256, vertices, indices, 0.05f);
+
+    /* same ratios as lodChainCreate(...) would get, the meshes stay empty since no GL context is needed here */
+    const std::vector<float> ratios = {0.5f, 0.25f, 0.125f, 0.0625f, 0.03125f, 0.015625f};
+    const float maxError = 0.1f;
+
+    LodChain chain;
+    chain.sphere = boundsCompute(vertices.data(), vertices.size()).sphere;
+    chain.levels.push_back({Mesh(), 0.0f, unsigned(indices.size() / 3)});
+
+    std::printf("%-6s %10s %10s %10s\n", "level", "triangles", "error", "build ms");
+    std::printf("%-6u %10u %10.5f %10s\n", 0u, chain.levels[0].triangles, 0.0f, "-");
+    for(float ratio : ratios)
+    {
+        float error = 0.0f;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<unsigned int> simplified = simplifyMesh(vertices, indices, std::size_t(double(indices.size() / 3) * ratio) * 3, maxError, &error);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if(simplified.size() / 3 > chain.levels.back().triangles * 9 / 10)
+        {
+            continue;
+        }
+        chain.levels.push_back({Mesh(), std::max(error, chain.levels.back().error), unsigned(simplified.size() / 3)});
+        std::printf("%-6zu %10u %10.5f %10.1f\n", chain.levels.size() - 1, chain.levels.back().triangles, chain.levels.back().error, ms);
+    }
+
+    /* copies scattered up to the far plane of the scene camera */
+    Camera camera = cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {10.0f, 14.0f, 10.0f});
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-350.0f, 350.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 3.0f);
+
+    std::vector<unsigned int> histogram(chain.levels.size(), 0);
+    std::size_t fullTriangles = 0, lodTriangles = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int i = 0; i < copies; i++)
+    {
+        float x = position(random);
+        float z = position(random);
+        float s = scale(random);
+        Matrix4D model = Matrix4D::translation({x, 0.0f, z}) * Matrix4D::scale(s, s, s);
+        unsigned int level = lodSelect(chain, model, camera);
+        histogram[level]++;
+        fullTriangles += chain.levels[0].triangles;
+        lodTriangles += chain.levels[level].triangles;
+    }
+    double selectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("\n%u copies, selection took %.3f ms\n", copies, selectMs);
+    for(std::size_t i = 0; i < histogram.size(); i++)
+    {
+        std::printf("  level %zu: %u copies\n", i, histogram[i]);
+    }
+    std::printf("triangles without LOD: %zu\ntriangles with LOD:    %zu (%.1f%% saved)\n", fullTriangles, lodTriangles,
+                100.0 * double(fullTriangles - lodTriangles) / double(fullTriangles));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "mygl/camera.h"
+#include "mygl/meshlet.h"
+#include "fixtures.h"
+
+/* percentage of triangles removed by meshlet frustum and normal cone culling for a few typical views */
+
+void terrainMesh(unsigned int n, float size, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    for(unsigned int z = 0; z < n; z++)
+    {
+        for(unsigned int x = 0; x < n; x++)
+        {
+            float px = (float(x) / (n - 1) - 0.5f) * size;
+            float pz = (float(z) / (n - 1) - 0.5f) * size;
+            vertices.push_back({{px, 0.5f * std::sin(px * 0.3f) * std::cos(pz * 0.2f), pz}, {1.0f, 1.0f, 1.0f, 1.0f}});
+        }
+    }
+    for(unsigned int z = 0; z + 1 < n; z++)
+    {
+        for(unsigned int x = 0; x + 1 < n; x++)
+        {
+            unsigned int i = z * n + x;
+            indices.insert(indices.end(), {i, i + n, i + 1, i + 1, i + n, i + n + 1});
+        }
+    }
+}
+
+void runView(const char* name, const Mesh& mesh, const std::vector<Meshlet>& meshlets, const Matrix4D& model, const Camera& camera)
+{
+    MeshletDrawList drawList;
+    MeshletCullStats stats;
+    const Matrix4D& viewProjection = cameraViewProjection(camera);
+
+    auto start = std::chrono::steady_clock::now();
+    meshletCull(mesh, meshlets, model, viewProjection, camera.position, drawList, &stats);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-24s %9u %9u %9u %9zu %9.1f%% %8zu %8.3f\n", name, stats.meshlets, stats.frustumCulled, stats.backfaceCulled,
+                stats.triangles, stats.culledPercent(), drawList.counts.size(), ms);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+
+    /* meshes are only needed for their offsets, no GL context is used */
+    Mesh mesh;
+
+    std::printf("%-24s %9s %9s %9s %9s %10s %8s %8s\n", "view", "meshlets", "frustum", "backface", "tris", "culled", "ranges", "ms");
+
+    sphereMesh(256, 512, vertices, indices);
+    std::vector<Meshlet> sphere = meshletBuild(vertices, indices);
+    Matrix4D model = Matrix4D::scale(3.0f, 3.0f, 3.0f);
+    runView("sphere orbit", mesh, sphere, model, cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {10.0f, 14.0f, 10.0f}));
+    runView("sphere close-up", mesh, sphere, model, cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {0.0f, 1.0f, 4.5f}, {0.0f, 1.0f, 0.0f}));
+    runView("sphere inside", mesh, sphere, model, cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}));
+
+    vertices.clear();
+    indices.clear();
+    terrainMesh(700, 200.0f, vertices, indices);
+    std::vector<Meshlet> terrain = meshletBuild(vertices, indices);
+    model = Matrix4D::identity();
+    runView("terrain default camera", mesh, terrain, model, cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {10.0f, 14.0f, 10.0f}, {0.0f, 4.0f, 0.0f}));
+    runView("terrain low", mesh, terrain, model, cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {0.0f, 2.0f, 0.0f}, {30.0f, 0.0f, 30.0f}));
+    runView("terrain from below", mesh, terrain, model, cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {0.0f, -20.0f, 0.0f}, {10.0f, 0.0f, 10.0f}));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "mygl/importer.h"
+#include "mygl/meshfile.h"
+#include "timing.h"
+#include "fixtures.h"
+
+/* compares loading a mesh from OBJ text against mapping the same mesh stored in the binary mesh format */
+
+int main(int argc, char** argv)
+{
+    unsigned int n = argc > 1 ? (unsigned int) std::atoi(argv[1]) : 1024;
+    int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    gridMesh(n, vertices, indices);
+
+    auto dir = std::filesystem::temp_directory_path();
+    std::string objPath = (dir / "meshload_bench.obj").string();
+    std::string vcmPath = (dir / "meshload_bench.vcm").string();
+    writeOBJ(objPath, vertices, indices);
+    meshFileWrite(vcmPath, vertices, indices);
+
+    double objMB = double(std::filesystem::file_size(objPath)) / (1024.0 * 1024.0);
+    double vcmMB = double(std::filesystem::file_size(vcmPath)) / (1024.0 * 1024.0);
+
+    double objMs = bestOf(runs, [&]() {
+        std::vector<Vertex> v;
+        std::vector<unsigned int> i;
+        importOBJ(objPath, v, i);
+    });
+
+    /* touch every byte so the mapping is actually paged in */
+    volatile float sink = 0.0f;
+    double vcmMs = bestOf(runs, [&]() {
+        MeshFile file = meshFileOpen(vcmPath);
+        float sum = 0.0f;
+        for(uint32_t i = 0; i < file.header->vertexCount; i++) { sum += file.vertices[i].pos.y; }
+        for(uint32_t i = 0; i < file.header->indexCount; i++) { sum += float(file.indices[i] & 1u); }
+        sink = sink + sum;
+        meshFileClose(file);
+    });
+
+    std::printf("mesh: %zu vertices, %zu triangles\n", vertices.size(), indices.size() / 3);
+    std::printf("%-8s %10s %12s %10s\n", "format", "size MB", "load ms", "MB/s");
+    std::printf("%-8s %10.2f %12.3f %10.1f\n", "obj", objMB, objMs, objMB / (objMs / 1000.0));
+    std::printf("%-8s %10.2f %12.3f %10.1f\n", "vcm", vcmMB, vcmMs, vcmMB / (vcmMs / 1000.0));
+    std::printf("speedup: %.1fx\n", objMs / vcmMs);
+
+    std::filesystem::remove(objPath);
+    std::filesystem::remove(vcmPath);
+    return EXIT_SUCCESS;
+}
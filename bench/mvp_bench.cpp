@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "mygl/camera.h"
+#include "mygl/geometry.h"
+#include "mygl/glstate.h"
+#include "mygl/meshpool.h"
+#include "mygl/shader.h"
+#include "mygl/transform.h"
+#include "timing.h"
+
+/*
+ * per-vertex matrix work on the water grid: the old vertex shader (uProj * uView * uModel, evaluated left to right, plus
+ * uModel again for the world position), world position * viewProj and a precombined MVP. The vertex stage is isolated
+ * with GL_RASTERIZER_DISCARD. Also compares the scalar and the SIMD matrix product on the CPU.
+ */
+
+const char* chainedSource = R"(#version 330 core
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec4 aColor;
+uniform mat4 uModel;
+uniform mat4 uView;
+uniform mat4 uProj;
+out vec4 tColor;
+out vec3 tFragPos;
+void main(void)
+{
+    gl_Position = uProj * uView * uModel * vec4(aPosition, 1.0);
+    tColor = aColor;
+    tFragPos = vec3(uModel * vec4(aPosition, 1.0));
+})";
+
+const char* worldSource = R"(#version 330 core
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec4 aColor;
+uniform mat4 uModel;
+uniform mat4 uViewProj;
+out vec4 tColor;
+void main(void)
+{
+    gl_Position = uViewProj * (uModel * vec4(aPosition, 1.0));
+    tColor = aColor;
+})";
+
+const char* mvpSource = R"(#version 330 core
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec4 aColor;
+uniform mat4 uMVP;
+out vec4 tColor;
+void main(void)
+{
+    gl_Position = uMVP * vec4(aPosition, 1.0);
+    tColor = aColor;
+})";
+
+const char* fragmentSource = R"(#version 330 core
+in vec4 tColor;
+out vec4 FragColor;
+void main(void)
+{
+    FragColor = tColor;
+})";
+
+int main(int argc, char** argv)
+{
+    const int draws = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const int frames = 10;
+
+    GLFWwindow* window = windowCreate("MVP Benchmark", 1280, 720);
+    if(!window) { return EXIT_FAILURE; }
+    glfwSwapInterval(0);
+
+    Camera camera = cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {10.0f, 14.0f, 10.0f}, {0.0f, 4.0f, 0.0f});
+    std::vector<Matrix4D> models(static_cast<std::size_t>(draws));
+    for(int i = 0; i < draws; i++)
+    {
+        models[std::size_t(i)] = Matrix4D::translation({float(i % 50), 0.0f, float(i / 50)}) * Matrix4D::rotationY(float(i) * 0.1f);
+    }
+
+    /* CPU: MVP of every draw with the scalar and the SIMD product */
+    std::vector<Matrix4D> scalar(models.size()), simd(models.size());
+    const int rounds = 200;
+    auto start = std::chrono::steady_clock::now();
+    for(int r = 0; r < rounds; r++)
+    {
+        for(std::size_t i = 0; i < models.size(); i++)
+        {
+            scalar[i] = cameraViewProjection(camera) * models[i];
+        }
+    }
+    double scalarMs = elapsedMs(start) / rounds;
+    start = std::chrono::steady_clock::now();
+    for(int r = 0; r < rounds; r++)
+    {
+        for(std::size_t i = 0; i < models.size(); i++)
+        {
+            simd[i] = matrixMultiply(cameraViewProjection(camera), models[i]);
+        }
+    }
+    double simdMs = elapsedMs(start) / rounds;
+    float maxDifference = 0.0f;
+    for(std::size_t i = 0; i < models.size(); i++)
+    {
+        for(int c = 0; c < 16; c++)
+        {
+            maxDifference = std::max(maxDifference, std::fabs(scalar[i].ptr()[c] - simd[i].ptr()[c]));
+        }
+    }
+    std::printf("%d MVP products: scalar %.3f ms, SIMD %.3f ms (%.2fx), max difference %g\n", draws, scalarMs, simdMs,
+                scalarMs / simdMs, double(maxDifference));
+
+    /* GPU: vertex stage only */
+    std::vector<Vertex> vertices;
+    for(const Vector3D& position : grid::vertexPos)
+    {
+        vertices.push_back({position, {0.0f, 0.0f, 0.35f, 1.0f}});
+    }
+    Mesh gridMesh = meshCreate(vertices, grid::indices, GL_STATIC_DRAW, GL_STATIC_DRAW);
+
+    struct Variant { const char* name; const char* source; int madsPerVertex; };
+    /* multiply-adds per vertex: a mat4 * mat4 product is 64, a mat4 * vec4 product 16 */
+    const Variant variants[] = {{"proj*view*model (old)", chainedSource, 64 + 64 + 16 + 16},
+                                {"viewProj*(model*v)", worldSource, 16 + 16},
+                                {"mvp*v", mvpSource, 16}};
+
+    glStateEnable(GL_RASTERIZER_DISCARD);
+    std::printf("water grid: %zu vertices, %d draws per frame\n", grid::vertexPos.size(), draws);
+    std::printf("%24s %12s %14s %12s\n", "shader", "MAD/vertex", "MAD/grid", "frame ms");
+    for(const Variant& variant : variants)
+    {
+        ShaderProgram program = shaderCreate(variant.source, fragmentSource);
+        ShaderUniform<Matrix4D> model = shaderUniformHandle<Matrix4D>(program, "uModel", false);
+        ShaderUniform<Matrix4D> view = shaderUniformHandle<Matrix4D>(program, "uView", false);
+        ShaderUniform<Matrix4D> proj = shaderUniformHandle<Matrix4D>(program, "uProj", false);
+        ShaderUniform<Matrix4D> viewProj = shaderUniformHandle<Matrix4D>(program, "uViewProj", false);
+        ShaderUniform<Matrix4D> mvp = shaderUniformHandle<Matrix4D>(program, "uMVP", false);
+
+        glStateUseProgram(program.id);
+        glStateBindVertexArray(gridMesh.vao);
+        shaderUniform(view, cameraView(camera));
+        shaderUniform(proj, cameraProjection(camera));
+        shaderUniform(viewProj, cameraViewProjection(camera));
+
+        double best = 1e30;
+        for(int frame = 0; frame < frames; frame++)
+        {
+            glFinish();
+            start = std::chrono::steady_clock::now();
+            for(std::size_t i = 0; i < models.size(); i++)
+            {
+                shaderUniform(model, models[i]);
+                if(mvp.location >= 0)
+                {
+                    shaderUniform(mvp, matrixMultiply(cameraViewProjection(camera), models[i]));
+                }
+                meshDraw(gridMesh);
+            }
+            glFinish();
+            best = std::min(best, elapsedMs(start));
+        }
+        std::printf("%24s %12d %14zu %12.3f\n", variant.name, variant.madsPerVertex, variant.madsPerVertex * grid::vertexPos.size(), best);
+        shaderDelete(program);
+    }
+    glStateDisable(GL_RASTERIZER_DISCARD);
+    glCheckError();
+
+    meshDelete(gridMesh);
+    meshPoolRelease();
+    windowDelete(window);
+
+    return EXIT_SUCCESS;
+}
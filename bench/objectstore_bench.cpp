@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#include "mygl/objectstore.h"
+#include "timing.h"
+
+/* spin and transform systems over 1M objects with 1 to N threads, and add/remove churn with handle checks */
+
+int main(int argc, char** argv)
+{
+    std::size_t count = argc > 1 ? std::size_t(std::atoll(argv[1])) : 1000000;
+    unsigned int maxThreads = argc > 2 ? unsigned(std::atoi(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> threadCounts;
+    for(unsigned int threads = 1; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    /* the systems only read the bounds of the mesh, no GL context is needed */
+    Mesh mesh;
+    mesh.bounds.box = {Vector3D(-1.0f, -1.0f, -1.0f), Vector3D(1.0f, 1.0f, 1.0f)};
+
+    SceneGraph graph;
+    std::vector<SceneNode> nodes;
+    for(int i = 0; i < 64; i++)
+    {
+        nodes.push_back(sceneGraphAdd(graph, Matrix4D::translation({float(i), 0.0f, 0.0f})));
+    }
+    sceneGraphUpdate(graph);
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    ObjectStore store;
+    std::vector<ObjectHandle> handles;
+    for(std::size_t i = 0; i < count; i++)
+    {
+        float x = position(random);
+        float z = position(random);
+        handles.push_back(objectStoreAdd(store, &mesh, Matrix4D::translation({x, 0.0f, z}), nodes[i % nodes.size()], 1.0f));
+    }
+
+    std::printf("%zu objects\n", count);
+    double single = 0.0;
+    for(unsigned int threads : threadCounts)
+    {
+        JobScheduler* scheduler = jobSchedulerCreate(threads);
+        double time = bestOf(5, [&]()
+        {
+            objectStoreSpin(store, 1.0f, 1.0f, 0.01f, scheduler);
+            objectStoreUpdateTransforms(store, graph, scheduler);
+        });
+        if(threads == 1)
+        {
+            single = time;
+        }
+        std::printf("  %2u threads %9.3f ms (%.2fx)\n", threads, time, single / time);
+        jobSchedulerDelete(scheduler);
+    }
+
+    /* remove every other object and add them back, stale handles have to be rejected */
+    bool ok = true;
+    double churn = bestOf(3, [&]()
+    {
+        for(std::size_t i = 0; i < handles.size(); i += 2)
+        {
+            ObjectHandle old = handles[i];
+            ok = objectStoreRemove(store, old) && ok;
+            ok = objectStoreIndex(store, old) == OBJECTSTORE_INVALID && ok;
+            handles[i] = objectStoreAdd(store, &mesh, Matrix4D::identity());
+            ok = !objectStoreRemove(store, old) && ok;
+        }
+    });
+    for(ObjectHandle handle : handles)
+    {
+        ok = objectStoreIndex(store, handle) < objectStoreSize(store) && ok;
+    }
+    std::printf("  remove + add %zu objects %9.3f ms%s\n", handles.size() / 2, churn, ok ? "" : "  HANDLE MISMATCH");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
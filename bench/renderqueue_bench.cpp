@@ -0,0 +1,127 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "mygl/geometry.h"
+#include "mygl/glstate.h"
+#include "mygl/meshpool.h"
+#include "mygl/renderqueue.h"
+#include "timing.h"
+
+/* submits 100k draws per frame in random order and reports sort/issue times and the state changes left after sorting */
+
+const char* vertexSource = R"(#version 330 core
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec4 aColor;
+uniform mat4 uMVP;
+out vec4 tColor;
+void main(void)
+{
+    gl_Position = uMVP * vec4(aPosition, 1.0);
+    tColor = aColor;
+})";
+
+const char* fragmentSource = R"(#version 330 core
+in vec4 tColor;
+out vec4 FragColor;
+void main(void)
+{
+    FragColor = tColor;
+})";
+
+int main(int argc, char** argv)
+{
+    unsigned int itemCount = argc > 1 ? unsigned(std::atoi(argv[1])) : 100000;
+    const int frames = 10;
+
+    GLFWwindow* window = windowCreate("Render Queue Benchmark", 1280, 720);
+    if(!window) { return EXIT_FAILURE; }
+    glfwSwapInterval(0);
+    glStateEnable(GL_DEPTH_TEST);
+
+    /* 4 programs and meshes spread over pages with different buffer usage, i.e. different VAOs */
+    std::vector<ShaderProgram> programs;
+    for(int i = 0; i < 4; i++)
+    {
+        programs.push_back(shaderCreate(vertexSource, fragmentSource));
+    }
+    const GLenum usages[] = {GL_STATIC_DRAW, GL_DYNAMIC_DRAW, GL_STREAM_DRAW};
+    std::vector<Mesh> meshes;
+    for(int i = 0; i < 12; i++)
+    {
+        meshes.push_back(meshCreate(cube::vertices, cube::indices, usages[i % 3], GL_STATIC_DRAW));
+    }
+
+    Camera camera = cameraCreate(1280, 720, to_radians(45.0f), 0.01f, 500.0f, {0.0f, 50.0f, 200.0f});
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> pickProgram(0, int(programs.size()) - 1);
+    std::uniform_int_distribution<int> pickMesh(0, int(meshes.size()) - 1);
+    std::uniform_int_distribution<int> pickMaterial(0, 15);
+    std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+
+    struct Submission { int program, mesh, material; Matrix4D model; };
+    std::vector<Submission> submissions(itemCount);
+    for(Submission& s : submissions)
+    {
+        float x = position(random);
+        float y = position(random);
+        float z = position(random);
+        s = {pickProgram(random), pickMesh(random), pickMaterial(random), Matrix4D::translation({x, y, z})};
+    }
+
+    /* state changes an unsorted submission order would cause */
+    unsigned int naivePrograms = 0, naiveVaos = 0;
+    for(std::size_t i = 0; i < submissions.size(); i++)
+    {
+        naivePrograms += i == 0 || submissions[i].program != submissions[i - 1].program;
+        naiveVaos += i == 0 || meshes[submissions[i].mesh].vao != meshes[submissions[i - 1].mesh].vao;
+    }
+
+    RenderQueue queue;
+    double submitMs = 0.0, sortMs = 0.0, flushMs = 0.0;
+    for(int frame = 0; frame < frames; frame++)
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glStateResetStats();
+
+        auto start = std::chrono::steady_clock::now();
+        renderQueueBegin(queue, camera);
+        for(const Submission& s : submissions)
+        {
+            renderQueueSubmit(queue, programs[s.program], meshes[s.mesh], s.model, uint16_t(s.material));
+        }
+        submitMs += elapsedMs(start);
+
+        start = std::chrono::steady_clock::now();
+        renderQueueSort(queue);
+        sortMs += elapsedMs(start);
+
+        start = std::chrono::steady_clock::now();
+        renderQueueFlush(queue);
+        glFinish();
+        flushMs += elapsedMs(start);
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    glCheckError();
+
+    std::printf("items per frame:   %u\n", queue.stats.items);
+    std::printf("submit:            %.3f ms\n", submitMs / frames);
+    std::printf("radix sort:        %.3f ms\n", sortMs / frames);
+    std::printf("flush (GPU incl.): %.3f ms\n", flushMs / frames);
+    std::printf("draws:             %u\n", queue.stats.draws);
+    std::printf("program switches:  %u (unsorted %u)\n", queue.stats.programSwitches, naivePrograms);
+    std::printf("VAO switches:      %u (unsorted %u)\n", queue.stats.vaoSwitches, naiveVaos);
+    std::printf("GL state calls:    %llu issued, %llu elided, %llu mismatches\n", (unsigned long long) glStateStats().issued,
+                (unsigned long long) glStateStats().elided, (unsigned long long) glStateStats().mismatches);
+
+    for(ShaderProgram& program : programs) { shaderDelete(program); }
+    for(Mesh& mesh : meshes) { meshDelete(mesh); }
+    meshPoolRelease();
+    renderQueueRelease(queue);
+    windowDelete(window);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <stb_image/stb_image.h>
+
+#include "mygl/glstate.h"
+#include "mygl/screenshot.h"
+#include "timing.h"
+
+/*
+ * render thread time of frames taking a screenshot: screenshotToPNG (read back and encode right away) against the
+ * screenshot queue (readback into a pixel buffer, mapped after its fence, encoded on a worker). Frames are plain clears
+ * with a few scissored rectangles, so nearly all of the time is the screenshot. Both paths have to write the same image.
+ */
+
+void drawFrame(int frame, int width, int height)
+{
+    glStateDisable(GL_SCISSOR_TEST);
+    glClearColor(0.1f, 0.2f, float(frame % 16) / 16.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    /* rectangles make rows differ, so a wrong flip shows up in the comparison */
+    glStateEnable(GL_SCISSOR_TEST);
+    for(int i = 0; i < 8; i++)
+    {
+        glScissor((i * 97 + frame * 13) % width, (i * 61) % height, width / 6, height / (i + 3));
+        glClearColor(float(i) / 8.0f, float(frame % 7) / 7.0f, 0.5f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glStateDisable(GL_SCISSOR_TEST);
+}
+
+struct FrameTimes
+{
+    std::vector<double> screenshotMs;
+    double maxOtherMs = 0.0;
+};
+
+void printTimes(const char* name, FrameTimes& times)
+{
+    std::sort(times.screenshotMs.begin(), times.screenshotMs.end());
+    double sum = 0.0;
+    for(double ms : times.screenshotMs)
+    {
+        sum += ms;
+    }
+    std::printf("%-22s screenshot frames: mean %8.3f ms, max %8.3f ms | other frames max %6.3f ms\n", name,
+                sum / double(times.screenshotMs.size()), times.screenshotMs.back(), times.maxOtherMs);
+}
+
+int main(int argc, char** argv)
+{
+    const int width = argc > 2 ? std::atoi(argv[1]) : 1920;
+    const int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    const int frames = 120;
+    const int interval = 10;
+
+    GLFWwindow* window = windowCreate("Screenshot Benchmark", unsigned(width), unsigned(height));
+    if(!window) { return EXIT_FAILURE; }
+    glViewport(0, 0, width, height);
+    std::printf("%dx%d, %d frames, a screenshot every %d\n", width, height, frames, interval);
+
+    /* one screenshot every few frames, the frame time covers drawing, the screenshot and the swap on the render thread */
+    FrameTimes synchronous;
+    for(int frame = 0; frame < frames; frame++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        drawFrame(frame, width, height);
+        glfwSwapBuffers(window);
+        const bool take = frame % interval == interval - 1;
+        if(take)
+        {
+            screenshotToPNG("bench_screenshot_sync.png");
+        }
+        double ms = elapsedMs(start);
+        if(take) { synchronous.screenshotMs.push_back(ms); } else { synchronous.maxOtherMs = std::max(synchronous.maxOtherMs, ms); }
+    }
+
+    ScreenshotQueue* queue = screenshotQueueCreate();
+    FrameTimes asynchronous;
+    for(int frame = 0; frame < frames; frame++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        drawFrame(frame, width, height);
+        const bool take = frame % interval == interval - 1;
+        if(take)
+        {
+            screenshotRequest(queue, "bench_screenshot_async.png");
+        }
+        glfwSwapBuffers(window);
+        screenshotUpdate(queue);
+        double ms = elapsedMs(start);
+        if(take) { asynchronous.screenshotMs.push_back(ms); } else { asynchronous.maxOtherMs = std::max(asynchronous.maxOtherMs, ms); }
+    }
+    auto drainStart = std::chrono::steady_clock::now();
+    while(screenshotPending(queue))
+    {
+        screenshotUpdate(queue);
+    }
+    double drainMs = elapsedMs(drainStart);
+
+    printTimes("screenshotToPNG", synchronous);
+    printTimes("screenshot queue", asynchronous);
+    std::printf("queue: %llu written, %llu skipped (all slots busy), %.1f ms until the last one was written\n",
+                (unsigned long long) queue->written.load(), (unsigned long long) queue->skipped, drainMs);
+
+    /* one more frame through both paths, the files have to be the same */
+    drawFrame(frames, width, height);
+    screenshotRequest(queue, "bench_screenshot_async.png");
+    glfwSwapBuffers(window);
+    screenshotToPNG("bench_screenshot_sync.png");
+    screenshotQueueDelete(queue);
+
+    int w0, h0, c0, w1, h1, c1;
+    stbi_uc* a = stbi_load("bench_screenshot_sync.png", &w0, &h0, &c0, 4);
+    stbi_uc* b = stbi_load("bench_screenshot_async.png", &w1, &h1, &c1, 4);
+    const bool same = a && b && w0 == w1 && h0 == h1 && std::equal(a, a + std::size_t(w0) * h0 * 4, b);
+    std::printf("images %s\n", same ? "match" : "DIFFER");
+    stbi_image_free(a);
+    stbi_image_free(b);
+
+    windowDelete(window);
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,115 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "mygl/shader.h"
+#include "mygl/shadercache.h"
+
+/*
+ * startup cost of many program variants: compiled from source without cache, cold cache (compile + store) and warm
+ * cache (load binaries). Finally one binary is corrupted to check the fallback to compiling.
+ * Drivers with their own disk cache (Mesa) make the cold pass cheap on the second run, clear it for first run numbers.
+ */
+
+const char* vertexBody = R"(
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec4 aColor;
+uniform mat4 uMVP;
+out vec4 tColor;
+void main(void)
+{
+    vec4 position = uMVP * vec4(aPosition, 1.0);
+    for(int i = 0; i < VARIANT % 4; i++)
+    {
+        position.xy += sin(position.yx * float(i + VARIANT));
+    }
+    gl_Position = position;
+    tColor = aColor * float(VARIANT);
+})";
+
+const char* fragmentBody = R"(
+in vec4 tColor;
+out vec4 FragColor;
+void main(void)
+{
+    vec3 color = tColor.rgb;
+    for(int i = 0; i < 8; i++)
+    {
+        color = fract(color * 1.7 + vec3(VARIANT) * 0.01);
+    }
+    FragColor = vec4(color, tColor.a);
+})";
+
+/* the salt keeps the driver from serving a pass out of its own cache of the previous pass */
+std::string variantSource(const char* body, int variant, int salt)
+{
+    return "#version 330 core\n#define VARIANT " + std::to_string(variant) + "\n#define SALT " + std::to_string(salt) + "\n" + body;
+}
+
+double createAll(int variants, int salt)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < variants; i++)
+    {
+        shaderDelete(shaderCreate(variantSource(vertexBody, i, salt), variantSource(fragmentBody, i, salt)));
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    const int variants = argc > 1 ? std::atoi(argv[1]) : 64;
+    const std::string directory = "shadercache_bench";
+
+    GLFWwindow* window = windowCreate("Shader Cache Benchmark", 320, 240);
+    if(!window) { return EXIT_FAILURE; }
+
+    std::filesystem::remove_all(directory);
+    double uncached = createAll(variants, 0);
+
+    if(!shaderCacheEnable(directory))
+    {
+        std::printf("program binaries not supported, %d programs compiled in %.1f ms\n", variants, uncached);
+        windowDelete(window);
+        return EXIT_SUCCESS;
+    }
+
+    shaderCacheResetStats();
+    double cold = createAll(variants, 1);
+    ShaderCacheStats coldStats = shaderCacheStats();
+
+    shaderCacheResetStats();
+    double warm = createAll(variants, 1);
+    ShaderCacheStats warmStats = shaderCacheStats();
+
+    std::printf("%d programs\n", variants);
+    std::printf("no cache:   %8.1f ms\n", uncached);
+    std::printf("cold cache: %8.1f ms (%u compiled, %u stored)\n", cold, coldStats.misses, coldStats.stored);
+    std::printf("warm cache: %8.1f ms (%u loaded, %u compiled), %.1fx faster than compiling\n", warm, warmStats.hits,
+                warmStats.misses, uncached / warm);
+
+    /* a damaged binary has to be rejected and compiled again */
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.vcp",
+                  (unsigned long long) shaderCacheKey(variantSource(vertexBody, 0, 1), variantSource(fragmentBody, 0, 1)));
+    {
+        std::fstream file((std::filesystem::path(directory) / name).string(), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(std::streamoff(sizeof(ShaderCacheHeader) + 16));
+        file.write("garbage", 7);
+    }
+    shaderCacheResetStats();
+    ShaderProgram program = shaderCreate(variantSource(vertexBody, 0, 1), variantSource(fragmentBody, 0, 1));
+    const ShaderCacheStats& stats = shaderCacheStats();
+    bool ok = program.id != 0 && shaderUniformFind(program, "uMVP") != nullptr && stats.misses == 1;
+    std::printf("damaged binary: %u rejected, %u compiled, %s\n", stats.rejected, stats.misses, ok ? "program usable" : "FAILED");
+    shaderDelete(program);
+
+    shaderCacheDisable();
+    std::filesystem::remove_all(directory);
+    windowDelete(window);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
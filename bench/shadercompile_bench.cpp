@@ -0,0 +1,108 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "mygl/shader.h"
+#include "timing.h"
+
+/*
+ * creating many program variants one after another (each waits for the driver) against submitting all of them first and
+ * polling them afterwards, like a render loop drawing with the fallback program would. Only the second one lets a driver
+ * with KHR_parallel_shader_compile spread the work over its compiler threads.
+ * Run with MESA_SHADER_CACHE_DISABLE=true on Mesa, otherwise the second run is served from the driver's disk cache.
+ */
+
+const char* vertexBody = R"(
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec4 aColor;
+uniform mat4 uMVP;
+out vec4 tColor;
+void main(void)
+{
+    vec4 position = uMVP * vec4(aPosition, 1.0);
+    for(int i = 0; i < VARIANT % 4; i++)
+    {
+        position.xy += sin(position.yx * float(i + VARIANT));
+    }
+    gl_Position = position;
+    tColor = aColor * float(VARIANT);
+})";
+
+const char* fragmentBody = R"(
+in vec4 tColor;
+out vec4 FragColor;
+void main(void)
+{
+    vec3 color = tColor.rgb;
+    for(int i = 0; i < 8; i++)
+    {
+        color = fract(color * 1.7 + vec3(VARIANT) * 0.01);
+    }
+    FragColor = vec4(color, tColor.a);
+})";
+
+/* the salt keeps the driver from reusing the shaders of the other pass */
+std::string variantSource(const char* body, int variant, int salt)
+{
+    return "#version 330 core\n#define VARIANT " + std::to_string(variant) + "\n#define SALT " + std::to_string(salt) + "\n" + body;
+}
+
+int main(int argc, char** argv)
+{
+    const int variants = argc > 1 ? std::atoi(argv[1]) : 64;
+
+    GLFWwindow* window = windowCreate("Shader Compile Benchmark", 320, 240);
+    if(!window) { return EXIT_FAILURE; }
+
+    std::printf("KHR_parallel_shader_compile: %s\n", GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile ? "yes" : "no");
+
+    /* one after another */
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < variants; i++)
+    {
+        shaderDelete(shaderCreate(variantSource(vertexBody, i, 0), variantSource(fragmentBody, i, 0)));
+    }
+    double blocking = elapsedMs(start);
+
+    /* submit all, then poll until every program is ready, recording when the first one could be drawn */
+    start = std::chrono::steady_clock::now();
+    std::vector<ShaderProgram> programs;
+    for(int i = 0; i < variants; i++)
+    {
+        programs.push_back(shaderSubmit(variantSource(vertexBody, i, 1), variantSource(fragmentBody, i, 1)));
+    }
+    double submitted = elapsedMs(start);
+
+    double firstReady = -1.0;
+    int polls = 0, ready = 0;
+    while(ready < variants)
+    {
+        ready = 0;
+        for(ShaderProgram& program : programs)
+        {
+            ready += shaderPoll(program) ? 1 : 0;
+        }
+        if(ready > 0 && firstReady < 0.0)
+        {
+            firstReady = elapsedMs(start);
+        }
+        polls++;
+    }
+    double parallel = elapsedMs(start);
+
+    std::printf("%d programs\n", variants);
+    std::printf("create one by one:  %8.1f ms\n", blocking);
+    std::printf("submit all:         %8.1f ms submitting, first ready after %.1f ms\n", submitted, firstReady);
+    std::printf("                    %8.1f ms until all ready (%d polling rounds), %.2fx\n", parallel, polls, blocking / parallel);
+
+    for(ShaderProgram& program : programs)
+    {
+        shaderDelete(program);
+    }
+    glCheckError();
+    windowDelete(window);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+/* timing helpers shared by the benchmark programs */
+
+/* milliseconds since start */
+inline double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* fastest of runs calls of function in milliseconds, the other runs absorb cache and page faults */
+template<typename F>
+double bestOf(int runs, F&& function)
+{
+    double best = 1e30;
+    for(int i = 0; i < runs; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        best = std::min(best, elapsedMs(start));
+    }
+    return best;
+}
@@ -1,10 +1,25 @@
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 
 #include "mygl/shader.h"
+#include "mygl/shadercache.h"
+#include "mygl/shadervariant.h"
 #include "mygl/mesh.h"
+#include "mygl/meshpool.h"
+#include "mygl/glstate.h"
+#include "mygl/headless.h"
+#include "mygl/framepacing.h"
+#include "mygl/profiler.h"
+#include "mygl/screenshot.h"
+#include "mygl/capture.h"
+#include "mygl/renderqueue.h"
+#include "mygl/bvh.h"
+#include "mygl/scenegraph.h"
+#include "mygl/objectstore.h"
 #include "mygl/geometry.h"
 #include "mygl/camera.h"
+#include "mygl/uniformbuffer.h"
 #include "water.h"
 
 /* translation and color for the water plane */
@@ -24,24 +39,51 @@ const Matrix4D trans = Matrix4D::translation({0.0f, 4.0f, 0.0f});
 /* struct holding all necessary state variables for scene */
 struct
 {
+    /* seconds of simulated time, advanced by sceneUpdate */
+    float time = 0.0f;
+
     /* camera */
     Camera camera;
     float zoomSpeedMultiplier;
 
+    /* placement nodes the objects are attached to, world matrices are only recomputed when a local matrix changes */
+    SceneGraph sceneGraph;
+
+    /* all drawn objects as component arrays and the workers their systems run on */
+    ObjectStore objects;
+    JobScheduler* jobs;
+
     /* water */
     WaterSim waterSim;
     Water water;
-    Matrix4D waterModelMatrix;
+    ObjectHandle waterObject;
 
-    /* cube mesh and transformations */
+    /* cube mesh, positioned by the translation node, spun and scaled by its local matrix */
     Mesh cubeMesh;
-    Matrix4D cubeScalingMatrix;
-    Matrix4D cubeTranslationMatrix;
-    Matrix4D cubeTransformationMatrix;
-    float cubeSpinRadPerSecond;
-
-    /* shader */
-    ShaderProgram shaderColor;
+    SceneNode cubeTranslationNode;
+    ObjectHandle cubeObject;
+
+    /* variants of the default shader, each compiled on first use and drawn with the fallback until it is linked */
+    ShaderVariants shaders;
+    ShaderProgram* shaderColor = nullptr;
+    ShaderProgram shaderFallback;
+    UniformRing cameraUniforms;
+
+    /* draws of the current frame */
+    RenderQueue renderQueue;
+
+    /* hierarchy over the world space boxes of all objects (by dense index) and the ones that passed frustum culling */
+    BVH bvh;
+    std::vector<uint32_t> visibleObjects;
+    FrustumCullStats cullStats;
+
+    /* readbacks and PNG encoding of screenshots, off the render thread */
+    ScreenshotQueue* screenshots;
+
+    /* numbered frames for review, created on the first capture and kept until exit */
+    CaptureOptions captureOptions;
+    Capture* capture = nullptr;
+    bool capturing = false;
 } sScene;
 
 /* struct holding all state variables for input */
@@ -50,6 +92,7 @@ struct
     bool mouseLeftButtonPressed = false;
     Vector2D mousePressStart;
     bool buttonPressed[4] = {false, false, false, false};
+    bool screenshotRequested = false;
 } sInput;
 
 /* GLFW callback function for keyboard events */
@@ -63,10 +106,26 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
         glfwSetWindowShouldClose(window, true);
     }
 
-    /* make screenshot and save in work directory */
+    /* make screenshot and save in work directory, read back after the next frame is drawn */
     if(key == GLFW_KEY_P && action == GLFW_PRESS)
     {
-        screenshotToPNG("screenshot.png");
+        sInput.screenshotRequested = true;
+    }
+
+    /* record the next 120 frames as Chrome trace (open in chrome://tracing or ui.perfetto.dev) */
+    if(key == GLFW_KEY_T && action == GLFW_PRESS)
+    {
+        profilerCapture(120, "trace.json");
+    }
+
+    /* start and stop writing every frame to capture/, frames the encoders can't keep up with are dropped */
+    if(key == GLFW_KEY_C && action == GLFW_PRESS)
+    {
+        if(!sScene.capture)
+        {
+            sScene.capture = captureCreate(sScene.captureOptions);
+        }
+        sScene.capturing = !sScene.capturing;
     }
 
     /* input for cube control */
@@ -123,8 +182,7 @@ void mouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 void windowResizeCallback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
-    sScene.camera.width = width;
-    sScene.camera.height = height;
+    cameraResize(sScene.camera, width, height);
 }
 
 /* function to setup and initialize the whole scene */
@@ -138,23 +196,38 @@ void sceneInit(float width, float height)
     sScene.cubeMesh = meshCreate(cube::vertices, cube::indices, GL_STATIC_DRAW, GL_STATIC_DRAW);
     sScene.water = waterCreate(waterPlane::color);
 
-    /* setup transformation matrices for objects */
-    sScene.waterModelMatrix = waterPlane::trans;
+    /* setup placement nodes and objects with their transformations */
+    sceneGraphClear(sScene.sceneGraph);
+    sScene.cubeTranslationNode = sceneGraphAdd(sScene.sceneGraph, scaledCube::trans);
+    sceneGraphUpdate(sScene.sceneGraph);
+
+    sScene.jobs = jobSchedulerCreate();
+    objectStoreClear(sScene.objects);
+    sScene.waterObject = objectStoreAdd(sScene.objects, &sScene.water.mesh, waterPlane::trans);
+    sScene.cubeObject = objectStoreAdd(sScene.objects, &sScene.cubeMesh, scaledCube::scale, sScene.cubeTranslationNode, M_PI / 2.0f);
+    objectStoreUpdateTransforms(sScene.objects, sScene.sceneGraph, sScene.jobs);
 
-    sScene.cubeScalingMatrix = scaledCube::scale;
-    sScene.cubeTranslationMatrix = scaledCube::trans;
+    /* build the hierarchy over the world space boxes of the objects, has to be rebuilt when objects are added or removed */
+    sScene.bvh = bvhBuild(sScene.objects.bounds);
 
-    sScene.cubeTransformationMatrix = Matrix4D::identity();
+    /* the variant is submitted here and compiled in the background, linked binaries are reused on the next start */
+    shaderCacheEnable("shadercache");
+    sScene.shaderFallback = shaderCreateFallback();
+    sScene.shaders = shaderVariantsCreate("shader/default.vert", "shader/default.frag");
+    sScene.shaderColor = &shaderVariant(sScene.shaders, {});
 
-    sScene.cubeSpinRadPerSecond = M_PI / 2.0f;
+    /* camera data is written once per frame and shared by all programs */
+    sScene.cameraUniforms = uniformRingCreate(cameraBlockLayout(), SHADER_BINDING_CAMERA);
 
-    /* load shader from file */
-    sScene.shaderColor = shaderLoad("shader/default.vert", "shader/default.frag");
+    sScene.screenshots = screenshotQueueCreate();
 }
 
 /* function to move and update objects in scene (e.g., rotate cube according to user input) */
 void sceneUpdate(float dt)
 {
+    PROFILE_SCOPE("sceneUpdate");
+    sScene.time += dt;
+
     /* if 'w' or 's' pressed, cube should rotate around x axis */
     int rotationDirX = 0;
     if (sInput.buttonPressed[0]) {
@@ -171,96 +244,216 @@ void sceneUpdate(float dt)
         rotationDirY = 1;
     }
 
-    /* udpate cube transformation matrix to include new rotation if one of the keys was pressed */
-    if (rotationDirX != 0 || rotationDirY != 0) {
-        sScene.cubeTransformationMatrix = Matrix4D::rotationY(rotationDirY * sScene.cubeSpinRadPerSecond * dt) * Matrix4D::rotationX(rotationDirX * sScene.cubeSpinRadPerSecond * dt) * sScene.cubeTransformationMatrix;
+    /* spin all objects with a spin speed (the cube) if one of the keys was pressed */
+    objectStoreSpin(sScene.objects, rotationDirX, rotationDirY, dt, sScene.jobs);
+
+    /* recompute the world matrices of changed nodes and objects and refit their boxes in the hierarchy */
+    sceneGraphUpdate(sScene.sceneGraph);
+    if (rotationDirX != 0 || rotationDirY != 0 || sScene.sceneGraph.stats.recomputed > 0) {
+        objectStoreUpdateTransforms(sScene.objects, sScene.sceneGraph, sScene.jobs);
+        bvhRefit(sScene.bvh, sScene.objects.bounds);
     }
 }
 
 /* function to draw all objects in the scene */
 void sceneDraw()
 {
+    PROFILE_SCOPE("sceneDraw");
+    PROFILE_GPU_SCOPE("sceneDraw");
+
     /* clear framebuffer color */
     glClearColor(135.0 / 255, 206.0 / 255, 235.0 / 255, 1.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    /* count issued and skipped GL state calls of this frame */
+    glStateResetStats();
+
     /*------------ render scene -------------*/
-    /* use shader and set the uniforms (names match the ones in the shader) */
+    /* upload the camera block once for all programs, its matrices are cached in the camera */
+    CameraBlock cameraData = cameraBlock(sScene.camera, sScene.time);
+    uniformRingWrite(sScene.cameraUniforms, &cameraData);
+
+    /* cull the hierarchy of world space boxes against the view frustum */
+    sScene.cullStats = FrustumCullStats();
+    Frustum frustum = frustumExtract(cameraData.viewProj);
+    bvhQueryFrustum(sScene.bvh, frustum, sScene.visibleObjects, &sScene.cullStats);
+
+    /* draw with the fallback while the driver is still compiling */
+    const ShaderProgram& shader = shaderSelect(*sScene.shaderColor, sScene.shaderFallback);
+
+    /* only visible objects are submitted, the queue sorts them and sets program, VAO and the per-draw uMVP uniform */
+    renderQueueBegin(sScene.renderQueue, sScene.camera);
+    for(uint32_t i : sScene.visibleObjects)
     {
-        glUseProgram(sScene.shaderColor.id);
-        shaderUniform(sScene.shaderColor, "uProj",  cameraProjection(sScene.camera));
-        shaderUniform(sScene.shaderColor, "uView",  cameraView(sScene.camera));
-
-        /* draw water plane */
-        shaderUniform(sScene.shaderColor, "uModel", sScene.waterModelMatrix);
-        glBindVertexArray(sScene.water.mesh.vao);
-        glDrawElements(GL_TRIANGLES, sScene.water.mesh.size_ibo, GL_UNSIGNED_INT, nullptr);
-
-        /* draw cube, requires to calculate the final model matrix from all transformations */
-        shaderUniform(sScene.shaderColor, "uModel", sScene.cubeTranslationMatrix * sScene.cubeTransformationMatrix * sScene.cubeScalingMatrix);
-        glBindVertexArray(sScene.cubeMesh.vao);
-        glDrawElements(GL_TRIANGLES, sScene.cubeMesh.size_ibo, GL_UNSIGNED_INT, nullptr);
+        renderQueueSubmit(sScene.renderQueue, shader, *sScene.objects.mesh[i], sScene.objects.world[i]);
     }
+
+    renderQueueFlush(sScene.renderQueue);
     glCheckError();
 
-    /* cleanup opengl state */
-    glBindVertexArray(0);
-    glUseProgram(0);
+    /* program and VAO stay bound, the state cache skips rebinding them next frame */
 }
 
 int main(int argc, char** argv)
 {
+    /* --frames N --size WxH renders N frames offscreen and writes a timing report, see headless.h */
+    HeadlessOptions headlessOptions = headlessParseArgs(argc, argv);
+
+    /* --pacing vsync|uncapped|fps|fixed, --fps N, --dt S select how frames are paced and stepped, see framepacing.h */
+    FramePacingOptions pacingOptions = framePacingParseArgs(argc, argv);
+
+    /*
+     * --trace N records the first N frames as Chrome trace, T does the same for the next 120 frames. --capture png|qoi|raw
+     * writes every frame to capture/, C starts and stops that in the window.
+     */
+    profilerThreadName("main");
+    for(int i = 1; i + 1 < argc; i++)
+    {
+        if(std::string(argv[i]) == "--trace")
+        {
+            profilerCapture(unsigned(std::max(1, std::atoi(argv[i + 1]))), "trace.json");
+        }
+        if(std::string(argv[i]) == "--capture" && captureParseFormat(argv[i + 1], &sScene.captureOptions.format))
+        {
+            sScene.capturing = true;
+        }
+    }
+
     /* create window/context */
     int width = 1280;
     int height = 720;
-    GLFWwindow* window = windowCreate("Assignment 1 - Transformations, User Input and Camera", width, height);
-    if(!window) { return EXIT_FAILURE; }
-
-    /* set window callbacks */
-    glfwSetKeyCallback(window, keyCallback);
-    glfwSetCursorPosCallback(window, mousePosCallback);
-    glfwSetMouseButtonCallback(window, mouseButtonCallback);
-    glfwSetScrollCallback(window, mouseScrollCallback);
-    glfwSetFramebufferSizeCallback(window, windowResizeCallback);
+    GLFWwindow* window = nullptr;
+    Headless* headless = nullptr;
+    if(headlessOptions.enabled)
+    {
+        width = int(headlessOptions.width);
+        height = int(headlessOptions.height);
+        headless = headlessCreate(headlessOptions.width, headlessOptions.height);
+        if(!headless) { return EXIT_FAILURE; }
+    }
+    else
+    {
+        window = windowCreate("Assignment 1 - Transformations, User Input and Camera", width, height);
+        if(!window) { return EXIT_FAILURE; }
+
+        /* set window callbacks */
+        glfwSetKeyCallback(window, keyCallback);
+        glfwSetCursorPosCallback(window, mousePosCallback);
+        glfwSetMouseButtonCallback(window, mouseButtonCallback);
+        glfwSetScrollCallback(window, mouseScrollCallback);
+        glfwSetFramebufferSizeCallback(window, windowResizeCallback);
+    }
 
 
     /*---------- init opengl stuff ------------*/
-    glEnable(GL_DEPTH_TEST);
+    glStateEnable(GL_DEPTH_TEST);
 
     /* setup scene */
     sceneInit(width, height);
 
-    /*-------------- main loop ----------------*/
-    double timeStamp = glfwGetTime();
-    double timeStampNew = 0.0;
-
-    /* loop until user closes window */
-    while(!glfwWindowShouldClose(window))
+    /* headless runs are for regression review, so they wait for the encoders instead of dropping frames */
+    if(sScene.capturing)
     {
-        /* poll and process input and window events */
-        glfwPollEvents();
-
-        /* update model matrix of cube */
-        timeStampNew = glfwGetTime();
-        sceneUpdate(timeStampNew - timeStamp);
-        timeStamp = timeStampNew;
-
-        /* draw all objects in the scene */
-        sceneDraw();
+        if(headless)
+        {
+            sScene.captureOptions.backpressure = CaptureBackpressure::Block;
+        }
+        sScene.capture = captureCreate(sScene.captureOptions);
+    }
 
-        /* swap front and back buffer */
-        glfwSwapBuffers(window);
+    /*-------------- main loop ----------------*/
+    if(headless)
+    {
+        /* fixed time step (--dt), so that every run renders the same frames */
+        for(unsigned int frame = 0; frame < headlessOptions.frames; frame++)
+        {
+            headlessBeginFrame(*headless);
+            sceneUpdate(float(pacingOptions.fixedDt));
+            sceneDraw();
+            if(sScene.capturing)
+            {
+                captureFrame(sScene.capture);
+            }
+            headlessEndFrame(*headless);
+            profilerFrameEnd();
+        }
+
+        if(headlessWriteReport(*headless, headlessOptions.report, "assignment_1"))
+        {
+            std::cout << "[Headless] " << headlessOptions.frames << " frames (" << headless->backend << "), report written to "
+                      << headlessOptions.report << std::endl;
+        }
+    }
+    else
+    {
+        FramePacer pacer = framePacerCreate(pacingOptions);
+
+        /* loop until user closes window */
+        while(!glfwWindowShouldClose(window))
+        {
+            /* poll and process input and window events */
+            glfwPollEvents();
+
+            /* update model matrix of cube, by the smoothed frame time or the fixed step */
+            sceneUpdate(framePacerBeginFrame(pacer));
+
+            /* draw all objects in the scene */
+            sceneDraw();
+
+            /* the back buffer holds the finished frame until the swap */
+            if(sInput.screenshotRequested)
+            {
+                screenshotRequest(sScene.screenshots, "screenshot.png");
+                sInput.screenshotRequested = false;
+            }
+            if(sScene.capturing)
+            {
+                captureFrame(sScene.capture);
+            }
+            else if(sScene.capture)
+            {
+                captureUpdate(sScene.capture);
+            }
+
+            /* swap front and back buffer */
+            glfwSwapBuffers(window);
+            screenshotUpdate(sScene.screenshots);
+            profilerFrameEnd();
+
+            /* wait for the next deadline in the paced modes */
+            framePacerEndFrame(pacer);
+        }
+
+        framePacerPrintStats(pacer);
     }
 
 
     /*-------- cleanup --------*/
     /* delete opengl shader and buffers */
-    shaderDelete(sScene.shaderColor);
+    shaderVariantsDelete(sScene.shaders);
+    shaderDelete(sScene.shaderFallback);
+    uniformRingDelete(sScene.cameraUniforms);
     waterDelete(sScene.water);
     meshDelete(sScene.cubeMesh);
+    meshPoolRelease();
+    renderQueueRelease(sScene.renderQueue);
+    screenshotQueueDelete(sScene.screenshots);
+    if(sScene.capture)
+    {
+        captureDelete(sScene.capture);
+    }
+    profilerRelease();
+    jobSchedulerDelete(sScene.jobs);
 
     /* cleanup glfw/glcontext */
-    windowDelete(window);
+    if(headless)
+    {
+        headlessDelete(headless);
+    }
+    else
+    {
+        windowDelete(window);
+    }
 
     return EXIT_SUCCESS;
 }
@@ -1,4 +1,5 @@
 #include "base.h"
+#include "screenshot.h"
 
 #include <iostream>
 #include <sstream>
@@ -41,12 +42,14 @@ void screenshotToPNG(const std::string &filepath)
     int nPixels = width * height;
 
     std::vector<GLubyte> data(4 * nPixels);
+    std::vector<GLubyte> flipped(4 * nPixels);
 
     glReadBuffer(GL_FRONT);
     glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
 
-    stbi_flip_vertically_on_write(true);
-    stbi_write_png(filepath.c_str(), width, height, 4, data.data(), width * 4);
+    /* GL rows start at the bottom; flipped here instead of through stb's flag, which is global and not thread safe */
+    screenshotFlipRows(data.data(), flipped.data(), std::size_t(width) * 4, unsigned(height));
+    stbi_write_png(filepath.c_str(), width, height, 4, flipped.data(), width * 4);
 }
 
 void glfw_error_callback(int error, const char* description)
@@ -36,7 +36,8 @@ GLFWwindow* windowCreate(const std::string &title, unsigned int width, unsigned
 void windowDelete(GLFWwindow* window);
 
 /**
- * @brief Save current viewport as PNG image.
+ * @brief Save current viewport as PNG image. Waits for the GPU and encodes on the calling thread, screenshot.h does
+ * both without stalling the render loop.
  *
  * @param filepath Path to output image.
  */
@@ -0,0 +1,202 @@
+#include "bounds.h"
+#include "mesh.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace detail
+{
+    float maxAxisScale(const Matrix4D& M)
+    {
+        float sx = M(0,0) * M(0,0) + M(1,0) * M(1,0) + M(2,0) * M(2,0);
+        float sy = M(0,1) * M(0,1) + M(1,1) * M(1,1) + M(2,1) * M(2,1);
+        float sz = M(0,2) * M(0,2) + M(1,2) * M(1,2) + M(2,2) * M(2,2);
+        return std::sqrt(std::max(sx, std::max(sy, sz)));
+    }
+
+#ifdef MYGL_SSE
+    inline Vector3D toVector3D(__m128 v)
+    {
+        alignas(16) float f[4];
+        _mm_store_ps(f, v);
+        return Vector3D(f[0], f[1], f[2]);
+    }
+
+    /* loads pos.xyz and color.r of a vertex, the last lane is ignored */
+    inline __m128 loadPosition(const Vertex& v)
+    {
+        return _mm_loadu_ps(&v.pos.x);
+    }
+#endif
+}
+
+Bounds boundsCompute(const Vertex* vertices, std::size_t count)
+{
+    Bounds bounds;
+    if(count == 0)
+    {
+        return bounds;
+    }
+
+#ifdef MYGL_SSE
+    /* min/max reduction with two independent accumulators to hide latency */
+    __m128 min0 = detail::loadPosition(vertices[0]), max0 = min0;
+    __m128 min1 = min0, max1 = min0;
+
+    std::size_t i = 1;
+    for(; i + 1 < count; i += 2)
+    {
+        __m128 a = detail::loadPosition(vertices[i]);
+        __m128 b = detail::loadPosition(vertices[i + 1]);
+        min0 = _mm_min_ps(min0, a);
+        max0 = _mm_max_ps(max0, a);
+        min1 = _mm_min_ps(min1, b);
+        max1 = _mm_max_ps(max1, b);
+    }
+    for(; i < count; i++)
+    {
+        __m128 a = detail::loadPosition(vertices[i]);
+        min0 = _mm_min_ps(min0, a);
+        max0 = _mm_max_ps(max0, a);
+    }
+    min0 = _mm_min_ps(min0, min1);
+    max0 = _mm_max_ps(max0, max1);
+
+    bounds.box.min = detail::toVector3D(min0);
+    bounds.box.max = detail::toVector3D(max0);
+    bounds.sphere.center = (bounds.box.min + bounds.box.max) * 0.5f;
+
+    /* farthest vertex from the center, four vertices per iteration in SoA form */
+    const __m128 cx = _mm_set1_ps(bounds.sphere.center.x);
+    const __m128 cy = _mm_set1_ps(bounds.sphere.center.y);
+    const __m128 cz = _mm_set1_ps(bounds.sphere.center.z);
+    __m128 maxDist = _mm_setzero_ps();
+
+    i = 0;
+    for(; i + 3 < count; i += 4)
+    {
+        __m128 x = detail::loadPosition(vertices[i]);
+        __m128 y = detail::loadPosition(vertices[i + 1]);
+        __m128 z = detail::loadPosition(vertices[i + 2]);
+        __m128 w = detail::loadPosition(vertices[i + 3]);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        __m128 dx = _mm_sub_ps(x, cx);
+        __m128 dy = _mm_sub_ps(y, cy);
+        __m128 dz = _mm_sub_ps(z, cz);
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        maxDist = _mm_max_ps(maxDist, dist);
+    }
+
+    alignas(16) float dist[4];
+    _mm_store_ps(dist, maxDist);
+    float radius2 = std::max(std::max(dist[0], dist[1]), std::max(dist[2], dist[3]));
+#else
+    bounds.box.min = bounds.box.max = vertices[0].pos;
+    for(std::size_t i = 1; i < count; i++)
+    {
+        for(unsigned int c = 0; c < 3; c++)
+        {
+            bounds.box.min[c] = std::min(bounds.box.min[c], vertices[i].pos[c]);
+            bounds.box.max[c] = std::max(bounds.box.max[c], vertices[i].pos[c]);
+        }
+    }
+    bounds.sphere.center = (bounds.box.min + bounds.box.max) * 0.5f;
+
+    float radius2 = 0.0f;
+    std::size_t i = 0;
+#endif
+
+    for(; i < count; i++)
+    {
+        Vector3D d = vertices[i].pos - bounds.sphere.center;
+        radius2 = std::max(radius2, dot(d, d));
+    }
+    bounds.sphere.radius = std::sqrt(radius2);
+
+    return bounds;
+}
+
+Bounds boundsFromBox(const AABB& box)
+{
+    Bounds bounds;
+    bounds.box = box;
+    bounds.sphere.center = (box.min + box.max) * 0.5f;
+    bounds.sphere.radius = length(box.max - box.min) * 0.5f;
+    return bounds;
+}
+
+AABB aabbTransform(const AABB& box, const Matrix4D& M)
+{
+    /* J. Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990 */
+    AABB result;
+    result.min = result.max = Vector3D(M(0,3), M(1,3), M(2,3));
+
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            float a = M(i,j) * box.min[j];
+            float b = M(i,j) * box.max[j];
+            result.min[i] += std::min(a, b);
+            result.max[i] += std::max(a, b);
+        }
+    }
+    return result;
+}
+
+BoundingSphere sphereTransform(const BoundingSphere& sphere, const Matrix4D& M)
+{
+    return BoundingSphere{Vector3D(M * Vector4D(sphere.center, 1.0f)), sphere.radius * detail::maxAxisScale(M)};
+}
+
+void boundsTransform(const Bounds* local, const Matrix4D* models, Bounds* world, std::size_t count)
+{
+#ifdef MYGL_SSE
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    for(std::size_t i = 0; i < count; i++)
+    {
+        const Matrix4D& M = models[i];
+        const Bounds& b = local[i];
+
+        __m128 c0 = _mm_loadu_ps(M.n[0]);
+        __m128 c1 = _mm_loadu_ps(M.n[1]);
+        __m128 c2 = _mm_loadu_ps(M.n[2]);
+        __m128 c3 = _mm_loadu_ps(M.n[3]);
+
+        __m128 bmin = _mm_setr_ps(b.box.min.x, b.box.min.y, b.box.min.z, 0.0f);
+        __m128 bmax = _mm_setr_ps(b.box.max.x, b.box.max.y, b.box.max.z, 0.0f);
+        __m128 center = _mm_mul_ps(_mm_add_ps(bmin, bmax), half);
+        __m128 extent = _mm_mul_ps(_mm_sub_ps(bmax, bmin), half);
+
+        /* center is transformed as a point, extent by the absolute values of the linear part */
+        __m128 wc = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_shuffle_ps(center, center, _MM_SHUFFLE(0,0,0,0))),
+                                          _mm_mul_ps(c1, _mm_shuffle_ps(center, center, _MM_SHUFFLE(1,1,1,1)))),
+                               _mm_add_ps(_mm_mul_ps(c2, _mm_shuffle_ps(center, center, _MM_SHUFFLE(2,2,2,2))), c3));
+        __m128 we = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(c0, absMask), _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(0,0,0,0))),
+                                          _mm_mul_ps(_mm_and_ps(c1, absMask), _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(1,1,1,1)))),
+                               _mm_mul_ps(_mm_and_ps(c2, absMask), _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(2,2,2,2))));
+
+        __m128 sc = _mm_setr_ps(b.sphere.center.x, b.sphere.center.y, b.sphere.center.z, 1.0f);
+        __m128 ws = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_shuffle_ps(sc, sc, _MM_SHUFFLE(0,0,0,0))),
+                                          _mm_mul_ps(c1, _mm_shuffle_ps(sc, sc, _MM_SHUFFLE(1,1,1,1)))),
+                               _mm_add_ps(_mm_mul_ps(c2, _mm_shuffle_ps(sc, sc, _MM_SHUFFLE(2,2,2,2))), c3));
+        float radius = b.sphere.radius * detail::maxAxisScale(M);
+
+        world[i].box.min = detail::toVector3D(_mm_sub_ps(wc, we));
+        world[i].box.max = detail::toVector3D(_mm_add_ps(wc, we));
+        world[i].sphere.center = detail::toVector3D(ws);
+        world[i].sphere.radius = radius;
+    }
+#else
+    for(std::size_t i = 0; i < count; i++)
+    {
+        Bounds b = local[i];
+        world[i].box = aabbTransform(b.box, models[i]);
+        world[i].sphere = sphereTransform(b.sphere, models[i]);
+    }
+#endif
+}
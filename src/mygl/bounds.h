@@ -0,0 +1,77 @@
+#pragma once
+
+#include "base.h"
+
+#include <cstddef>
+
+struct Vertex;
+
+struct AABB
+{
+    Vector3D min;
+    Vector3D max;
+};
+
+struct BoundingSphere
+{
+    Vector3D center;
+    float radius = 0.0f;
+};
+
+struct Bounds
+{
+    AABB box;
+    BoundingSphere sphere;
+};
+
+/**
+ * @brief Compute the axis aligned bounding box and a bounding sphere of the vertex positions. The sphere is centered at
+ * the box center with the distance to the farthest vertex as radius. Both passes use SIMD min/max reductions.
+ *
+ * @param vertices Pointer to vertex data.
+ * @param count Number of vertices.
+ *
+ * @return Bounds in the coordinate system of the vertices (model space).
+ */
+Bounds boundsCompute(const Vertex* vertices, std::size_t count);
+
+/**
+ * @brief Bounds from a stored box without the vertices. The sphere encloses the box (center and half diagonal), so it is
+ * looser than the one of boundsCompute(...).
+ *
+ * @param box Box in model space.
+ *
+ * @return Bounds with the box and a sphere around it.
+ */
+Bounds boundsFromBox(const AABB& box);
+
+/**
+ * @brief Transform an axis aligned bounding box and return the axis aligned box enclosing the result (Arvo's method).
+ *
+ * @param box Box in model space.
+ * @param model Affine model matrix.
+ *
+ * @return Box in world space.
+ */
+AABB aabbTransform(const AABB& box, const Matrix4D& model);
+
+/**
+ * @brief Transform a bounding sphere, the radius is scaled by the largest axis scale of the matrix.
+ *
+ * @param sphere Sphere in model space.
+ * @param model Affine model matrix.
+ *
+ * @return Sphere in world space.
+ */
+BoundingSphere sphereTransform(const BoundingSphere& sphere, const Matrix4D& model);
+
+/**
+ * @brief Transform many bounds at once, e.g. all object instances of a frame. Boxes are transformed in center/extent
+ * form, which gives the same result as Arvo's method with four-wide SIMD operations per box.
+ *
+ * @param local Bounds in model space.
+ * @param models Model matrix of each bounds.
+ * @param world Receives the bounds in world space, may alias local.
+ * @param count Number of bounds.
+ */
+void boundsTransform(const Bounds* local, const Matrix4D* models, Bounds* world, std::size_t count);
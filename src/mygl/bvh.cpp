@@ -0,0 +1,488 @@
+#include "bvh.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace detail
+{
+    constexpr unsigned int BVH_BINS = 16;
+    constexpr uint32_t BVH_NO_PARENT = ~0u;
+
+    /* the Vector3D operators are not inlined, the build and traversal loops work on the components directly */
+    inline float bvhComponent(const Vector3D& v, unsigned int axis)
+    {
+        return (&v.x)[axis];
+    }
+
+    const AABB bvhEmptyBox = {Vector3D(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()),
+                              Vector3D(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max())};
+
+    inline void aabbGrow(AABB& box, const AABB& other)
+    {
+        box.min.x = std::min(box.min.x, other.min.x);
+        box.min.y = std::min(box.min.y, other.min.y);
+        box.min.z = std::min(box.min.z, other.min.z);
+        box.max.x = std::max(box.max.x, other.max.x);
+        box.max.y = std::max(box.max.y, other.max.y);
+        box.max.z = std::max(box.max.z, other.max.z);
+    }
+
+    inline float aabbHalfArea(const AABB& box)
+    {
+        float dx = box.max.x - box.min.x, dy = box.max.y - box.min.y, dz = box.max.z - box.min.z;
+        return dx < 0.0f ? 0.0f : dx * dy + dy * dz + dz * dx;
+    }
+
+    bool aabbEqual(const AABB& a, const AABB& b)
+    {
+        return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z
+            && a.max.x == b.max.x && a.max.y == b.max.y && a.max.z == b.max.z;
+    }
+
+    struct BVHBuilder
+    {
+        BVH& bvh;
+        const BVHBuildOptions& options;
+        std::vector<float> centroids;
+        std::atomic<uint32_t> nodeCount{1};
+
+        ThreadPool* pool = nullptr;
+        std::atomic<unsigned int> pendingTasks{0};
+        std::mutex mutex;
+        std::condition_variable tasksDone;
+    };
+
+    void bvhBuildNode(BVHBuilder& builder, uint32_t nodeIndex, uint32_t first, uint32_t count);
+
+    void bvhSpawnNode(BVHBuilder& builder, uint32_t nodeIndex, uint32_t first, uint32_t count)
+    {
+        builder.pendingTasks++;
+        threadPoolSubmit(builder.pool, [&builder, nodeIndex, first, count]()
+        {
+            bvhBuildNode(builder, nodeIndex, first, count);
+
+            /* decrement under the lock, bvhBuild(...) may return and destroy the builder as soon as it reads zero */
+            std::lock_guard<std::mutex> lock(builder.mutex);
+            if(--builder.pendingTasks == 0)
+            {
+                builder.tasksDone.notify_all();
+            }
+        });
+    }
+
+    void bvhBuildNode(BVHBuilder& builder, uint32_t nodeIndex, uint32_t first, uint32_t count)
+    {
+        BVH& bvh = builder.bvh;
+        uint32_t* objects = bvh.objects.data();
+
+        const float* centroids = builder.centroids.data();
+
+        AABB box = bvhEmptyBox;
+        float centroidMin[3], centroidMax[3];
+        for(unsigned int axis = 0; axis < 3; axis++)
+        {
+            centroidMin[axis] = std::numeric_limits<float>::max();
+            centroidMax[axis] = -std::numeric_limits<float>::max();
+        }
+        for(uint32_t i = first; i < first + count; i++)
+        {
+            aabbGrow(box, bvh.boxes[objects[i]]);
+            for(unsigned int axis = 0; axis < 3; axis++)
+            {
+                centroidMin[axis] = std::min(centroidMin[axis], centroids[3 * objects[i] + axis]);
+                centroidMax[axis] = std::max(centroidMax[axis], centroids[3 * objects[i] + axis]);
+            }
+        }
+
+        BVHNode& node = bvh.nodes[nodeIndex];
+        node.box = box;
+        node.first = first;
+        node.count = count;
+        node.left = 0;
+        if(count <= builder.options.maxLeafSize)
+        {
+            return;
+        }
+
+        /* binned SAH: objects are sorted into bins by centroid, every bin boundary of every axis is a split candidate */
+        float scales[3];
+        AABB binBoxes[3][BVH_BINS];
+        uint32_t binCounts[3][BVH_BINS] = {};
+        for(unsigned int axis = 0; axis < 3; axis++)
+        {
+            float extent = centroidMax[axis] - centroidMin[axis];
+            scales[axis] = extent > 0.0f ? float(BVH_BINS) / extent : 0.0f;
+            std::fill(binBoxes[axis], binBoxes[axis] + BVH_BINS, bvhEmptyBox);
+        }
+        for(uint32_t i = first; i < first + count; i++)
+        {
+            const AABB& objectBox = bvh.boxes[objects[i]];
+            for(unsigned int axis = 0; axis < 3; axis++)
+            {
+                unsigned int bin = std::min(BVH_BINS - 1, unsigned((centroids[3 * objects[i] + axis] - centroidMin[axis]) * scales[axis]));
+                binCounts[axis][bin]++;
+                aabbGrow(binBoxes[axis][bin], objectBox);
+            }
+        }
+
+        float bestCost = std::numeric_limits<float>::max();
+        int bestAxis = -1;
+        unsigned int bestSplit = 0;
+        for(unsigned int axis = 0; axis < 3; axis++)
+        {
+            if(scales[axis] == 0.0f)
+            {
+                continue;
+            }
+
+            /* sweep from the right to get the cost of everything right of each boundary */
+            float rightCosts[BVH_BINS];
+            AABB right = bvhEmptyBox;
+            uint32_t rightCount = 0;
+            for(unsigned int b = BVH_BINS - 1; b > 0; b--)
+            {
+                aabbGrow(right, binBoxes[axis][b]);
+                rightCount += binCounts[axis][b];
+                rightCosts[b] = rightCount ? aabbHalfArea(right) * float(rightCount) : 0.0f;
+            }
+
+            AABB left = bvhEmptyBox;
+            uint32_t leftCount = 0;
+            for(unsigned int b = 1; b < BVH_BINS; b++)
+            {
+                aabbGrow(left, binBoxes[axis][b - 1]);
+                leftCount += binCounts[axis][b - 1];
+                if(leftCount == 0 || leftCount == count)
+                {
+                    continue;
+                }
+                float cost = aabbHalfArea(left) * float(leftCount) + rightCosts[b];
+                if(cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = int(axis);
+                    bestSplit = b;
+                }
+            }
+        }
+
+        uint32_t middle;
+        if(bestAxis >= 0)
+        {
+            float scale = scales[bestAxis], minimum = centroidMin[bestAxis];
+            uint32_t* split = std::partition(objects + first, objects + first + count, [&](uint32_t object)
+            {
+                return std::min(BVH_BINS - 1, unsigned((centroids[3 * object + bestAxis] - minimum) * scale)) < bestSplit;
+            });
+            middle = uint32_t(split - objects);
+        }
+        else
+        {
+            /* all centroids coincide, split by count */
+            middle = first + count / 2;
+        }
+
+        uint32_t left = builder.nodeCount.fetch_add(2);
+        node.left = left;
+        bvh.parents[left] = bvh.parents[left + 1] = nodeIndex;
+
+        if(builder.pool && count > builder.options.parallelThreshold)
+        {
+            bvhSpawnNode(builder, left + 1, middle, first + count - middle);
+        }
+        else
+        {
+            bvhBuildNode(builder, left + 1, middle, first + count - middle);
+        }
+        bvhBuildNode(builder, left, first, middle - first);
+    }
+
+    void bvhRefitNode(BVH& bvh, BVHNode& node)
+    {
+        if(node.left == 0)
+        {
+            node.box = bvhEmptyBox;
+            for(uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                aabbGrow(node.box, bvh.boxes[bvh.objects[i]]);
+            }
+        }
+        else
+        {
+            node.box = bvh.nodes[node.left].box;
+            aabbGrow(node.box, bvh.nodes[node.left + 1].box);
+        }
+    }
+
+    /* distance along the ray to the box entry, negative if the box is missed */
+    inline float bvhRayBox(const AABB& box, const Vector3D& origin, const Vector3D& inverseDirection, float maxDistance)
+    {
+        float tMin = 0.0f, tMax = maxDistance;
+        for(unsigned int c = 0; c < 3; c++)
+        {
+            float t0 = (bvhComponent(box.min, c) - bvhComponent(origin, c)) * bvhComponent(inverseDirection, c);
+            float t1 = (bvhComponent(box.max, c) - bvhComponent(origin, c)) * bvhComponent(inverseDirection, c);
+            /*
+             * 0 * inf is NaN for an origin on a slab plane and a direction component that is 0 (its inverse is inf) or so
+             * small that its inverse overflows. The ray then runs along that plane and touches the slab, so it does not
+             * limit the interval. Without the test std::min/std::max would return the NaN or the other value depending on the
+             * argument order, and a hit on the max plane would be a miss on the min plane.
+             */
+            if(std::isnan(t0) || std::isnan(t1))
+            {
+                continue;
+            }
+            tMin = std::max(tMin, std::min(t0, t1));
+            tMax = std::min(tMax, std::max(t0, t1));
+        }
+        return tMin <= tMax ? tMin : -1.0f;
+    }
+}
+
+BVH bvhBuild(const std::vector<AABB>& boxes, const BVHBuildOptions& options)
+{
+    BVH bvh;
+    const uint32_t count = uint32_t(boxes.size());
+    bvh.boxes = boxes;
+    bvh.objects.resize(count);
+    for(uint32_t i = 0; i < count; i++) { bvh.objects[i] = i; }
+    if(count == 0)
+    {
+        return bvh;
+    }
+
+    /* a binary tree with n leaves has at most 2n - 1 nodes */
+    bvh.nodes.resize(2 * std::size_t(count) - 1);
+    bvh.parents.assign(bvh.nodes.size(), detail::BVH_NO_PARENT);
+
+    detail::BVHBuilder builder{bvh, options};
+    builder.centroids.resize(3 * std::size_t(count));
+    for(uint32_t i = 0; i < count; i++)
+    {
+        builder.centroids[3 * i + 0] = 0.5f * (boxes[i].min.x + boxes[i].max.x);
+        builder.centroids[3 * i + 1] = 0.5f * (boxes[i].min.y + boxes[i].max.y);
+        builder.centroids[3 * i + 2] = 0.5f * (boxes[i].min.z + boxes[i].max.z);
+    }
+
+    std::unique_ptr<ThreadPool, void (*)(ThreadPool*)> ownPool(nullptr, threadPoolDelete);
+    if(count > options.parallelThreshold)
+    {
+        if(options.pool)
+        {
+            builder.pool = options.pool;
+        }
+        else if(options.threads != 1)
+        {
+            ownPool.reset(threadPoolCreate(options.threads));
+            builder.pool = ownPool.get();
+        }
+    }
+
+    if(builder.pool)
+    {
+        detail::bvhSpawnNode(builder, 0, 0, count);
+        std::unique_lock<std::mutex> lock(builder.mutex);
+        builder.tasksDone.wait(lock, [&builder]() { return builder.pendingTasks == 0; });
+    }
+    else
+    {
+        detail::bvhBuildNode(builder, 0, 0, count);
+    }
+
+    bvh.nodes.resize(builder.nodeCount);
+    bvh.parents.resize(builder.nodeCount);
+
+    bvh.objectLeaf.resize(count);
+    for(uint32_t n = 0; n < bvh.nodes.size(); n++)
+    {
+        const BVHNode& node = bvh.nodes[n];
+        if(node.left == 0)
+        {
+            for(uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                bvh.objectLeaf[bvh.objects[i]] = n;
+            }
+        }
+    }
+    return bvh;
+}
+
+void bvhRefit(BVH& bvh, const std::vector<AABB>& boxes)
+{
+    bvh.boxes = boxes;
+
+    /* children are stored after their parents, so a reverse sweep visits them first */
+    for(std::size_t n = bvh.nodes.size(); n-- > 0;)
+    {
+        detail::bvhRefitNode(bvh, bvh.nodes[n]);
+    }
+}
+
+void bvhUpdate(BVH& bvh, uint32_t object, const AABB& box)
+{
+    bvh.boxes[object] = box;
+
+    uint32_t n = bvh.objectLeaf[object];
+    while(n != detail::BVH_NO_PARENT)
+    {
+        BVHNode& node = bvh.nodes[n];
+        AABB previous = node.box;
+        detail::bvhRefitNode(bvh, node);
+        if(detail::aabbEqual(previous, node.box))
+        {
+            break;
+        }
+        n = bvh.parents[n];
+    }
+}
+
+std::size_t bvhQueryFrustum(const BVH& bvh, const Frustum& frustum, std::vector<uint32_t>& visible, FrustumCullStats* stats)
+{
+    PROFILE_SCOPE("bvhQueryFrustum");
+
+    visible.clear();
+    if(bvh.nodes.empty())
+    {
+        return 0;
+    }
+
+    /* every stack entry carries the planes its node still intersects, planes are dropped once a box is fully inside */
+    struct Entry { uint32_t node; uint32_t planes; };
+    std::vector<Entry> stack;
+    stack.reserve(64);
+    stack.push_back({0, 0x3F});
+
+    while(!stack.empty())
+    {
+        Entry entry = stack.back();
+        stack.pop_back();
+
+        const BVHNode& node = bvh.nodes[entry.node];
+        bool culled = false;
+        uint32_t planes = entry.planes;
+        for(uint32_t p = 0; p < 6 && !culled; p++)
+        {
+            if(!(planes & (1u << p)))
+            {
+                continue;
+            }
+            /* corners of the box farthest along and against the plane normal */
+            const Vector4D& plane = frustum.planes[p];
+            const AABB& box = node.box;
+            float outside = plane.x * (plane.x >= 0.0f ? box.max.x : box.min.x) + plane.y * (plane.y >= 0.0f ? box.max.y : box.min.y)
+                          + plane.z * (plane.z >= 0.0f ? box.max.z : box.min.z) + plane.w;
+            float inside = plane.x * (plane.x >= 0.0f ? box.min.x : box.max.x) + plane.y * (plane.y >= 0.0f ? box.min.y : box.max.y)
+                       + plane.z * (plane.z >= 0.0f ? box.min.z : box.max.z) + plane.w;
+            if(outside < 0.0f)
+            {
+                culled = true;
+            }
+            else if(inside >= 0.0f)
+            {
+                planes &= ~(1u << p);
+            }
+        }
+        if(culled)
+        {
+            continue;
+        }
+
+        if(planes == 0)
+        {
+            visible.insert(visible.end(), bvh.objects.begin() + node.first, bvh.objects.begin() + node.first + node.count);
+        }
+        else if(node.left == 0)
+        {
+            for(uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                uint32_t object = bvh.objects[i];
+                if(frustumTestAABB(frustum, bvh.boxes[object]))
+                {
+                    visible.push_back(object);
+                }
+            }
+        }
+        else
+        {
+            stack.push_back({node.left + 1, planes});
+            stack.push_back({node.left, planes});
+        }
+    }
+
+    if(stats)
+    {
+        stats->objects += bvh.objects.size();
+        stats->visible += visible.size();
+        stats->culled += bvh.objects.size() - visible.size();
+    }
+    return visible.size();
+}
+
+bool bvhQueryRay(const BVH& bvh, const Vector3D& origin, const Vector3D& direction, BVHRayHit& hit, float maxDistance)
+{
+    if(bvh.nodes.empty())
+    {
+        return false;
+    }
+
+    const float inf = std::numeric_limits<float>::infinity();
+    Vector3D inverseDirection(direction.x != 0.0f ? 1.0f / direction.x : inf,
+                              direction.y != 0.0f ? 1.0f / direction.y : inf,
+                              direction.z != 0.0f ? 1.0f / direction.z : inf);
+
+    bool found = false;
+    float best = maxDistance;
+
+    std::vector<uint32_t> stack;
+    stack.reserve(64);
+    if(detail::bvhRayBox(bvh.nodes[0].box, origin, inverseDirection, best) >= 0.0f)
+    {
+        stack.push_back(0);
+    }
+
+    while(!stack.empty())
+    {
+        const BVHNode& node = bvh.nodes[stack.back()];
+        stack.pop_back();
+
+        if(node.left == 0)
+        {
+            for(uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                float t = detail::bvhRayBox(bvh.boxes[bvh.objects[i]], origin, inverseDirection, best);
+                if(t >= 0.0f && (!found || t < best))
+                {
+                    found = true;
+                    best = t;
+                    hit.object = bvh.objects[i];
+                    hit.distance = t;
+                }
+            }
+            continue;
+        }
+
+        /* push the farther child first so the nearer one is visited next */
+        float tLeft = detail::bvhRayBox(bvh.nodes[node.left].box, origin, inverseDirection, best);
+        float tRight = detail::bvhRayBox(bvh.nodes[node.left + 1].box, origin, inverseDirection, best);
+        if(tLeft >= 0.0f && tRight >= 0.0f)
+        {
+            bool leftFirst = tLeft <= tRight;
+            stack.push_back(leftFirst ? node.left + 1 : node.left);
+            stack.push_back(leftFirst ? node.left : node.left + 1);
+        }
+        else if(tLeft >= 0.0f)
+        {
+            stack.push_back(node.left);
+        }
+        else if(tRight >= 0.0f)
+        {
+            stack.push_back(node.left + 1);
+        }
+    }
+    return found;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "bounds.h"
+#include "frustum.h"
+#include "threadpool.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * Node of a bounding volume hierarchy. Every node covers the objects [first, first + count) of BVH::objects, inner
+ * nodes have their two children at left and left + 1, leaves have left == 0 (the root is never a child).
+ */
+struct BVHNode
+{
+    AABB box;
+    uint32_t left = 0;
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+/**
+ * Bounding volume hierarchy over the world space boxes of a set of objects. Objects are identified by their index in the
+ * box array the hierarchy was built from. Children are always stored after their parent.
+ */
+struct BVH
+{
+    std::vector<BVHNode> nodes;
+    std::vector<uint32_t> objects;
+    std::vector<AABB> boxes;
+
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> objectLeaf;
+};
+
+struct BVHBuildOptions
+{
+    /* nodes with at most this many objects become leaves */
+    unsigned int maxLeafSize = 4;
+
+    /* worker threads used if no pool is given, 0 = one per hardware thread, 1 builds on the calling thread */
+    unsigned int threads = 0;
+    ThreadPool* pool = nullptr;
+
+    /* subtrees with more objects are built as separate tasks */
+    unsigned int parallelThreshold = 1u << 14;
+};
+
+struct BVHRayHit
+{
+    uint32_t object = 0;
+    float distance = 0.0f;
+};
+
+/**
+ * @brief Build a BVH with a binned SAH split (16 bins per axis). Large subtrees are built in parallel.
+ *
+ * @param boxes World space box of every object.
+ * @param options Build options.
+ *
+ * @return Hierarchy over all objects.
+ */
+BVH bvhBuild(const std::vector<AABB>& boxes, const BVHBuildOptions& options = BVHBuildOptions());
+
+/**
+ * @brief Replace all object boxes and recompute the node boxes bottom up without changing the tree structure. The
+ * quality of the tree degrades if objects move far, rebuild it in that case.
+ *
+ * @param bvh Hierarchy to refit.
+ * @param boxes New world space box of every object, same number of objects as at build time.
+ */
+void bvhRefit(BVH& bvh, const std::vector<AABB>& boxes);
+
+/**
+ * @brief Change the box of a single object and refit only the nodes on the path to the root, stopping as soon as a node
+ * box doesn't change.
+ *
+ * @param bvh Hierarchy to update.
+ * @param object Index of the object.
+ * @param box New world space box of the object.
+ */
+void bvhUpdate(BVH& bvh, uint32_t object, const AABB& box);
+
+/**
+ * @brief Collect all objects whose boxes intersect the frustum (same test as frustumTestAABB(...)). Subtrees completely
+ * inside the frustum are added without testing their objects.
+ *
+ * @param bvh Hierarchy to query.
+ * @param frustum Frustum in world space.
+ * @param visible Receives the indices of the visible objects.
+ * @param stats Optional, statistics are accumulated into it.
+ *
+ * @return Number of visible objects.
+ */
+std::size_t bvhQueryFrustum(const BVH& bvh, const Frustum& frustum, std::vector<uint32_t>& visible, FrustumCullStats* stats = nullptr);
+
+/**
+ * @brief Find the object box hit first by a ray, e.g. for mouse picking.
+ *
+ * @param bvh Hierarchy to query.
+ * @param origin Ray origin in world space.
+ * @param direction Ray direction in world space, distances are measured in multiples of it.
+ * @param hit Receives the object and the distance to its box (0 if the origin is inside the box).
+ * @param maxDistance Boxes farther away are ignored.
+ *
+ * @return True if an object was hit.
+ *
+ * usage:
+ *
+ *   BVHRayHit hit;
+ *   if(bvhQueryRay(myBVH, cam.position, rayDirection, hit)) { pick(hit.object); }
+ *
+ */
+bool bvhQueryRay(const BVH& bvh, const Vector3D& origin, const Vector3D& direction, BVHRayHit& hit,
+                 float maxDistance = std::numeric_limits<float>::max());
@@ -1,8 +1,11 @@
 #include "camera.h"
+#include "transform.h"
+#include "uniformbuffer.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <algorithm>
+#include <cstddef>
 
 namespace detail
 {
@@ -22,16 +25,30 @@ Vector3D sphericalCoords(const Camera& cam)
 
 Camera cameraCreate(float width, float height, float fov, float nearPlane, float farPlane, const Vector3D &initPos, const Vector3D &lookAt, const Vector3D &initUp)
 {
-    return {width, height, fov, nearPlane, farPlane, initPos, lookAt, initUp};
+    Camera cam{width, height, fov, nearPlane, farPlane, initPos, lookAt, initUp};
+    cameraUpdate(cam);
+    return cam;
 }
 
-Matrix4D cameraProjection(const Camera &cam)
+const Matrix4D& cameraProjection(const Camera &cam)
 {
-    return Matrix4D::perspective(cam.fov, cam.width/cam.height, cam.nearPlane, cam.farPlane);
+    return cam.projection;
 }
 
-Matrix4D cameraView(const Camera &cam)
+const Matrix4D& cameraView(const Camera &cam)
 {
+    return cam.view;
+}
+
+const Matrix4D& cameraViewProjection(const Camera &cam)
+{
+    return cam.viewProj;
+}
+
+void cameraUpdate(Camera &cam)
+{
+    cam.projection = Matrix4D::perspective(cam.fov, cam.width/cam.height, cam.nearPlane, cam.farPlane);
+
     Vector3D front = normalize(cam.lookAt - cam.position);
     Vector3D right = normalize(cross(front, cam.initUp));
     Vector3D up = normalize(cross(right, front));
@@ -43,11 +60,28 @@ Matrix4D cameraView(const Camera &cam)
              0.0f,       0.0f,       0.0f,       1.0f
             );
 
-    return  rotation * Matrix4D::translation(-cam.position);
-} 
+    cam.view = rotation * Matrix4D::translation(-cam.position);
+    cam.viewProj = matrixMultiply(cam.projection, cam.view);
+}
+
+void cameraResize(Camera &cam, float width, float height)
+{
+    if(cam.width == width && cam.height == height)
+    {
+        return;
+    }
+    cam.width = width;
+    cam.height = height;
+    cameraUpdate(cam);
+}
 
 void cameraUpdateOrbit(Camera& cam, const Vector2D& mouseDiff, float zoom)
 {
+    if(mouseDiff.x == 0.0f && mouseDiff.y == 0.0f && zoom == 0.0f)
+    {
+        return;
+    }
+
     Vector3D spherCoord = detail::sphericalCoords(cam);
     float r = spherCoord[0];
     float phi = spherCoord[1];
@@ -63,4 +97,26 @@ void cameraUpdateOrbit(Camera& cam, const Vector2D& mouseDiff, float zoom)
     Vector3D cartCoord(r * sin(theta) * sin(phi), r * cos(theta), r * sin(theta) * cos(phi));
 
     cam.position = cam.lookAt + cartCoord;
+    cameraUpdate(cam);
+}
+
+const Std140Layout& cameraBlockLayout()
+{
+    static const Std140Layout layout = std140Layout({{Std140Type::Mat4, offsetof(CameraBlock, view)},
+                                                     {Std140Type::Mat4, offsetof(CameraBlock, proj)},
+                                                     {Std140Type::Mat4, offsetof(CameraBlock, viewProj)},
+                                                     {Std140Type::Vec3, offsetof(CameraBlock, position)},
+                                                     {Std140Type::Float, offsetof(CameraBlock, time)}});
+    return layout;
+}
+
+CameraBlock cameraBlock(const Camera& cam, float time)
+{
+    CameraBlock block;
+    block.view = cam.view;
+    block.proj = cam.projection;
+    block.viewProj = cam.viewProj;
+    block.position = cam.position;
+    block.time = time;
+    return block;
 }
@@ -4,6 +4,8 @@
 #include <math/vector3d.h>
 #include <math/matrix4d.h>
 
+struct Std140Layout;
+
 struct Camera
 {
     float width;
@@ -14,6 +16,32 @@ struct Camera
     Vector3D position;
     Vector3D lookAt;
     Vector3D initUp;
+
+    /* cached matrices, only recomputed by cameraCreate, cameraUpdateOrbit, cameraResize and cameraUpdate */
+    Matrix4D view;
+    Matrix4D projection;
+    Matrix4D viewProj;
+};
+
+/**
+ * Per-frame camera data, shared by all programs through the std140 uniform block "Camera" at SHADER_BINDING_CAMERA:
+ *
+ *   layout(std140) uniform Camera
+ *   {
+ *       mat4 uView;
+ *       mat4 uProj;
+ *       mat4 uViewProj;
+ *       vec3 uCameraPosition;
+ *       float uTime;
+ *   };
+ */
+struct CameraBlock
+{
+    Matrix4D view;
+    Matrix4D proj;
+    Matrix4D viewProj;
+    Vector3D position;
+    float time;
 };
 
 /**
@@ -35,20 +63,45 @@ Camera cameraCreate(float width, float height, float fov, float nearPlane, float
 /**
  * @brief Get projection matrix from a camera.
  *
- * @param cam Camera from which the projection matrix is calculated.
+ * @param cam Camera from which the projection matrix is taken.
  *
- * @return Projection matrix.
+ * @return Cached projection matrix.
  */
-Matrix4D cameraProjection(const Camera& cam);
+const Matrix4D& cameraProjection(const Camera& cam);
 
 /**
  * @brief Get view matrix from a camera.
  *
- * @param cam Camera from which the view matrix is calculated.
+ * @param cam Camera from which the view matrix is taken.
+ *
+ * @return Cached view matrix.
+ */
+const Matrix4D& cameraView(const Camera& cam);
+
+/**
+ * @brief Get the product of projection and view matrix from a camera.
+ *
+ * @param cam Camera from which the matrix is taken.
+ *
+ * @return Cached projection * view matrix.
+ */
+const Matrix4D& cameraViewProjection(const Camera& cam);
+
+/**
+ * @brief Recompute the cached matrices. Only needed after changing the fields of a camera directly.
+ *
+ * @param cam Camera that gets updated.
+ */
+void cameraUpdate(Camera& cam);
+
+/**
+ * @brief Change the image size of a camera, the matrices are only recomputed if the size actually changes.
  *
- * @return View matrix.
+ * @param cam Camera that gets updated.
+ * @param width New image width.
+ * @param height New image height.
  */
-Matrix4D cameraView(const Camera& cam);
+void cameraResize(Camera& cam, float width, float height);
 
 /**
  * @brief Update camera position on the orbit around the look at point using spherical coordinates.
@@ -57,5 +110,31 @@ Matrix4D cameraView(const Camera& cam);
  * @param mouseDiff X and Y distances that are used to change the spherical coordinate angles of the camera position.
  * with respect to the look at point.
  * @param zoom Factor to zoom in (-) or out (+) (distance of camera position to look at point is de-/increased).
+ * Nothing is recomputed if both are zero.
  */
 void cameraUpdateOrbit(Camera &cam, const Vector2D &mouseDiff, float zoom);
+
+/**
+ * @brief Get the std140 layout of CameraBlock, e.g. to create a uniform ring for it (see uniformbuffer.h).
+ *
+ * @return Layout of the "Camera" uniform block.
+ */
+const Std140Layout& cameraBlockLayout();
+
+/**
+ * @brief Fill the per-frame camera block.
+ *
+ * @param cam Camera.
+ * @param time Time in seconds, passed on to the shaders.
+ *
+ * @return Camera block.
+ *
+ * usage:
+ *
+ *   UniformRing cameraUniforms = uniformRingCreate(cameraBlockLayout(), SHADER_BINDING_CAMERA);
+ *   ...
+ *   CameraBlock block = cameraBlock(camera, float(glfwGetTime()));
+ *   uniformRingWrite(cameraUniforms, &block);
+ *
+ */
+CameraBlock cameraBlock(const Camera& cam, float time);
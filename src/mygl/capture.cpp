@@ -0,0 +1,395 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <stb_image/stb_image_write.h>
+
+namespace detail
+{
+    const char* captureExtension(CaptureFormat format)
+    {
+        switch(format)
+        {
+            case CaptureFormat::PNG: return ".png";
+            case CaptureFormat::QOI: return ".qoi";
+            case CaptureFormat::Raw: return ".pam";
+        }
+        return "";
+    }
+
+    const char* captureFormatName(CaptureFormat format)
+    {
+        switch(format)
+        {
+            case CaptureFormat::PNG: return "png";
+            case CaptureFormat::QOI: return "qoi";
+            case CaptureFormat::Raw: return "raw";
+        }
+        return "";
+    }
+
+    std::string capturePath(const Capture* capture, uint64_t frame)
+    {
+        std::ostringstream path;
+        path << capture->options.directory << "/" << capture->options.prefix << std::setw(6) << std::setfill('0') << frame
+             << captureExtension(capture->options.format);
+        return path.str();
+    }
+
+    bool captureWriteFile(const std::string& path, const std::string& header, const uint8_t* data, std::size_t size)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(header.data(), std::streamsize(header.size()));
+        file.write(reinterpret_cast<const char*>(data), std::streamsize(size));
+        return bool(file);
+    }
+
+    void captureReleaseFrame(Capture* capture, unsigned int frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(capture->mutex);
+            capture->freeFrames.push_back(frame);
+        }
+        capture->changed.notify_all();
+    }
+
+    /* runs on an encoder thread: rows out of the mapped buffer into the reserved frame, then the file from the frame */
+    void captureEncode(Capture* capture, ScreenshotSlot* slot, const uint8_t* mapped, unsigned int frame)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const unsigned int width = slot->width;
+        const unsigned int height = slot->height;
+        const std::size_t rowBytes = std::size_t(width) * 4;
+        const std::string path = slot->path;
+
+        std::vector<uint8_t>& pixels = capture->frames[frame];
+        pixels.resize(rowBytes * height);
+        screenshotFlipRows(mapped, pixels.data(), rowBytes, height);
+        {
+            std::lock_guard<std::mutex> lock(capture->mutex);
+            slot->copied.store(true, std::memory_order_release);
+        }
+        capture->changed.notify_all();
+
+        bool written = false;
+        switch(capture->options.format)
+        {
+            case CaptureFormat::PNG:
+            {
+                written = stbi_write_png(path.c_str(), int(width), int(height), 4, pixels.data(), int(rowBytes)) != 0;
+                break;
+            }
+            case CaptureFormat::QOI:
+            {
+                /* kept per thread, so the worst case allocation happens once */
+                thread_local std::vector<uint8_t> encoded;
+                captureEncodeQOI(pixels.data(), width, height, encoded);
+                written = captureWriteFile(path, "", encoded.data(), encoded.size());
+                break;
+            }
+            case CaptureFormat::Raw:
+            {
+                const std::string header = "P7\nWIDTH " + std::to_string(width) + "\nHEIGHT " + std::to_string(height) +
+                                           "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+                written = captureWriteFile(path, header, pixels.data(), pixels.size());
+                break;
+            }
+        }
+        captureReleaseFrame(capture, frame);
+
+        if(written)
+        {
+            capture->written.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            std::cerr << "[Capture] Couldn't write " << path << std::endl;
+            capture->failed.fetch_add(1, std::memory_order_relaxed);
+        }
+        capture->encodeNs.fetch_add(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+    }
+
+    /* maps a finished readback and hands it to an encoder, a failed readback gives its frame back */
+    void captureMap(Capture* capture, unsigned int index, GLuint64 timeout)
+    {
+        ScreenshotSlot& slot = capture->slots[index];
+        const uint8_t* mapped = screenshotSlotMap(slot, timeout);
+        if(!mapped)
+        {
+            if(slot.fence == nullptr)
+            {
+                capture->failed.fetch_add(1, std::memory_order_relaxed);
+                captureReleaseFrame(capture, capture->slotFrames[index]);
+            }
+            return;
+        }
+
+        ScreenshotSlot* target = &slot;
+        const unsigned int frame = capture->slotFrames[index];
+        threadPoolSubmit(capture->encoders, [capture, target, mapped, frame]()
+        {
+            captureEncode(capture, target, mapped, frame);
+        });
+    }
+
+    /* block mode: the oldest readback has to be mapped, copied out and unmapped before its buffer can be reused */
+    void captureWaitSlot(Capture* capture, unsigned int index)
+    {
+        ScreenshotSlot& slot = capture->slots[index];
+        while(slot.fence)
+        {
+            captureMap(capture, index, GLuint64(1000000000));
+        }
+        if(slot.mapped)
+        {
+            std::unique_lock<std::mutex> lock(capture->mutex);
+            capture->changed.wait(lock, [&slot]() { return slot.copied.load(std::memory_order_acquire); });
+            lock.unlock();
+            screenshotSlotUnmap(slot);
+        }
+    }
+}
+
+bool captureParseFormat(const std::string& name, CaptureFormat* format)
+{
+    for(CaptureFormat candidate : {CaptureFormat::PNG, CaptureFormat::QOI, CaptureFormat::Raw})
+    {
+        if(name == detail::captureFormatName(candidate))
+        {
+            *format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+Capture* captureCreate(const CaptureOptions& options)
+{
+    Capture* capture = new Capture;
+    capture->options = options;
+    capture->options.pixelBuffers = std::max(1u, options.pixelBuffers);
+    capture->options.queuedFrames = std::max(1u, options.queuedFrames);
+
+    std::error_code error;
+    std::filesystem::create_directories(options.directory, error);
+    if(error)
+    {
+        std::cerr << "[Capture] Couldn't create " << options.directory << ": " << error.message() << std::endl;
+    }
+
+    /* a readback holds its frame until the encoder is done, so there is one frame per pixel buffer on top of the queue */
+    capture->slots = std::make_unique<ScreenshotSlot[]>(capture->options.pixelBuffers);
+    capture->slotFrames.resize(capture->options.pixelBuffers, 0);
+    const unsigned int frames = capture->options.pixelBuffers + capture->options.queuedFrames;
+    capture->frames.resize(frames);
+    for(unsigned int i = 0; i < frames; i++)
+    {
+        capture->freeFrames.push_back(frames - 1 - i);
+    }
+
+    unsigned int threads = options.encoderThreads;
+    if(threads == 0)
+    {
+        threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+    capture->encoders = threadPoolCreate(threads);
+    return capture;
+}
+
+bool captureFrame(Capture* capture)
+{
+    captureUpdate(capture);
+    const uint64_t number = capture->requested++;
+    const bool block = capture->options.backpressure == CaptureBackpressure::Block;
+    const auto start = std::chrono::steady_clock::now();
+
+    bool waited = false;
+    const unsigned int index = capture->next;
+    if(!screenshotSlotFree(capture->slots[index]))
+    {
+        if(!block)
+        {
+            capture->dropped++;
+            return false;
+        }
+        detail::captureWaitSlot(capture, index);
+        waited = true;
+    }
+
+    unsigned int frame = 0;
+    {
+        std::unique_lock<std::mutex> lock(capture->mutex);
+        if(capture->freeFrames.empty())
+        {
+            if(!block)
+            {
+                capture->dropped++;
+                return false;
+            }
+            capture->changed.wait(lock, [capture]() { return !capture->freeFrames.empty(); });
+            waited = true;
+        }
+        frame = capture->freeFrames.back();
+        capture->freeFrames.pop_back();
+    }
+    if(waited)
+    {
+        capture->blockedMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    capture->slotFrames[index] = frame;
+    screenshotSlotRead(capture->slots[index], detail::capturePath(capture, number));
+    capture->next = (index + 1) % capture->options.pixelBuffers;
+    return true;
+}
+
+void captureUpdate(Capture* capture)
+{
+    /* oldest first, so frames reach the encoders in order */
+    for(unsigned int i = 0; i < capture->options.pixelBuffers; i++)
+    {
+        const unsigned int index = (capture->next + i) % capture->options.pixelBuffers;
+        ScreenshotSlot& slot = capture->slots[index];
+        if(slot.mapped && slot.copied.load(std::memory_order_acquire))
+        {
+            screenshotSlotUnmap(slot);
+        }
+        if(slot.fence)
+        {
+            detail::captureMap(capture, index, 0);
+        }
+    }
+}
+
+void captureDelete(Capture* capture)
+{
+    for(unsigned int i = 0; i < capture->options.pixelBuffers; i++)
+    {
+        detail::captureWaitSlot(capture, (capture->next + i) % capture->options.pixelBuffers);
+    }
+    threadPoolWait(capture->encoders);
+    threadPoolDelete(capture->encoders);
+    for(unsigned int i = 0; i < capture->options.pixelBuffers; i++)
+    {
+        screenshotSlotDelete(capture->slots[i]);
+    }
+
+    const uint64_t written = capture->written.load();
+    std::cout << "[Capture] " << written << " of " << capture->requested << " frames written to " << capture->options.directory
+              << " (" << detail::captureFormatName(capture->options.format) << ")";
+    if(capture->dropped > 0 || capture->failed.load() > 0)
+    {
+        std::cout << ", " << capture->dropped << " dropped, " << capture->failed.load() << " failed";
+    }
+    if(written > 0)
+    {
+        std::cout << ", " << std::fixed << std::setprecision(2) << double(capture->encodeNs.load()) * 1e-6 / double(written)
+                  << " ms per frame and encoder";
+    }
+    if(capture->blockedMs > 0.0)
+    {
+        std::cout << ", rendering blocked for " << std::fixed << std::setprecision(1) << capture->blockedMs << " ms";
+    }
+    std::cout << std::endl;
+    delete capture;
+}
+
+void captureEncodeQOI(const uint8_t* pixels, unsigned int width, unsigned int height, std::vector<uint8_t>& output)
+{
+    /* worst case is 5 bytes per pixel, plus the 14 byte header and the 8 byte end marker */
+    const std::size_t count = std::size_t(width) * height;
+    output.resize(14 + count * 5 + 8);
+    uint8_t* out = output.data();
+
+    auto writeU32 = [&out](uint32_t value)
+    {
+        *out++ = uint8_t(value >> 24);
+        *out++ = uint8_t(value >> 16);
+        *out++ = uint8_t(value >> 8);
+        *out++ = uint8_t(value);
+    };
+    *out++ = 'q'; *out++ = 'o'; *out++ = 'i'; *out++ = 'f';
+    writeU32(width);
+    writeU32(height);
+    *out++ = 4;
+    *out++ = 0;
+
+    /* pixels are compared and hashed as the word of their RGBA bytes, channels come from the bytes */
+    const uint8_t start[4] = {0, 0, 0, 255};
+    uint32_t index[64] = {};
+    uint32_t previous;
+    std::memcpy(&previous, start, 4);
+    const uint8_t* last = start;
+    unsigned int run = 0;
+    for(std::size_t i = 0; i < count; i++)
+    {
+        const uint8_t* current = pixels + i * 4;
+        uint32_t pixel;
+        std::memcpy(&pixel, current, 4);
+        if(pixel == previous)
+        {
+            if(++run == 62 || i + 1 == count)
+            {
+                *out++ = uint8_t(0xc0 | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if(run > 0)
+        {
+            *out++ = uint8_t(0xc0 | (run - 1));
+            run = 0;
+        }
+
+        const uint8_t r = current[0], g = current[1], b = current[2], a = current[3];
+        const unsigned int hash = (r * 3u + g * 5u + b * 7u + a * 11u) % 64u;
+        if(index[hash] == pixel)
+        {
+            *out++ = uint8_t(hash);
+        }
+        else
+        {
+            index[hash] = pixel;
+            if(a == last[3])
+            {
+                const int dr = int8_t(uint8_t(r - last[0])), dg = int8_t(uint8_t(g - last[1])), db = int8_t(uint8_t(b - last[2]));
+                const int drg = dr - dg, dbg = db - dg;
+                if(dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+                {
+                    *out++ = uint8_t(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                }
+                else if(dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+                {
+                    *out++ = uint8_t(0x80 | (dg + 32));
+                    *out++ = uint8_t((drg + 8) << 4 | (dbg + 8));
+                }
+                else
+                {
+                    *out++ = 0xfe; *out++ = r; *out++ = g; *out++ = b;
+                }
+            }
+            else
+            {
+                *out++ = 0xff; *out++ = r; *out++ = g; *out++ = b; *out++ = a;
+            }
+        }
+        previous = pixel;
+        last = current;
+    }
+
+    for(int i = 0; i < 7; i++)
+    {
+        *out++ = 0;
+    }
+    *out++ = 1;
+    output.resize(std::size_t(out - output.data()));
+}
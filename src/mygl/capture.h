@@ -0,0 +1,141 @@
+#pragma once
+
+#include "screenshot.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* PNG is small and slow, QOI about as small as a fast PNG at a fraction of the time, raw (PAM) only costs the write */
+enum class CaptureFormat
+{
+    PNG,
+    QOI,
+    Raw
+};
+
+/* what happens to a frame if all pixel buffers or all queued frames are taken */
+enum class CaptureBackpressure
+{
+    /* skip the frame, rendering never waits (its number is missing in the sequence) */
+    Drop,
+    /* wait for the oldest readback or a free frame, every frame is written */
+    Block
+};
+
+struct CaptureOptions
+{
+    /* frames are written to directory/prefixNNNNNN.ext, the directory is created */
+    std::string directory = "capture";
+    std::string prefix = "frame_";
+    CaptureFormat format = CaptureFormat::QOI;
+    CaptureBackpressure backpressure = CaptureBackpressure::Drop;
+
+    /* readbacks in flight, frames copied out and waiting for an encoder (bounds the memory), 0 threads uses all but one */
+    unsigned int pixelBuffers = 4;
+    unsigned int queuedFrames = 16;
+    unsigned int encoderThreads = 0;
+};
+
+/**
+ * Continuous frame capture on top of the screenshot readback: every captured frame is read into the next pixel buffer
+ * of a ring, mapped once its fence has passed and copied into one of a fixed number of frame buffers by an encoder
+ * thread, which then writes the numbered image. The render thread only issues readbacks, maps and unmaps. Memory is
+ * bounded by the pixel buffers and pixelBuffers + queuedFrames frame buffers (a frame is reserved with its readback).
+ */
+struct Capture
+{
+    CaptureOptions options;
+    ThreadPool* encoders = nullptr;
+
+    /* ring of readbacks, the next one to use is always the oldest */
+    std::unique_ptr<ScreenshotSlot[]> slots;
+    std::vector<unsigned int> slotFrames;
+    unsigned int next = 0;
+
+    /* frame buffers and the ones not reserved by a readback or an encoder, guarded by mutex */
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<unsigned int> freeFrames;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    /* frames passed to captureFrame, written, dropped by backpressure, failed to read or write */
+    uint64_t requested = 0;
+    std::atomic<uint64_t> written{0};
+    uint64_t dropped = 0;
+    std::atomic<uint64_t> failed{0};
+
+    /* render thread time spent waiting in block mode and encoder time summed over all threads */
+    double blockedMs = 0.0;
+    std::atomic<uint64_t> encodeNs{0};
+};
+
+/**
+ * @brief Parse a format name.
+ *
+ * @param name "png", "qoi" or "raw".
+ * @param format Parsed format.
+ *
+ * @return False if the name is unknown.
+ */
+bool captureParseFormat(const std::string& name, CaptureFormat* format);
+
+/**
+ * @brief Create a capture and its encoder threads, frames are numbered from 0.
+ *
+ * @param options Output, format, backpressure and buffer counts.
+ *
+ * @return Capture, has to be deleted with captureDelete(...).
+ *
+ * usage:
+ *
+ *   Capture* capture = captureCreate(options);
+ *   while(running)
+ *   {
+ *       sceneDraw();
+ *       captureFrame(capture);
+ *       glfwSwapBuffers(window);
+ *   }
+ *   captureDelete(capture);
+ *
+ */
+Capture* captureCreate(const CaptureOptions& options);
+
+/**
+ * @brief Capture the current viewport of the bound read framebuffer, after the last draw and before the swap. Hands
+ * finished readbacks to the encoders first. Only waits with CaptureBackpressure::Block and all buffers taken.
+ *
+ * @param capture Capture.
+ *
+ * @return False if the frame was dropped.
+ */
+bool captureFrame(Capture* capture);
+
+/**
+ * @brief Hand finished readbacks to the encoders without capturing, for frames while capturing is paused.
+ *
+ * @param capture Capture.
+ */
+void captureUpdate(Capture* capture);
+
+/**
+ * @brief Wait for all frames to be written, print a summary, delete the buffers and stop the encoder threads. The
+ * context has to be current.
+ *
+ * @param capture Capture to delete.
+ */
+void captureDelete(Capture* capture);
+
+/**
+ * @brief Encode an image as QOI (qoiformat.org), RGBA with sRGB color and linear alpha.
+ *
+ * @param pixels Top-down RGBA rows.
+ * @param width Image width.
+ * @param height Image height.
+ * @param output Encoded file, replaced.
+ */
+void captureEncodeQOI(const uint8_t* pixels, unsigned int width, unsigned int height, std::vector<uint8_t>& output);
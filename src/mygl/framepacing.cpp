@@ -0,0 +1,166 @@
+#include "framepacing.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace detail
+{
+    using FramePacingClock = std::chrono::steady_clock;
+
+    /* seconds between two frame deadlines, 0 if frames are not waited for */
+    double framePacingPeriod(const FramePacingOptions& options)
+    {
+        switch(options.mode)
+        {
+            case FramePacing::TargetFPS: return 1.0 / options.targetFps;
+            case FramePacing::FixedStep: return options.fixedDt;
+            default: return 0.0;
+        }
+    }
+
+    /* sleeping overshoots by up to a scheduler tick, so the last spinMs are spent polling the clock */
+    void framePacingWaitUntil(FramePacingClock::time_point deadline, double spinMs)
+    {
+        const auto spin = std::chrono::duration_cast<FramePacingClock::duration>(std::chrono::duration<double, std::milli>(spinMs));
+        if(deadline - FramePacingClock::now() > spin)
+        {
+            std::this_thread::sleep_until(deadline - spin);
+        }
+        while(FramePacingClock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+FramePacingOptions framePacingParseArgs(int argc, char** argv)
+{
+    FramePacingOptions options;
+    bool modeGiven = false;
+    for(int i = 1; i + 1 < argc; i++)
+    {
+        const std::string argument = argv[i];
+        if(argument == "--pacing")
+        {
+            const std::string name = argv[++i];
+            bool known = false;
+            for(FramePacing mode : {FramePacing::VSync, FramePacing::Uncapped, FramePacing::TargetFPS, FramePacing::FixedStep})
+            {
+                if(name == framePacingName(mode))
+                {
+                    options.mode = mode;
+                    modeGiven = known = true;
+                }
+            }
+            if(!known)
+            {
+                std::cerr << "[FramePacing] Ignoring --pacing " << name << ", expected vsync, uncapped, fps or fixed" << std::endl;
+            }
+        }
+        else if(argument == "--fps")
+        {
+            const double fps = std::atof(argv[++i]);
+            if(fps > 0.0)
+            {
+                options.targetFps = fps;
+                options.mode = modeGiven ? options.mode : FramePacing::TargetFPS;
+            }
+        }
+        else if(argument == "--dt")
+        {
+            const double dt = std::atof(argv[++i]);
+            if(dt > 0.0)
+            {
+                options.fixedDt = dt;
+                options.mode = modeGiven ? options.mode : FramePacing::FixedStep;
+            }
+        }
+    }
+    return options;
+}
+
+const char* framePacingName(FramePacing mode)
+{
+    switch(mode)
+    {
+        case FramePacing::VSync: return "vsync";
+        case FramePacing::Uncapped: return "uncapped";
+        case FramePacing::TargetFPS: return "fps";
+        case FramePacing::FixedStep: return "fixed";
+    }
+    return "";
+}
+
+FramePacer framePacerCreate(const FramePacingOptions& options)
+{
+    FramePacer pacer;
+    pacer.options = options;
+    glfwSwapInterval(options.mode == FramePacing::VSync ? 1 : 0);
+
+    pacer._frameBegin = detail::FramePacingClock::now();
+    pacer._frameEnd = pacer._frameBegin;
+    pacer._deadline = pacer._frameBegin;
+    return pacer;
+}
+
+float framePacerBeginFrame(FramePacer& pacer)
+{
+    const auto now = detail::FramePacingClock::now();
+    const double measured = std::chrono::duration<double>(now - pacer._frameBegin).count();
+    pacer._frameBegin = now;
+
+    if(pacer.options.mode == FramePacing::FixedStep)
+    {
+        pacer.dt = pacer.options.fixedDt;
+        return float(pacer.dt);
+    }
+
+    pacer._steps[pacer._stepCount++ % FRAMEPACING_SMOOTHING] = std::min(measured, FRAMEPACING_MAX_DT);
+    const unsigned int count = std::min(pacer._stepCount, FRAMEPACING_SMOOTHING);
+    double sum = 0.0;
+    for(unsigned int i = 0; i < count; i++)
+    {
+        sum += pacer._steps[i];
+    }
+    pacer.dt = sum / double(count);
+    return float(pacer.dt);
+}
+
+void framePacerEndFrame(FramePacer& pacer)
+{
+    const double period = detail::framePacingPeriod(pacer.options);
+    if(period > 0.0)
+    {
+        /* deadlines follow each other, so a late frame is caught up; more than a frame late starts over from now */
+        const auto step = std::chrono::duration_cast<detail::FramePacingClock::duration>(std::chrono::duration<double>(period));
+        pacer._deadline += step;
+        const auto now = detail::FramePacingClock::now();
+        if(now > pacer._deadline + step)
+        {
+            pacer._deadline = now;
+        }
+        detail::framePacingWaitUntil(pacer._deadline, pacer.options.spinMs);
+    }
+
+    const auto end = detail::FramePacingClock::now();
+    pacer.frameMs.push_back(std::chrono::duration<double, std::milli>(end - pacer._frameEnd).count());
+    pacer._frameEnd = end;
+}
+
+void framePacerPrintStats(const FramePacer& pacer)
+{
+    const TimingStats frames = timingStats(pacer.frameMs);
+    std::cout << std::fixed << std::setprecision(2) << "[FramePacing] " << framePacingName(pacer.options.mode);
+    const double period = detail::framePacingPeriod(pacer.options);
+    if(period > 0.0)
+    {
+        std::cout << " (" << 1000.0 * period << " ms)";
+    }
+    std::cout << ": " << frames.count << " frames, mean " << frames.mean << " ms ("
+              << (frames.mean > 0.0 ? 1000.0 / frames.mean : 0.0) << " fps), p50 " << frames.p50 << ", p95 " << frames.p95
+              << ", p99 " << frames.p99 << ", max " << frames.max << " ms" << std::endl;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "base.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/* longest step passed to the scene in the measured modes, longer frames (a dragged window, a breakpoint) are cut */
+constexpr double FRAMEPACING_MAX_DT = 0.1;
+
+/* measured steps are averaged over this many frames, so single spikes are spread out */
+constexpr unsigned int FRAMEPACING_SMOOTHING = 8;
+
+enum class FramePacing
+{
+    /* swap interval 1, the display sets the rate */
+    VSync,
+    /* swap interval 0 and no waiting, for throughput measurements */
+    Uncapped,
+    /* swap interval 0, every frame waits for its deadline: sleep, then spin for the last spinMs */
+    TargetFPS,
+    /* every step is exactly fixedDt, frames are paced like TargetFPS at 1 / fixedDt, so a run is replayed the same way */
+    FixedStep
+};
+
+/* command line: --pacing vsync|uncapped|fps|fixed, --fps N (implies fps), --dt seconds (implies fixed) */
+struct FramePacingOptions
+{
+    FramePacing mode = FramePacing::VSync;
+    double targetFps = 60.0;
+    double fixedDt = 1.0 / 60.0;
+    double spinMs = 2.0;
+};
+
+struct FramePacer
+{
+    FramePacingOptions options;
+
+    /* wall clock milliseconds from one frame end to the next */
+    std::vector<double> frameMs;
+
+    /* step passed to the scene, the last measured steps and the time they are measured from */
+    double dt = 0.0;
+    double _steps[FRAMEPACING_SMOOTHING] = {};
+    unsigned int _stepCount = 0;
+    std::chrono::steady_clock::time_point _frameBegin;
+    std::chrono::steady_clock::time_point _frameEnd;
+    std::chrono::steady_clock::time_point _deadline;
+};
+
+/**
+ * @brief Parse the pacing options, unknown arguments are ignored.
+ *
+ * @param argc Argument count of main.
+ * @param argv Arguments of main.
+ *
+ * @return Options, VSync if none were given.
+ */
+FramePacingOptions framePacingParseArgs(int argc, char** argv);
+
+/**
+ * @brief Name of a pacing mode as used on the command line.
+ */
+const char* framePacingName(FramePacing mode);
+
+/**
+ * @brief Create a frame pacer and set the swap interval of the current GLFW context.
+ *
+ * @param options Pacing mode and rates.
+ *
+ * @return Frame pacer, the first frame starts now.
+ *
+ * usage:
+ *
+ *   FramePacer pacer = framePacerCreate(framePacingParseArgs(argc, argv));
+ *   while(!glfwWindowShouldClose(window))
+ *   {
+ *       glfwPollEvents();
+ *       sceneUpdate(framePacerBeginFrame(pacer));
+ *       sceneDraw();
+ *       glfwSwapBuffers(window);
+ *       framePacerEndFrame(pacer);
+ *   }
+ *   framePacerPrintStats(pacer);
+ *
+ */
+FramePacer framePacerCreate(const FramePacingOptions& options);
+
+/**
+ * @brief Start a frame.
+ *
+ * @param pacer Frame pacer.
+ *
+ * @return Seconds to advance the scene by: fixedDt for FixedStep, otherwise the time since the last frame, clamped to
+ * FRAMEPACING_MAX_DT and averaged over the last FRAMEPACING_SMOOTHING frames.
+ */
+float framePacerBeginFrame(FramePacer& pacer);
+
+/**
+ * @brief Finish a frame after the swap. Waits for the frame's deadline in TargetFPS and FixedStep mode and records the
+ * frame time.
+ *
+ * @param pacer Frame pacer.
+ */
+void framePacerEndFrame(FramePacer& pacer);
+
+/**
+ * @brief Print frame count and frame time mean, p50, p95, p99 and max.
+ *
+ * @param pacer Frame pacer.
+ */
+void framePacerPrintStats(const FramePacer& pacer);
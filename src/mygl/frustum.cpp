@@ -0,0 +1,347 @@
+#include "frustum.h"
+#include "simd.h"
+
+#include <cmath>
+
+namespace detail
+{
+    Vector4D normalizePlane(const Vector4D& p)
+    {
+        float length = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+        return p / length;
+    }
+
+    inline float planeDistance(const Vector4D& plane, const Vector3D& p)
+    {
+        return plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w;
+    }
+
+    /* appends base + k for every set bit k of mask, out needs space for width more entries */
+    inline std::size_t emitVisible(uint32_t* out, std::size_t n, uint32_t base, int mask, int width)
+    {
+#ifdef MYGL_SSE
+        /*
+         * Compacts 4 lanes at a time with a table of lane indices and one unaligned store. A branch on mask == 0 is
+         * mispredicted for about a third of the batches at typical visibility and costs more than the stores.
+         */
+        alignas(16) static const uint32_t lanes[16][4] = {
+            {0, 0, 0, 0}, {0, 0, 0, 0}, {1, 0, 0, 0}, {0, 1, 0, 0}, {2, 0, 0, 0}, {0, 2, 0, 0}, {1, 2, 0, 0}, {0, 1, 2, 0},
+            {3, 0, 0, 0}, {0, 3, 0, 0}, {1, 3, 0, 0}, {0, 1, 3, 0}, {2, 3, 0, 0}, {0, 2, 3, 0}, {1, 2, 3, 0}, {0, 1, 2, 3}};
+        static const uint8_t bits[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+        if(width >= 4)
+        {
+            for(int k = 0; k < width; k += 4)
+            {
+                int nibble = (mask >> k) & 15;
+                __m128i index = _mm_add_epi32(_mm_set1_epi32(int(base) + k), _mm_load_si128(reinterpret_cast<const __m128i*>(lanes[nibble])));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), index);
+                n += bits[nibble];
+            }
+            return n;
+        }
+#endif
+        for(int k = 0; k < width; k++)
+        {
+            out[n] = base + uint32_t(k);
+            n += (mask >> k) & 1;
+        }
+        return n;
+    }
+
+    std::size_t cullSpheresScalar(const Frustum& frustum, const SphereSoA& s, std::size_t i, std::size_t count, uint32_t* out, std::size_t n)
+    {
+        for(; i < count; i++)
+        {
+            bool inside = true;
+            for(const Vector4D& plane : frustum.planes)
+            {
+                inside &= !(plane.x * s.x[i] + plane.y * s.y[i] + plane.z * s.z[i] + plane.w < -s.radius[i]);
+            }
+            n = emitVisible(out, n, uint32_t(i), inside, 1);
+        }
+        return n;
+    }
+
+    std::size_t cullAABBsScalar(const Frustum& frustum, const AABBSoA& b, std::size_t i, std::size_t count, uint32_t* out, std::size_t n)
+    {
+        for(; i < count; i++)
+        {
+            bool inside = true;
+            for(const Vector4D& plane : frustum.planes)
+            {
+                float d = plane.x * b.centerX[i] + plane.y * b.centerY[i] + plane.z * b.centerZ[i] + plane.w
+                        + std::fabs(plane.x) * b.extentX[i] + std::fabs(plane.y) * b.extentY[i] + std::fabs(plane.z) * b.extentZ[i];
+                inside &= !(d < 0.0f);
+            }
+            n = emitVisible(out, n, uint32_t(i), inside, 1);
+        }
+        return n;
+    }
+
+#ifdef MYGL_SSE
+    std::size_t cullSpheresSSE(const Frustum& frustum, const SphereSoA& s, std::size_t& i, std::size_t count, uint32_t* out, std::size_t n)
+    {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 a[6], b[6], c[6], d[6];
+        for(int p = 0; p < 6; p++)
+        {
+            a[p] = _mm_set1_ps(frustum.planes[p].x);
+            b[p] = _mm_set1_ps(frustum.planes[p].y);
+            c[p] = _mm_set1_ps(frustum.planes[p].z);
+            d[p] = _mm_set1_ps(frustum.planes[p].w);
+        }
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(&s.x[i]);
+            __m128 y = _mm_loadu_ps(&s.y[i]);
+            __m128 z = _mm_loadu_ps(&s.z[i]);
+            __m128 negRadius = _mm_xor_ps(_mm_loadu_ps(&s.radius[i]), signMask);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(int p = 0; p < 6; p++)
+            {
+                __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[p], x), _mm_mul_ps(b[p], y)), _mm_add_ps(_mm_mul_ps(c[p], z), d[p]));
+                inside = _mm_and_ps(inside, _mm_cmpnlt_ps(dist, negRadius));
+            }
+            n = emitVisible(out, n, uint32_t(i), _mm_movemask_ps(inside), 4);
+        }
+        return n;
+    }
+
+    std::size_t cullAABBsSSE(const Frustum& frustum, const AABBSoA& b, std::size_t& i, std::size_t count, uint32_t* out, std::size_t n)
+    {
+        __m128 pa[6], pb[6], pc[6], pd[6], absA[6], absB[6], absC[6];
+        for(int p = 0; p < 6; p++)
+        {
+            const Vector4D& plane = frustum.planes[p];
+            pa[p] = _mm_set1_ps(plane.x);
+            pb[p] = _mm_set1_ps(plane.y);
+            pc[p] = _mm_set1_ps(plane.z);
+            pd[p] = _mm_set1_ps(plane.w);
+            absA[p] = _mm_set1_ps(std::fabs(plane.x));
+            absB[p] = _mm_set1_ps(std::fabs(plane.y));
+            absC[p] = _mm_set1_ps(std::fabs(plane.z));
+        }
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128 cx = _mm_loadu_ps(&b.centerX[i]);
+            __m128 cy = _mm_loadu_ps(&b.centerY[i]);
+            __m128 cz = _mm_loadu_ps(&b.centerZ[i]);
+            __m128 ex = _mm_loadu_ps(&b.extentX[i]);
+            __m128 ey = _mm_loadu_ps(&b.extentY[i]);
+            __m128 ez = _mm_loadu_ps(&b.extentZ[i]);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(int p = 0; p < 6; p++)
+            {
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pa[p], cx), _mm_mul_ps(pb[p], cy)), _mm_add_ps(_mm_mul_ps(pc[p], cz), pd[p]));
+                __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absA[p], ex), _mm_mul_ps(absB[p], ey)), _mm_mul_ps(absC[p], ez));
+                inside = _mm_and_ps(inside, _mm_cmpnlt_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+            }
+            n = emitVisible(out, n, uint32_t(i), _mm_movemask_ps(inside), 4);
+        }
+        return n;
+    }
+#endif
+
+#ifdef MYGL_AVX
+    MYGL_TARGET_AVX
+    std::size_t cullSpheresAVX(const Frustum& frustum, const SphereSoA& s, std::size_t& i, std::size_t count, uint32_t* out, std::size_t n)
+    {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        /* plane coefficients broadcast once instead of in every iteration */
+        __m256 a[6], b[6], c[6], d[6];
+        for(int p = 0; p < 6; p++)
+        {
+            a[p] = _mm256_set1_ps(frustum.planes[p].x);
+            b[p] = _mm256_set1_ps(frustum.planes[p].y);
+            c[p] = _mm256_set1_ps(frustum.planes[p].z);
+            d[p] = _mm256_set1_ps(frustum.planes[p].w);
+        }
+        for(; i + 8 <= count; i += 8)
+        {
+            __m256 x = _mm256_loadu_ps(&s.x[i]);
+            __m256 y = _mm256_loadu_ps(&s.y[i]);
+            __m256 z = _mm256_loadu_ps(&s.z[i]);
+            __m256 negRadius = _mm256_xor_ps(_mm256_loadu_ps(&s.radius[i]), signMask);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for(int p = 0; p < 6; p++)
+            {
+                __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a[p], x), _mm256_mul_ps(b[p], y)),
+                                            _mm256_add_ps(_mm256_mul_ps(c[p], z), d[p]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, negRadius, _CMP_NLT_UQ));
+            }
+            n = emitVisible(out, n, uint32_t(i), _mm256_movemask_ps(inside), 8);
+        }
+        return n;
+    }
+    MYGL_TARGET_AVX
+    std::size_t cullAABBsAVX(const Frustum& frustum, const AABBSoA& b, std::size_t& i, std::size_t count, uint32_t* out, std::size_t n)
+    {
+        __m256 pa[6], pb[6], pc[6], pd[6], absA[6], absB[6], absC[6];
+        for(int p = 0; p < 6; p++)
+        {
+            const Vector4D& plane = frustum.planes[p];
+            pa[p] = _mm256_set1_ps(plane.x);
+            pb[p] = _mm256_set1_ps(plane.y);
+            pc[p] = _mm256_set1_ps(plane.z);
+            pd[p] = _mm256_set1_ps(plane.w);
+            absA[p] = _mm256_set1_ps(std::fabs(plane.x));
+            absB[p] = _mm256_set1_ps(std::fabs(plane.y));
+            absC[p] = _mm256_set1_ps(std::fabs(plane.z));
+        }
+        for(; i + 8 <= count; i += 8)
+        {
+            __m256 cx = _mm256_loadu_ps(&b.centerX[i]);
+            __m256 cy = _mm256_loadu_ps(&b.centerY[i]);
+            __m256 cz = _mm256_loadu_ps(&b.centerZ[i]);
+            __m256 ex = _mm256_loadu_ps(&b.extentX[i]);
+            __m256 ey = _mm256_loadu_ps(&b.extentY[i]);
+            __m256 ez = _mm256_loadu_ps(&b.extentZ[i]);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for(int p = 0; p < 6; p++)
+            {
+                __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(pa[p], cx), _mm256_mul_ps(pb[p], cy)),
+                                         _mm256_add_ps(_mm256_mul_ps(pc[p], cz), pd[p]));
+                __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absA[p], ex), _mm256_mul_ps(absB[p], ey)),
+                                         _mm256_mul_ps(absC[p], ez));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_NLT_UQ));
+            }
+            n = emitVisible(out, n, uint32_t(i), _mm256_movemask_ps(inside), 8);
+        }
+        return n;
+    }
+#endif
+
+    void cullStatsAdd(FrustumCullStats* stats, std::size_t objects, std::size_t visible)
+    {
+        if(stats)
+        {
+            stats->objects += objects;
+            stats->visible += visible;
+            stats->culled += objects - visible;
+        }
+    }
+}
+
+Frustum frustumExtract(const Matrix4D& M)
+{
+    Vector4D row[4];
+    for(int i = 0; i < 4; i++)
+    {
+        row[i] = Vector4D(M(i,0), M(i,1), M(i,2), M(i,3));
+    }
+
+    Frustum frustum;
+    frustum.planes[0] = detail::normalizePlane(row[3] + row[0]);    // left
+    frustum.planes[1] = detail::normalizePlane(row[3] - row[0]);    // right
+    frustum.planes[2] = detail::normalizePlane(row[3] + row[1]);    // bottom
+    frustum.planes[3] = detail::normalizePlane(row[3] - row[1]);    // top
+    frustum.planes[4] = detail::normalizePlane(row[3] + row[2]);    // near
+    frustum.planes[5] = detail::normalizePlane(row[3] - row[2]);    // far
+    return frustum;
+}
+
+bool frustumTestSphere(const Frustum& frustum, const BoundingSphere& sphere)
+{
+    for(const Vector4D& plane : frustum.planes)
+    {
+        if(detail::planeDistance(plane, sphere.center) < -sphere.radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool frustumTestAABB(const Frustum& frustum, const AABB& box)
+{
+    for(const Vector4D& plane : frustum.planes)
+    {
+        /* corner of the box farthest along the plane normal */
+        Vector3D p(plane.x >= 0.0f ? box.max.x : box.min.x,
+                   plane.y >= 0.0f ? box.max.y : box.min.y,
+                   plane.z >= 0.0f ? box.max.z : box.min.z);
+        if(detail::planeDistance(plane, p) < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void sphereSoAClear(SphereSoA& spheres)
+{
+    spheres.x.clear();
+    spheres.y.clear();
+    spheres.z.clear();
+    spheres.radius.clear();
+}
+
+void sphereSoAAppend(SphereSoA& spheres, const BoundingSphere& sphere)
+{
+    spheres.x.push_back(sphere.center.x);
+    spheres.y.push_back(sphere.center.y);
+    spheres.z.push_back(sphere.center.z);
+    spheres.radius.push_back(sphere.radius);
+}
+
+void aabbSoAAppend(AABBSoA& boxes, const AABB& box)
+{
+    Vector3D center = (box.min + box.max) * 0.5f;
+    Vector3D extent = (box.max - box.min) * 0.5f;
+    boxes.centerX.push_back(center.x);
+    boxes.centerY.push_back(center.y);
+    boxes.centerZ.push_back(center.z);
+    boxes.extentX.push_back(extent.x);
+    boxes.extentY.push_back(extent.y);
+    boxes.extentZ.push_back(extent.z);
+}
+
+std::size_t frustumCullSpheres(const Frustum& frustum, const SphereSoA& spheres, std::vector<uint32_t>& visible, FrustumCullStats* stats)
+{
+    const std::size_t count = spheres.x.size();
+    visible.resize(count + 8);
+
+    std::size_t i = 0, n = 0;
+#ifdef MYGL_AVX
+    static const bool hasAVX = simdHasAVX();
+    if(hasAVX)
+    {
+        n = detail::cullSpheresAVX(frustum, spheres, i, count, visible.data(), n);
+    }
+#endif
+#ifdef MYGL_SSE
+    n = detail::cullSpheresSSE(frustum, spheres, i, count, visible.data(), n);
+#endif
+    n = detail::cullSpheresScalar(frustum, spheres, i, count, visible.data(), n);
+
+    visible.resize(n);
+    detail::cullStatsAdd(stats, count, n);
+    return n;
+}
+
+std::size_t frustumCullAABBs(const Frustum& frustum, const AABBSoA& boxes, std::vector<uint32_t>& visible, FrustumCullStats* stats)
+{
+    const std::size_t count = boxes.centerX.size();
+    visible.resize(count + 8);
+
+    std::size_t i = 0, n = 0;
+#ifdef MYGL_AVX
+    static const bool hasAVX = simdHasAVX();
+    if(hasAVX)
+    {
+        n = detail::cullAABBsAVX(frustum, boxes, i, count, visible.data(), n);
+    }
+#endif
+#ifdef MYGL_SSE
+    n = detail::cullAABBsSSE(frustum, boxes, i, count, visible.data(), n);
+#endif
+    n = detail::cullAABBsScalar(frustum, boxes, i, count, visible.data(), n);
+
+    visible.resize(n);
+    detail::cullStatsAdd(stats, count, n);
+    return n;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "bounds.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * View frustum as six planes (left, right, bottom, top, near, far). Each plane is stored as (a, b, c, d) with a
+ * normalized normal (a, b, c) pointing inside, a point p is inside if dot((a, b, c), p) + d >= 0.
+ */
+struct Frustum
+{
+    Vector4D planes[6];
+};
+
+/**
+ * @brief Extract the frustum planes from a combined projection matrix (Gribb/Hartmann). Passing projection * view gives
+ * world space planes, projection * view * model gives planes in the model space of an object.
+ *
+ * @param viewProjection Combined matrix.
+ *
+ * @return Frustum with normalized planes.
+ */
+Frustum frustumExtract(const Matrix4D& viewProjection);
+
+/**
+ * @brief Test whether a sphere intersects or is inside the frustum.
+ */
+bool frustumTestSphere(const Frustum& frustum, const BoundingSphere& sphere);
+
+/**
+ * @brief Test whether an axis aligned box intersects or is inside the frustum (conservative, boxes near frustum corners
+ * may be reported as visible).
+ */
+bool frustumTestAABB(const Frustum& frustum, const AABB& box);
+
+/**
+ * Bounding spheres of many objects in SoA layout for batch culling. All arrays have the same size.
+ */
+struct SphereSoA
+{
+    std::vector<float> x, y, z, radius;
+};
+
+/**
+ * Axis aligned boxes of many objects as center and half extent in SoA layout for batch culling. All arrays have the
+ * same size.
+ */
+struct AABBSoA
+{
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+};
+
+/* per frame counters, accumulated by the batch culling functions */
+struct FrustumCullStats
+{
+    std::size_t objects = 0;
+    std::size_t visible = 0;
+    std::size_t culled = 0;
+};
+
+/**
+ * @brief Remove all spheres of a SoA batch, keeping its memory.
+ */
+void sphereSoAClear(SphereSoA& spheres);
+
+/**
+ * @brief Append a sphere to a SoA batch.
+ */
+void sphereSoAAppend(SphereSoA& spheres, const BoundingSphere& sphere);
+
+/**
+ * @brief Append a box to a SoA batch.
+ */
+void aabbSoAAppend(AABBSoA& boxes, const AABB& box);
+
+/**
+ * @brief Test a batch of spheres against the frustum, 8 spheres per iteration with AVX (4 with SSE) if the CPU
+ * supports it.
+ *
+ * @param frustum Frustum to test against.
+ * @param spheres Spheres in the same space as the frustum planes.
+ * @param visible Receives the indices of all spheres that intersect the frustum in increasing order.
+ * @param stats Optional, statistics are accumulated into it.
+ *
+ * @return Number of visible spheres.
+ *
+ * usage:
+ *
+ *   Frustum frustum = frustumExtract(cameraViewProjection(cam));
+ *   frustumCullSpheres(frustum, worldSpheres, visible, &stats);
+ *   for(uint32_t i : visible) { renderQueueSubmit(queue, shader, meshes[i], models[i]); }
+ *
+ */
+std::size_t frustumCullSpheres(const Frustum& frustum, const SphereSoA& spheres, std::vector<uint32_t>& visible, FrustumCullStats* stats = nullptr);
+
+/**
+ * @brief Test a batch of boxes against the frustum, same as frustumTestAABB(...) but 8 boxes per iteration with AVX (4
+ * with SSE) if the CPU supports it.
+ *
+ * @param frustum Frustum to test against.
+ * @param boxes Boxes in the same space as the frustum planes.
+ * @param visible Receives the indices of all boxes that intersect the frustum in increasing order.
+ * @param stats Optional, statistics are accumulated into it.
+ *
+ * @return Number of visible boxes.
+ */
+std::size_t frustumCullAABBs(const Frustum& frustum, const AABBSoA& boxes, std::vector<uint32_t>& visible, FrustumCullStats* stats = nullptr);
@@ -0,0 +1,336 @@
+#include "glstate.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace detail
+{
+    /* marks a cached value as unknown, no OpenGL object has this name */
+    constexpr GLuint GLSTATE_UNKNOWN = ~0u;
+
+    const GLenum glStateBufferTargets[] = {GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                           GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_UNIFORM_BUFFER};
+    const GLenum glStateBufferQueries[] = {GL_ARRAY_BUFFER_BINDING, GL_ELEMENT_ARRAY_BUFFER_BINDING, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                           GL_PIXEL_PACK_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING, GL_UNIFORM_BUFFER_BINDING};
+    constexpr unsigned int GLSTATE_BUFFER_TARGETS = sizeof(glStateBufferTargets) / sizeof(glStateBufferTargets[0]);
+    constexpr unsigned int GLSTATE_ELEMENT_ARRAY_SLOT = 1;
+
+    const GLenum glStateTextureTargets[] = {GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_2D_MULTISAMPLE};
+    const GLenum glStateTextureQueries[] = {GL_TEXTURE_BINDING_2D, GL_TEXTURE_BINDING_3D, GL_TEXTURE_BINDING_CUBE_MAP, GL_TEXTURE_BINDING_2D_ARRAY,
+                                            GL_TEXTURE_BINDING_2D_MULTISAMPLE};
+    constexpr unsigned int GLSTATE_TEXTURE_TARGETS = sizeof(glStateTextureTargets) / sizeof(glStateTextureTargets[0]);
+
+    const GLenum glStateCapabilities[] = {GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_POLYGON_OFFSET_FILL,
+                                          GL_MULTISAMPLE, GL_FRAMEBUFFER_SRGB, GL_PRIMITIVE_RESTART, GL_DEPTH_CLAMP, GL_PROGRAM_POINT_SIZE,
+                                          GL_TEXTURE_CUBE_MAP_SEAMLESS};
+    constexpr unsigned int GLSTATE_CAPABILITIES = sizeof(glStateCapabilities) / sizeof(glStateCapabilities[0]);
+
+    struct GLState
+    {
+        GLuint program;
+        GLuint vao;
+        GLuint buffers[GLSTATE_BUFFER_TARGETS];
+        GLuint activeTexture;
+        GLuint textures[GLSTATE_TEXTURE_UNITS][GLSTATE_TEXTURE_TARGETS];
+
+        /* 0 = disabled, 1 = enabled, GLSTATE_UNKNOWN */
+        GLuint capabilities[GLSTATE_CAPABILITIES];
+
+        GLStateStats stats;
+    };
+
+    void glStateForget(GLState& state)
+    {
+        state.program = GLSTATE_UNKNOWN;
+        state.vao = GLSTATE_UNKNOWN;
+        std::fill_n(state.buffers, GLSTATE_BUFFER_TARGETS, GLSTATE_UNKNOWN);
+        state.activeTexture = GLSTATE_UNKNOWN;
+        std::fill_n(&state.textures[0][0], GLSTATE_TEXTURE_UNITS * GLSTATE_TEXTURE_TARGETS, GLSTATE_UNKNOWN);
+        std::fill_n(state.capabilities, GLSTATE_CAPABILITIES, GLSTATE_UNKNOWN);
+    }
+
+    GLState& glState()
+    {
+        static GLState state = []()
+        {
+            GLState initial;
+            glStateForget(initial);
+            return initial;
+        }();
+        return state;
+    }
+
+    template<typename T, std::size_t N>
+    int glStateSlot(const T (&list)[N], GLenum value)
+    {
+        for(std::size_t i = 0; i < N; i++)
+        {
+            if(list[i] == value)
+            {
+                return int(i);
+            }
+        }
+        return -1;
+    }
+
+    /* debug builds check every skipped call, the cached value has to match what OpenGL reports */
+    void glStateCheck(const char* what, GLenum query, GLuint cached)
+    {
+#ifndef NDEBUG
+        GLint actual = 0;
+        glGetIntegerv(query, &actual);
+        if(GLuint(actual) != cached)
+        {
+            std::cerr << "[GLState] Cached " << what << " " << cached << " doesn't match the bound " << actual << std::endl;
+            glState().stats.mismatches++;
+        }
+#else
+        (void) what;
+        (void) query;
+        (void) cached;
+#endif
+    }
+
+    void glStateCheckEnabled(GLenum capability, GLuint cached)
+    {
+#ifndef NDEBUG
+        GLuint actual = glIsEnabled(capability) ? 1 : 0;
+        if(actual != cached)
+        {
+            std::cerr << "[GLState] Cached enable flag 0x" << std::hex << capability << std::dec << " = " << cached << " doesn't match " << actual << std::endl;
+            glState().stats.mismatches++;
+        }
+#else
+        (void) capability;
+        (void) cached;
+#endif
+    }
+
+    /* returns true if the call has to be issued and updates the cache */
+    bool glStateChange(GLuint& cached, GLuint value, const char* what, GLenum query)
+    {
+        GLState& state = glState();
+        if(cached == value)
+        {
+            state.stats.elided++;
+            glStateCheck(what, query, cached);
+            return false;
+        }
+        cached = value;
+        state.stats.issued++;
+        return true;
+    }
+
+    void glStateActiveUnit(GLuint unit)
+    {
+        if(glStateChange(glState().activeTexture, GL_TEXTURE0 + unit, "texture unit", GL_ACTIVE_TEXTURE))
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+    }
+}
+
+void glStateUseProgram(GLuint program)
+{
+    if(detail::glStateChange(detail::glState().program, program, "program", GL_CURRENT_PROGRAM))
+    {
+        glUseProgram(program);
+    }
+}
+
+void glStateBindVertexArray(GLuint vao)
+{
+    detail::GLState& state = detail::glState();
+    if(detail::glStateChange(state.vao, vao, "vertex array", GL_VERTEX_ARRAY_BINDING))
+    {
+        glBindVertexArray(vao);
+        state.buffers[detail::GLSTATE_ELEMENT_ARRAY_SLOT] = detail::GLSTATE_UNKNOWN;
+    }
+}
+
+void glStateBindBuffer(GLenum target, GLuint buffer)
+{
+    int slot = detail::glStateSlot(detail::glStateBufferTargets, target);
+    if(slot < 0)
+    {
+        detail::glState().stats.issued++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if(detail::glStateChange(detail::glState().buffers[slot], buffer, "buffer", detail::glStateBufferQueries[slot]))
+    {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void glStateBindTexture(unsigned int unit, GLenum target, GLuint texture)
+{
+    int slot = detail::glStateSlot(detail::glStateTextureTargets, target);
+    if(slot < 0 || unit >= GLSTATE_TEXTURE_UNITS)
+    {
+        detail::glStateActiveUnit(unit);
+        detail::glState().stats.issued++;
+        glBindTexture(target, texture);
+        return;
+    }
+
+    /* the unit only has to be activated if the binding changes */
+    detail::GLState& state = detail::glState();
+    if(state.textures[unit][slot] == texture)
+    {
+        state.stats.elided++;
+#ifndef NDEBUG
+        /* texture bindings can only be queried for the active unit */
+        if(state.activeTexture == GL_TEXTURE0 + unit)
+        {
+            detail::glStateCheck("texture", detail::glStateTextureQueries[slot], texture);
+        }
+#endif
+        return;
+    }
+    detail::glStateActiveUnit(unit);
+    state.textures[unit][slot] = texture;
+    state.stats.issued++;
+    glBindTexture(target, texture);
+}
+
+void glStateSetEnabled(GLenum capability, bool enabled)
+{
+    int slot = detail::glStateSlot(detail::glStateCapabilities, capability);
+    detail::GLState& state = detail::glState();
+    if(slot >= 0 && state.capabilities[slot] == GLuint(enabled))
+    {
+        state.stats.elided++;
+        detail::glStateCheckEnabled(capability, state.capabilities[slot]);
+        return;
+    }
+    if(slot >= 0)
+    {
+        state.capabilities[slot] = GLuint(enabled);
+    }
+    state.stats.issued++;
+    if(enabled)
+    {
+        glEnable(capability);
+    }
+    else
+    {
+        glDisable(capability);
+    }
+}
+
+void glStateEnable(GLenum capability)
+{
+    glStateSetEnabled(capability, true);
+}
+
+void glStateDisable(GLenum capability)
+{
+    glStateSetEnabled(capability, false);
+}
+
+void glStateDeleteBuffer(GLuint buffer)
+{
+    for(GLuint& bound : detail::glState().buffers)
+    {
+        if(bound == buffer)
+        {
+            bound = 0;
+        }
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void glStateDeleteVertexArray(GLuint vao)
+{
+    detail::GLState& state = detail::glState();
+    if(state.vao == vao)
+    {
+        state.vao = 0;
+        state.buffers[detail::GLSTATE_ELEMENT_ARRAY_SLOT] = detail::GLSTATE_UNKNOWN;
+    }
+    glDeleteVertexArrays(1, &vao);
+}
+
+void glStateDeleteTexture(GLuint texture)
+{
+    for(auto& unit : detail::glState().textures)
+    {
+        for(GLuint& bound : unit)
+        {
+            if(bound == texture)
+            {
+                bound = 0;
+            }
+        }
+    }
+    glDeleteTextures(1, &texture);
+}
+
+void glStateInvalidate()
+{
+    detail::GLState& state = detail::glState();
+    detail::glStateForget(state);
+}
+
+unsigned int glStateValidate()
+{
+    detail::GLState& state = detail::glState();
+    unsigned int mismatches = 0;
+
+    auto check = [&](const char* what, GLenum query, GLuint cached)
+    {
+        if(cached == detail::GLSTATE_UNKNOWN)
+        {
+            return;
+        }
+        GLint actual = 0;
+        glGetIntegerv(query, &actual);
+        if(GLuint(actual) != cached)
+        {
+            std::cerr << "[GLState] Cached " << what << " " << cached << " doesn't match the bound " << actual << std::endl;
+            mismatches++;
+        }
+    };
+
+    check("program", GL_CURRENT_PROGRAM, state.program);
+    check("vertex array", GL_VERTEX_ARRAY_BINDING, state.vao);
+    for(unsigned int i = 0; i < detail::GLSTATE_BUFFER_TARGETS; i++)
+    {
+        check("buffer", detail::glStateBufferQueries[i], state.buffers[i]);
+    }
+    for(unsigned int i = 0; i < detail::GLSTATE_CAPABILITIES; i++)
+    {
+        if(state.capabilities[i] != detail::GLSTATE_UNKNOWN && GLuint(glIsEnabled(detail::glStateCapabilities[i]) ? 1 : 0) != state.capabilities[i])
+        {
+            std::cerr << "[GLState] Cached enable flag 0x" << std::hex << detail::glStateCapabilities[i] << std::dec << " doesn't match" << std::endl;
+            mismatches++;
+        }
+    }
+
+    GLint activeTexture = 0;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+    check("texture unit", GL_ACTIVE_TEXTURE, state.activeTexture);
+    for(unsigned int unit = 0; unit < GLSTATE_TEXTURE_UNITS; unit++)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        for(unsigned int i = 0; i < detail::GLSTATE_TEXTURE_TARGETS; i++)
+        {
+            check("texture", detail::glStateTextureQueries[i], state.textures[unit][i]);
+        }
+    }
+    glActiveTexture(GLenum(activeTexture));
+
+    state.stats.mismatches += mismatches;
+    return mismatches;
+}
+
+const GLStateStats& glStateStats()
+{
+    return detail::glState().stats;
+}
+
+void glStateResetStats()
+{
+    detail::glState().stats = GLStateStats();
+}
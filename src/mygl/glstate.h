@@ -0,0 +1,110 @@
+#pragma once
+
+#include "base.h"
+
+#include <cstdint>
+
+/* texture units tracked by the state cache, binds to higher units are passed through */
+constexpr unsigned int GLSTATE_TEXTURE_UNITS = 16;
+
+/* counters since the last glStateResetStats() */
+struct GLStateStats
+{
+    /* state changing calls passed on to OpenGL */
+    uint64_t issued = 0;
+
+    /* calls skipped because the state was already set */
+    uint64_t elided = 0;
+
+    /* debug builds only: cached values that didn't match glGet* */
+    uint64_t mismatches = 0;
+};
+
+/**
+ * Thin cache in front of the OpenGL binding and enable calls. The currently bound program, VAO, buffers, textures and
+ * enable flags are shadowed, calls that would not change anything are skipped. All state starts as unknown, so the
+ * first call of each kind is always issued.
+ *
+ * Code that changes the same state with the plain gl* functions has to call glStateInvalidate() afterwards. In debug
+ * builds (NDEBUG not defined) every skipped call is checked against glGet*, mismatches are reported and counted.
+ */
+
+/**
+ * @brief glUseProgram through the cache.
+ */
+void glStateUseProgram(GLuint program);
+
+/**
+ * @brief glBindVertexArray through the cache. The element array buffer binding is part of the VAO, so it becomes
+ * unknown when the VAO changes.
+ */
+void glStateBindVertexArray(GLuint vao);
+
+/**
+ * @brief glBindBuffer through the cache. Array, element array, copy, pixel pack/unpack and uniform buffer targets are
+ * tracked, other targets are passed through.
+ *
+ * @param target Buffer target.
+ * @param buffer Buffer name, 0 to unbind.
+ */
+void glStateBindBuffer(GLenum target, GLuint buffer);
+
+/**
+ * @brief Bind a texture to a texture unit, glActiveTexture is only called if the unit changes.
+ *
+ * @param unit Texture unit index (0 for GL_TEXTURE0).
+ * @param target Texture target (2D, 3D, cube map, 2D array or 2D multisample).
+ * @param texture Texture name, 0 to unbind.
+ */
+void glStateBindTexture(unsigned int unit, GLenum target, GLuint texture);
+
+/**
+ * @brief glEnable / glDisable through the cache. Depth test, culling, blending, scissor and stencil test, polygon
+ * offset, multisampling, sRGB framebuffer, primitive restart, depth clamp, program point size and seamless cube maps
+ * are tracked, other capabilities are passed through.
+ *
+ * @param capability Capability to change.
+ * @param enabled New state.
+ */
+void glStateSetEnabled(GLenum capability, bool enabled);
+void glStateEnable(GLenum capability);
+void glStateDisable(GLenum capability);
+
+/**
+ * @brief Delete objects through the cache, bindings of deleted objects revert to 0 like in OpenGL. Programs need no
+ * wrapper, a program in use is only flagged for deletion and stays current.
+ */
+void glStateDeleteBuffer(GLuint buffer);
+void glStateDeleteVertexArray(GLuint vao);
+void glStateDeleteTexture(GLuint texture);
+
+/**
+ * @brief Forget all cached state, e.g. after a new context was made current or state was changed without the cache.
+ */
+void glStateInvalidate();
+
+/**
+ * @brief Compare all known cached state with glGet* and report every difference on std::cerr. Changes the active
+ * texture unit temporarily.
+ *
+ * @return Number of differences.
+ *
+ * usage:
+ *
+ *   glStateUseProgram(myShader.id);
+ *   glStateBindVertexArray(myMesh.vao);
+ *   assert(glStateValidate() == 0);
+ *   // glStateStats().issued, glStateStats().elided, ...
+ *
+ */
+unsigned int glStateValidate();
+
+/**
+ * @brief Counters of issued and skipped calls.
+ */
+const GLStateStats& glStateStats();
+
+/**
+ * @brief Reset the counters, e.g. at the start of every frame.
+ */
+void glStateResetStats();
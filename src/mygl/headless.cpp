@@ -0,0 +1,366 @@
+#include "headless.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#ifdef MYGL_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace detail
+{
+    double headlessSeconds()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+#ifdef MYGL_EGL
+    bool headlessHasExtension(const char* extensions, const char* name)
+    {
+        if(!extensions)
+        {
+            return false;
+        }
+        const std::size_t length = std::strlen(name);
+        for(const char* at = std::strstr(extensions, name); at; at = std::strstr(at + length, name))
+        {
+            if((at == extensions || at[-1] == ' ') && (at[length] == ' ' || at[length] == '\0'))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool headlessCreateEGL(Headless& headless)
+    {
+        /* the surfaceless platform needs no X or Wayland display, the default display is the fallback */
+        EGLDisplay display = EGL_NO_DISPLAY;
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if(getPlatformDisplay && headlessHasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+        {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if(display == EGL_NO_DISPLAY)
+        {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        if(display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        {
+            return false;
+        }
+
+        const bool surfaceless = headlessHasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+        const EGLint configAttributes[] = {EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+                                           EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        EGLConfig config = nullptr;
+        EGLint configCount = 0;
+        if(!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+        {
+            eglTerminate(display);
+            return false;
+        }
+
+        const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+                                            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE};
+        EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        if(context == EGL_NO_CONTEXT)
+        {
+            eglTerminate(display);
+            return false;
+        }
+
+        /* all rendering goes to the framebuffer object, the surface (if the context needs one) is never drawn to */
+        EGLSurface surface = EGL_NO_SURFACE;
+        if(!surfaceless)
+        {
+            const EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+            surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        }
+        if((!surfaceless && surface == EGL_NO_SURFACE) || !eglMakeCurrent(display, surface, surface, context))
+        {
+            eglDestroyContext(display, context);
+            eglTerminate(display);
+            return false;
+        }
+
+        headless._eglDisplay = display;
+        headless._eglContext = context;
+        headless._eglSurface = surface;
+        headless.backend = surfaceless ? "EGL surfaceless" : "EGL pbuffer";
+        return gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)) != 0;
+    }
+
+    void headlessDeleteEGL(Headless& headless)
+    {
+        EGLDisplay display = headless._eglDisplay;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if(headless._eglSurface != EGL_NO_SURFACE)
+        {
+            eglDestroySurface(display, headless._eglSurface);
+        }
+        eglDestroyContext(display, headless._eglContext);
+        eglTerminate(display);
+        headless._eglDisplay = nullptr;
+    }
+#endif
+
+    bool headlessCreateWindow(Headless& headless)
+    {
+        if(!glfwInit())
+        {
+            return false;
+        }
+
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+        headless._window = glfwCreateWindow(int(headless.width), int(headless.height), "headless", nullptr, nullptr);
+        if(!headless._window)
+        {
+            glfwTerminate();
+            return false;
+        }
+        glfwMakeContextCurrent(headless._window);
+        glfwSwapInterval(0);
+
+        headless.backend = "hidden GLFW window";
+        return gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)) != 0;
+    }
+
+    /* reads the query of a frame, waiting for it only if asked to */
+    void headlessRecordQuery(Headless& headless, unsigned int frame, bool wait)
+    {
+        const unsigned int slot = frame % HEADLESS_QUERY_LAG;
+        headless._queriesRead++;
+
+        GLint available = GL_TRUE;
+        if(!wait)
+        {
+            glGetQueryObjectiv(headless._queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        }
+        GLuint64 nanoseconds = 0;
+        if(available == GL_TRUE)
+        {
+            glGetQueryObjectui64v(headless._queries[slot], GL_QUERY_RESULT, &nanoseconds);
+        }
+
+        /* the warm-up frames only fill the lag, some drivers also return garbage for the very first query */
+        if(frame < HEADLESS_QUERY_LAG)
+        {
+            return;
+        }
+
+        /* the GPU can't have spent longer on a frame than has passed since it began */
+        const double ms = double(nanoseconds) * 1e-6;
+        const double wallMs = (headlessSeconds() - headless._queryStart[slot]) * 1000.0;
+        if(available != GL_TRUE || ms > wallMs)
+        {
+            headless.gpuRejected++;
+            return;
+        }
+        headless.gpuMs.push_back(ms);
+    }
+
+    /* statistics over values from warmup on, the frames array has all of them */
+    void headlessWriteTimings(std::ofstream& file, const char* name, const std::vector<double>& values, std::size_t warmup)
+    {
+        const TimingStats stats = timingStats(values, warmup);
+        file << "  \"" << name << "\": {\n";
+        file << "    \"mean\": " << stats.mean << ",\n";
+        file << "    \"min\": " << stats.min << ",\n";
+        file << "    \"p50\": " << stats.p50 << ",\n";
+        file << "    \"p95\": " << stats.p95 << ",\n";
+        file << "    \"p99\": " << stats.p99 << ",\n";
+        file << "    \"max\": " << stats.max << ",\n";
+        file << "    \"frames\": [";
+        for(std::size_t i = 0; i < values.size(); i++)
+        {
+            file << (i > 0 ? ", " : "") << values[i];
+        }
+        file << "]\n  }";
+    }
+}
+
+HeadlessOptions headlessParseArgs(int argc, char** argv)
+{
+    HeadlessOptions options;
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if(argument == "--headless")
+        {
+            options.enabled = true;
+        }
+        else if(argument == "--frames" && hasValue)
+        {
+            options.enabled = true;
+            options.frames = unsigned(std::max(1, std::atoi(argv[++i])));
+        }
+        else if(argument == "--size" && hasValue)
+        {
+            unsigned int width = 0, height = 0;
+            if(std::sscanf(argv[++i], "%ux%u", &width, &height) == 2 && width > 0 && height > 0)
+            {
+                options.width = width;
+                options.height = height;
+            }
+            else
+            {
+                std::cerr << "[Headless] Ignoring --size " << argv[i] << ", expected WxH" << std::endl;
+            }
+        }
+        else if(argument == "--report" && hasValue)
+        {
+            options.report = argv[++i];
+        }
+    }
+    return options;
+}
+
+Headless* headlessCreate(unsigned int width, unsigned int height)
+{
+    Headless* headless = new Headless();
+    headless->width = width;
+    headless->height = height;
+
+    bool created = false;
+#ifdef MYGL_EGL
+    created = detail::headlessCreateEGL(*headless);
+#endif
+    if(!created && !headless->_eglDisplay)
+    {
+        created = detail::headlessCreateWindow(*headless);
+    }
+    if(!created)
+    {
+        std::cerr << "[Headless] Couldn't create an offscreen GL context" << std::endl;
+        headlessDelete(headless);
+        return nullptr;
+    }
+
+    glGenRenderbuffers(1, &headless->colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, GLsizei(width), GLsizei(height));
+    glGenRenderbuffers(1, &headless->depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, GLsizei(width), GLsizei(height));
+
+    glGenFramebuffers(1, &headless->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, headless->fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless->colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, headless->depthBuffer);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "[Headless] Framebuffer of " << width << "x" << height << " is incomplete" << std::endl;
+        headlessDelete(headless);
+        return nullptr;
+    }
+    glViewport(0, 0, GLsizei(width), GLsizei(height));
+
+    glGenQueries(GLsizei(HEADLESS_QUERY_LAG), headless->_queries);
+    return headless;
+}
+
+void headlessBeginFrame(Headless& headless)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, headless.fbo);
+    headless._frameStart = detail::headlessSeconds();
+    headless._queryStart[headless._frame % HEADLESS_QUERY_LAG] = headless._frameStart;
+    glBeginQuery(GL_TIME_ELAPSED, headless._queries[headless._frame % HEADLESS_QUERY_LAG]);
+}
+
+void headlessEndFrame(Headless& headless)
+{
+    glEndQuery(GL_TIME_ELAPSED);
+
+    /* there is no swap, flush so that the driver starts on the frame */
+    glFlush();
+    headless.cpuMs.push_back((detail::headlessSeconds() - headless._frameStart) * 1000.0);
+
+    /* the query about to be reused is HEADLESS_QUERY_LAG frames old, waiting for it throttles like a swap chain */
+    headless._frame++;
+    if(headless._frame >= HEADLESS_QUERY_LAG)
+    {
+        detail::headlessRecordQuery(headless, headless._frame - HEADLESS_QUERY_LAG, true);
+    }
+}
+
+bool headlessWriteReport(Headless& headless, const std::string& path, const std::string& name)
+{
+    /* the queries of the last frames are still pending */
+    glFinish();
+    for(unsigned int frame = headless._queriesRead; frame < headless._frame; frame++)
+    {
+        detail::headlessRecordQuery(headless, frame, false);
+    }
+
+    std::ofstream file(path);
+    if(!file.is_open())
+    {
+        std::cerr << "[Headless] Couldn't write report " << path << std::endl;
+        return false;
+    }
+
+    const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    file << std::fixed << std::setprecision(4);
+    file << "{\n";
+    file << "  \"name\": \"" << name << "\",\n";
+    file << "  \"backend\": \"" << headless.backend << "\",\n";
+    file << "  \"renderer\": \"" << (renderer ? renderer : "") << "\",\n";
+    file << "  \"width\": " << headless.width << ",\n";
+    file << "  \"height\": " << headless.height << ",\n";
+    file << "  \"frames\": " << headless._frame << ",\n";
+    file << "  \"warmupFrames\": " << std::min(headless._frame, HEADLESS_QUERY_LAG) << ",\n";
+    file << "  \"gpuRejected\": " << headless.gpuRejected << ",\n";
+    detail::headlessWriteTimings(file, "cpuMs", headless.cpuMs, HEADLESS_QUERY_LAG);
+    file << ",\n";
+    detail::headlessWriteTimings(file, "gpuMs", headless.gpuMs, 0);
+    file << "\n}\n";
+    return file.good();
+}
+
+void headlessDelete(Headless* headless)
+{
+    if(!headless)
+    {
+        return;
+    }
+
+    if(headless->fbo)
+    {
+        glDeleteQueries(GLsizei(HEADLESS_QUERY_LAG), headless->_queries);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &headless->fbo);
+        glDeleteRenderbuffers(1, &headless->colorBuffer);
+        glDeleteRenderbuffers(1, &headless->depthBuffer);
+    }
+
+#ifdef MYGL_EGL
+    if(headless->_eglDisplay)
+    {
+        detail::headlessDeleteEGL(*headless);
+    }
+#endif
+    if(headless->_window)
+    {
+        glfwDestroyWindow(headless->_window);
+        glfwTerminate();
+    }
+    delete headless;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "base.h"
+
+#include <string>
+#include <vector>
+
+/* GPU timer queries in flight, results are read HEADLESS_QUERY_LAG frames later when they are normally done */
+constexpr unsigned int HEADLESS_QUERY_LAG = 4;
+
+/* command line of a headless run: --headless, --frames N, --size WxH, --report path (--frames alone implies --headless) */
+struct HeadlessOptions
+{
+    bool enabled = false;
+    unsigned int frames = 300;
+    unsigned int width = 1280;
+    unsigned int height = 720;
+    std::string report = "headless_report.json";
+};
+
+/**
+ * Offscreen rendering without a visible window: an EGL surfaceless context (Mesa llvmpipe works, needs MYGL_EGL) or, if
+ * that fails, a hidden GLFW window. Frames are rendered into a framebuffer object of the requested size, there is no
+ * swap and no vsync. CPU and GPU time of every frame is recorded for the report.
+ */
+struct Headless
+{
+    unsigned int width = 0;
+    unsigned int height = 0;
+
+    /* framebuffer with an RGBA8 color and a depth renderbuffer, bound for the whole run */
+    GLuint fbo = 0;
+    GLuint colorBuffer = 0;
+    GLuint depthBuffer = 0;
+
+    /* "EGL surfaceless", "EGL pbuffer" or "hidden GLFW window" */
+    std::string backend;
+
+    /*
+     * milliseconds per frame. The first HEADLESS_QUERY_LAG frames fill the query lag and are left out of the statistics,
+     * their GPU times are not recorded at all. GPU times of rejected queries (result not available, or longer than the
+     * wall time since the frame began) are left out and counted.
+     */
+    std::vector<double> cpuMs;
+    std::vector<double> gpuMs;
+    unsigned int gpuRejected = 0;
+
+    void* _eglDisplay = nullptr;
+    void* _eglContext = nullptr;
+    void* _eglSurface = nullptr;
+    GLFWwindow* _window = nullptr;
+
+    GLuint _queries[HEADLESS_QUERY_LAG] = {};
+    double _queryStart[HEADLESS_QUERY_LAG] = {};
+    unsigned int _queriesRead = 0;
+    unsigned int _frame = 0;
+    double _frameStart = 0.0;
+};
+
+/**
+ * @brief Parse the headless options, unknown arguments are ignored.
+ *
+ * @param argc Argument count of main.
+ * @param argv Arguments of main.
+ *
+ * @return Options, enabled if --headless or --frames was given.
+ */
+HeadlessOptions headlessParseArgs(int argc, char** argv);
+
+/**
+ * @brief Create a context without a visible window and the framebuffer all frames are rendered to. GLFW is not
+ * initialized with the EGL backend, glfw* functions other than glfwGetProcAddress must not be used.
+ *
+ * @param width Framebuffer width.
+ * @param height Framebuffer height.
+ *
+ * @return Headless context with its framebuffer bound, nullptr if no backend works.
+ *
+ * usage:
+ *
+ *   HeadlessOptions options = headlessParseArgs(argc, argv);
+ *   Headless* headless = headlessCreate(options.width, options.height);
+ *   for(unsigned int i = 0; i < options.frames; i++)
+ *   {
+ *       headlessBeginFrame(*headless);
+ *       sceneDraw();
+ *       headlessEndFrame(*headless);
+ *   }
+ *   headlessWriteReport(*headless, options.report, "assignment_1");
+ *   headlessDelete(headless);
+ *
+ */
+Headless* headlessCreate(unsigned int width, unsigned int height);
+
+/**
+ * @brief Start timing a frame, binds the framebuffer.
+ *
+ * @param headless Headless context.
+ */
+void headlessBeginFrame(Headless& headless);
+
+/**
+ * @brief Finish timing a frame. Records the CPU time and the GPU time of the frame HEADLESS_QUERY_LAG frames back.
+ *
+ * @param headless Headless context.
+ */
+void headlessEndFrame(Headless& headless);
+
+/**
+ * @brief Wait for the GPU and write frame count, backend, GL renderer, framebuffer size, CPU and GPU timings (mean,
+ * percentiles without the warm-up frames, every frame) and the number of rejected GPU queries as JSON.
+ *
+ * @param headless Headless context.
+ * @param path Path of the report.
+ * @param name Name of the run in the report.
+ *
+ * @return True if the report was written.
+ */
+bool headlessWriteReport(Headless& headless, const std::string& path, const std::string& name);
+
+/**
+ * @brief Delete the framebuffer and the context.
+ *
+ * @param headless Headless context to delete.
+ */
+void headlessDelete(Headless* headless);
@@ -0,0 +1,978 @@
+#include "importer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace detail
+{
+    void importError(const std::string& message)
+    {
+        std::cerr << "[Importer] " << message << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[Importer] " + message);
+    }
+
+    using PoolPtr = std::unique_ptr<ThreadPool, void (*)(ThreadPool*)>;
+
+    /* use the pool of the options or create a temporary one */
+    PoolPtr importPool(const ImportOptions& options)
+    {
+        if(options.pool)
+        {
+            return PoolPtr(options.pool, [](ThreadPool*) {});
+        }
+        return PoolPtr(threadPoolCreate(options.threads), threadPoolDelete);
+    }
+
+    unsigned int chunksInFlight(const ImportOptions& options, const ThreadPool* pool)
+    {
+        return options.maxChunksInFlight > 0 ? options.maxChunksInFlight : 2 * (unsigned int) pool->workers.size();
+    }
+
+    /* waits for all queued tasks when it goes out of scope, tasks writing into the output must not outlive an error */
+    template<typename T>
+    struct FutureDrain
+    {
+        std::deque<std::future<T>>& futures;
+
+        ~FutureDrain()
+        {
+            for(std::future<T>& future : futures)
+            {
+                if(future.valid()) { future.wait(); }
+            }
+        }
+    };
+
+    /*------------------------ text parsing ------------------------*/
+
+    inline const char* skipSpace(const char* p, const char* end)
+    {
+        while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')) { p++; }
+        return p;
+    }
+
+    inline const char* skipLine(const char* p, const char* end)
+    {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', std::size_t(end - p)));
+        return newline ? newline + 1 : end;
+    }
+
+    /* from_chars style number parsing, p is advanced behind the number on success */
+    template<typename T>
+    inline bool parseNumber(const char*& p, const char* end, T& value)
+    {
+        p = skipSpace(p, end);
+        if(p < end && *p == '+') { p++; }
+
+#if defined(__cpp_lib_to_chars)
+        auto result = std::from_chars(p, end, value);
+        if(result.ec != std::errc()) { return false; }
+        p = result.ptr;
+#else
+        /* fallback for standard libraries without floating point from_chars, chunks are null terminated */
+        char* last = nullptr;
+        if constexpr(std::is_floating_point_v<T>) { value = T(std::strtod(p, &last)); }
+        else                                      { value = T(std::strtoll(p, &last, 10)); }
+        if(last == p || last > end) { return false; }
+        p = last;
+#endif
+        return true;
+    }
+
+    /* read the file in chunks ending at line boundaries, parse them on the pool and merge the results in file order */
+    template<typename Result, typename Parse, typename Merge>
+    void streamLines(std::istream& in, const ImportOptions& options, ThreadPool* pool, ImportStats& stats, Parse parse, Merge merge)
+    {
+        const std::size_t chunkSize = std::max<std::size_t>(options.chunkSize, 1024);
+        const unsigned int maxInFlight = chunksInFlight(options, pool);
+
+        std::deque<std::future<Result>> inFlight;
+        std::vector<char> carry;
+
+        bool eof = false;
+        while(!eof)
+        {
+            auto buffer = std::make_shared<std::vector<char>>();
+            buffer->reserve(carry.size() + chunkSize + 1);
+            buffer->assign(carry.begin(), carry.end());
+            buffer->resize(carry.size() + chunkSize);
+
+            in.read(buffer->data() + carry.size(), std::streamsize(chunkSize));
+            std::size_t read = std::size_t(in.gcount());
+            buffer->resize(carry.size() + read);
+            eof = read < chunkSize;
+            stats.bytes += read;
+
+            /* cut at the last newline, the partial line is carried over into the next chunk */
+            std::size_t cut = buffer->size();
+            if(!eof)
+            {
+                while(cut > 0 && (*buffer)[cut - 1] != '\n') { cut--; }
+                if(cut == 0)
+                {
+                    carry.swap(*buffer);
+                    continue;
+                }
+            }
+            carry.assign(buffer->begin() + std::ptrdiff_t(cut), buffer->end());
+            buffer->resize(cut);
+            buffer->push_back('\0');
+
+            auto task = std::make_shared<std::packaged_task<Result()>>([buffer, parse]() {
+                Result result;
+                parse(buffer->data(), buffer->data() + buffer->size() - 1, result);
+                return result;
+            });
+            inFlight.push_back(task->get_future());
+            threadPoolSubmit(pool, [task]() { (*task)(); });
+            stats.chunks++;
+
+            while(inFlight.size() >= maxInFlight)
+            {
+                merge(inFlight.front().get());
+                inFlight.pop_front();
+            }
+        }
+
+        while(!inFlight.empty())
+        {
+            merge(inFlight.front().get());
+            inFlight.pop_front();
+        }
+    }
+
+    /*------------------------ OBJ ------------------------*/
+
+    /* relative (negative) face indices are stored biased, relative to the vertex count of their chunk */
+    constexpr int64_t OBJ_RELATIVE_BIAS = int64_t(1) << 40;
+
+    struct ObjChunk
+    {
+        std::vector<Vertex> vertices;
+        std::vector<int64_t> faces;
+    };
+
+    void parseObjChunk(const char* p, const char* end, const Vector4D& color, ObjChunk& chunk)
+    {
+        std::vector<int64_t> polygon;
+
+        while(p < end)
+        {
+            p = skipSpace(p, end);
+
+            if(end - p > 1 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+            {
+                p++;
+                float values[6];
+                int count = 0;
+                while(count < 6 && parseNumber(p, end, values[count])) { count++; }
+
+                if(count < 3)
+                {
+                    importError("Invalid vertex in OBJ file");
+                }
+                Vector4D vertexColor = count == 6 ? Vector4D(values[3], values[4], values[5], 1.0f) : color;
+                chunk.vertices.push_back({{values[0], values[1], values[2]}, vertexColor});
+            }
+            else if(end - p > 1 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+            {
+                p++;
+                polygon.clear();
+
+                int64_t index;
+                while(parseNumber(p, end, index))
+                {
+                    if(index == 0)
+                    {
+                        importError("Invalid vertex index 0 in OBJ file");
+                    }
+                    int64_t local = int64_t(chunk.vertices.size());
+                    polygon.push_back(index > 0 ? index - 1 : local + index - OBJ_RELATIVE_BIAS);
+
+                    /* skip texture coordinate and normal indices */
+                    while(p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') { p++; }
+                }
+
+                for(std::size_t i = 2; i < polygon.size(); i++)
+                {
+                    chunk.faces.push_back(polygon[0]);
+                    chunk.faces.push_back(polygon[i - 1]);
+                    chunk.faces.push_back(polygon[i]);
+                }
+            }
+
+            p = skipLine(p, end);
+        }
+    }
+
+    /*------------------------ PLY ------------------------*/
+
+    enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+    struct PlyProperty
+    {
+        std::string name;
+        PlyType type = PlyType::Float32;
+        bool isList = false;
+        PlyType countType = PlyType::UInt8;
+    };
+
+    struct PlyElement
+    {
+        std::string name;
+        uint64_t count = 0;
+        std::vector<PlyProperty> properties;
+    };
+
+    enum class PlyFormat { Ascii, BinaryLittleEndian, BinaryBigEndian };
+
+    struct PlyHeader
+    {
+        PlyFormat format = PlyFormat::Ascii;
+        std::vector<PlyElement> elements;
+    };
+
+    PlyType plyType(const std::string& name)
+    {
+        if(name == "char" || name == "int8")        { return PlyType::Int8; }
+        if(name == "uchar" || name == "uint8")      { return PlyType::UInt8; }
+        if(name == "short" || name == "int16")      { return PlyType::Int16; }
+        if(name == "ushort" || name == "uint16")    { return PlyType::UInt16; }
+        if(name == "int" || name == "int32")        { return PlyType::Int32; }
+        if(name == "uint" || name == "uint32")      { return PlyType::UInt32; }
+        if(name == "float" || name == "float32")    { return PlyType::Float32; }
+        if(name == "double" || name == "float64")   { return PlyType::Float64; }
+        importError("Unknown PLY property type " + name);
+        return PlyType::Float32;
+    }
+
+    std::size_t plySize(PlyType type)
+    {
+        switch(type)
+        {
+            case PlyType::Int8:  case PlyType::UInt8:   return 1;
+            case PlyType::Int16: case PlyType::UInt16:  return 2;
+            case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+            case PlyType::Float64: return 8;
+        }
+        return 0;
+    }
+
+    /* scale that maps integer colors to 0..1 */
+    float plyColorScale(PlyType type)
+    {
+        switch(type)
+        {
+            case PlyType::UInt8:  return 1.0f / 255.0f;
+            case PlyType::UInt16: return 1.0f / 65535.0f;
+            default:              return 1.0f;
+        }
+    }
+
+    /* size of one record, 0 if the element contains list properties */
+    std::size_t plyRecordSize(const PlyElement& element)
+    {
+        std::size_t size = 0;
+        for(const PlyProperty& property : element.properties)
+        {
+            if(property.isList) { return 0; }
+            size += plySize(property.type);
+        }
+        return size;
+    }
+
+    /* smallest record of an element: lists without entries in binary files, at least one byte per row in ASCII files */
+    uint64_t plyMinRecordSize(const PlyElement& element, PlyFormat format)
+    {
+        uint64_t size = 0;
+        for(const PlyProperty& property : element.properties)
+        {
+            size += plySize(property.isList ? property.countType : property.type);
+        }
+        return format == PlyFormat::Ascii ? 1 : std::max<uint64_t>(size, 1);
+    }
+
+    /* element counts come from the header, they have to fit into the rest of the file before anything is allocated */
+    void validatePlyCounts(const PlyHeader& header, uint64_t bodyBytes, const std::string& filepath)
+    {
+        for(const PlyElement& element : header.elements)
+        {
+            const uint64_t recordSize = plyMinRecordSize(element, header.format);
+            if(element.count > bodyBytes / recordSize)
+            {
+                importError("PLY element " + element.name + " with " + std::to_string(element.count) + " rows doesn't fit into "
+                            + filepath);
+            }
+            bodyBytes -= element.count * recordSize;
+        }
+    }
+
+    /* list counts are checked before the cast, a negative, fractional or huge count must not reach a size computation */
+    uint64_t plyListCount(double count, uint64_t maxCount, const std::string& filepath)
+    {
+        if(!(count >= 0.0 && count <= double(maxCount)) || count != std::floor(count))
+        {
+            importError("Invalid list count in PLY file " + filepath);
+        }
+        return uint64_t(count);
+    }
+
+    PlyHeader readPlyHeader(std::istream& in, const std::string& filepath)
+    {
+        PlyHeader header;
+        std::string line;
+
+        std::getline(in, line);
+        if(line.rfind("ply", 0) != 0)
+        {
+            importError(filepath + " is no PLY file");
+        }
+
+        bool hasFormat = false;
+        while(std::getline(in, line))
+        {
+            if(!line.empty() && line.back() == '\r') { line.pop_back(); }
+
+            std::istringstream tokens(line);
+            std::string keyword;
+            tokens >> keyword;
+
+            if(keyword == "format")
+            {
+                std::string format;
+                tokens >> format;
+                if(format == "ascii")                       { header.format = PlyFormat::Ascii; }
+                else if(format == "binary_little_endian")   { header.format = PlyFormat::BinaryLittleEndian; }
+                else if(format == "binary_big_endian")      { header.format = PlyFormat::BinaryBigEndian; }
+                else { importError("Unknown PLY format " + format); }
+                hasFormat = true;
+            }
+            else if(keyword == "element")
+            {
+                PlyElement element;
+                tokens >> element.name >> element.count;
+                header.elements.push_back(element);
+            }
+            else if(keyword == "property")
+            {
+                if(header.elements.empty())
+                {
+                    importError("PLY property without element in " + filepath);
+                }
+
+                PlyProperty property;
+                std::string type;
+                tokens >> type;
+                if(type == "list")
+                {
+                    std::string countType, valueType;
+                    tokens >> countType >> valueType;
+                    property.isList = true;
+                    property.countType = plyType(countType);
+                    property.type = plyType(valueType);
+                }
+                else
+                {
+                    property.type = plyType(type);
+                }
+                tokens >> property.name;
+                header.elements.back().properties.push_back(property);
+            }
+            else if(keyword == "end_header")
+            {
+                if(!hasFormat)
+                {
+                    importError("PLY file without format " + filepath);
+                }
+                return header;
+            }
+        }
+
+        importError("PLY header without end_header in " + filepath);
+        return header;
+    }
+
+    /* property indices of the vertex attributes we use, -1 if not present */
+    struct PlyVertexLayout
+    {
+        int position[3] = {-1, -1, -1};
+        int color[4] = {-1, -1, -1, -1};
+        float colorScale[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    };
+
+    PlyVertexLayout plyVertexLayout(const PlyElement& element, const std::string& filepath)
+    {
+        static const char* positionNames[3] = {"x", "y", "z"};
+        static const char* colorNames[4] = {"red", "green", "blue", "alpha"};
+
+        PlyVertexLayout layout;
+        for(int i = 0; i < int(element.properties.size()); i++)
+        {
+            const PlyProperty& property = element.properties[i];
+            for(int c = 0; c < 3; c++)
+            {
+                if(property.name == positionNames[c]) { layout.position[c] = i; }
+            }
+            for(int c = 0; c < 4; c++)
+            {
+                if(property.name == colorNames[c])
+                {
+                    layout.color[c] = i;
+                    layout.colorScale[c] = plyColorScale(property.type);
+                }
+            }
+        }
+
+        if(layout.position[0] < 0 || layout.position[1] < 0 || layout.position[2] < 0)
+        {
+            importError("PLY vertex element without x, y, z in " + filepath);
+        }
+        return layout;
+    }
+
+    int plyFaceProperty(const PlyElement& element)
+    {
+        for(int i = 0; i < int(element.properties.size()); i++)
+        {
+            const PlyProperty& property = element.properties[i];
+            if(property.isList && (property.name == "vertex_indices" || property.name == "vertex_index"))
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    Vertex plyVertex(const double* values, const PlyVertexLayout& layout, const Vector4D& color)
+    {
+        Vertex vertex{{float(values[layout.position[0]]), float(values[layout.position[1]]), float(values[layout.position[2]])}, color};
+        for(int c = 0; c < 4; c++)
+        {
+            if(layout.color[c] >= 0) { vertex.color[c] = float(values[layout.color[c]]) * layout.colorScale[c]; }
+        }
+        return vertex;
+    }
+
+    void triangulate(const std::vector<int64_t>& polygon, uint64_t vertexCount, std::vector<unsigned int>& indices)
+    {
+        for(int64_t index : polygon)
+        {
+            if(index < 0 || uint64_t(index) >= vertexCount)
+            {
+                importError("Invalid vertex index " + std::to_string(index) + " in PLY file");
+            }
+        }
+        for(std::size_t i = 2; i < polygon.size(); i++)
+        {
+            indices.push_back((unsigned int) polygon[0]);
+            indices.push_back((unsigned int) polygon[i - 1]);
+            indices.push_back((unsigned int) polygon[i]);
+        }
+    }
+
+    /* ASCII body: numbers of each line, parsed in parallel and assigned to elements while merging */
+    struct PlyRows
+    {
+        std::vector<double> values;
+        std::vector<uint32_t> rowEnds;
+    };
+
+    void parsePlyRows(const char* p, const char* end, PlyRows& rows)
+    {
+        while(p < end)
+        {
+            const char* lineEnd = skipLine(p, end);
+            double value;
+            std::size_t rowStart = rows.values.size();
+            while(parseNumber(p, lineEnd, value)) { rows.values.push_back(value); }
+            if(rows.values.size() > rowStart)
+            {
+                rows.rowEnds.push_back(uint32_t(rows.values.size()));
+            }
+            p = lineEnd;
+        }
+    }
+
+    void importPlyAscii(std::istream& in, const PlyHeader& header, const ImportOptions& options, ThreadPool* pool, ImportStats& stats,
+                        std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const std::string& filepath)
+    {
+        std::size_t element = 0;
+        uint64_t row = 0;
+        uint64_t vertexCount = 0;
+        PlyVertexLayout layout;
+        std::vector<double> scalars;
+        std::vector<int64_t> polygon;
+
+        for(const PlyElement& e : header.elements)
+        {
+            if(e.name == "vertex")
+            {
+                vertexCount = e.count;
+                layout = plyVertexLayout(e, filepath);
+            }
+        }
+        vertices.reserve(vertexCount);
+
+        streamLines<PlyRows>(in, options, pool, stats, parsePlyRows, [&](PlyRows rows) {
+            uint32_t start = 0;
+            for(uint32_t rowEnd : rows.rowEnds)
+            {
+                while(element < header.elements.size() && row >= header.elements[element].count)
+                {
+                    element++;
+                    row = 0;
+                }
+                if(element == header.elements.size())
+                {
+                    return;
+                }
+
+                const PlyElement& e = header.elements[element];
+                const double* values = rows.values.data() + start;
+                const double* valuesEnd = rows.values.data() + rowEnd;
+                start = rowEnd;
+                row++;
+
+                bool isVertex = e.name == "vertex";
+                bool isFace = e.name == "face";
+                if(!isVertex && !isFace) { continue; }
+
+                /* split the row into scalar properties and the face index list */
+                scalars.clear();
+                polygon.clear();
+                const double* v = values;
+                for(const PlyProperty& property : e.properties)
+                {
+                    if(v >= valuesEnd)
+                    {
+                        importError("Truncated " + e.name + " in PLY file " + filepath);
+                    }
+                    if(property.isList)
+                    {
+                        const double listCount = *v++;
+                        const std::size_t count = std::size_t(plyListCount(listCount, uint64_t(valuesEnd - v), filepath));
+                        bool faceList = property.name == "vertex_indices" || property.name == "vertex_index";
+                        for(std::size_t i = 0; i < count; i++, v++)
+                        {
+                            if(faceList) { polygon.push_back(int64_t(*v)); }
+                        }
+                        scalars.push_back(0.0);
+                    }
+                    else
+                    {
+                        scalars.push_back(*v++);
+                    }
+                }
+
+                if(isVertex)
+                {
+                    vertices.push_back(plyVertex(scalars.data(), layout, options.color));
+                }
+                else
+                {
+                    triangulate(polygon, vertexCount, indices);
+                }
+            }
+        });
+    }
+
+    template<typename T>
+    inline T plyLoad(const char* p, bool swap)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, p, sizeof(T));
+        if(swap) { std::reverse(bytes, bytes + sizeof(T)); }
+        T value;
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    inline double plyBinaryValue(const char* p, PlyType type, bool swap)
+    {
+        switch(type)
+        {
+            case PlyType::Int8:     return double(int8_t(*p));
+            case PlyType::UInt8:    return double(uint8_t(*p));
+            case PlyType::Int16:    return double(plyLoad<int16_t>(p, swap));
+            case PlyType::UInt16:   return double(plyLoad<uint16_t>(p, swap));
+            case PlyType::Int32:    return double(plyLoad<int32_t>(p, swap));
+            case PlyType::UInt32:   return double(plyLoad<uint32_t>(p, swap));
+            case PlyType::Float32:  return double(plyLoad<float>(p, swap));
+            case PlyType::Float64:  return plyLoad<double>(p, swap);
+        }
+        return 0.0;
+    }
+
+    /* buffered sequential reader for variable sized binary records */
+    struct ByteReader
+    {
+        std::istream& in;
+        std::size_t chunkSize;
+        ImportStats& stats;
+        /* bytes of the body not handed out yet */
+        uint64_t left;
+        std::vector<char> buffer;
+        std::size_t pos = 0;
+
+        const char* read(std::size_t n)
+        {
+            if(buffer.size() - pos < n)
+            {
+                buffer.erase(buffer.begin(), buffer.begin() + std::ptrdiff_t(pos));
+                pos = 0;
+                std::size_t keep = buffer.size();
+                buffer.resize(keep + std::max(n, chunkSize));
+                in.read(buffer.data() + keep, std::streamsize(buffer.size() - keep));
+                std::size_t got = std::size_t(in.gcount());
+                buffer.resize(keep + got);
+                stats.bytes += got;
+                stats.chunks++;
+                if(buffer.size() < n)
+                {
+                    return nullptr;
+                }
+            }
+            const char* p = buffer.data() + pos;
+            pos += n;
+            left -= std::min<uint64_t>(left, n);
+            return p;
+        }
+    };
+
+    void importPlyBinary(std::istream& in, uint64_t bodyBytes, const PlyHeader& header, const ImportOptions& options, ThreadPool* pool,
+                         ImportStats& stats, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const std::string& filepath)
+    {
+        const bool swap = header.format == PlyFormat::BinaryBigEndian;
+        const std::size_t chunkSize = std::max<std::size_t>(options.chunkSize, 1024);
+        const unsigned int maxInFlight = chunksInFlight(options, pool);
+
+        uint64_t vertexCount = 0;
+        for(const PlyElement& e : header.elements)
+        {
+            if(e.name == "vertex") { vertexCount = e.count; }
+        }
+
+        ByteReader reader{in, chunkSize, stats, bodyBytes};
+        std::vector<int64_t> polygon;
+        std::vector<double> scalars;
+
+        for(const PlyElement& element : header.elements)
+        {
+            const std::size_t recordSize = plyRecordSize(element);
+
+            if(element.name == "vertex" && recordSize > 0)
+            {
+                /* fixed size records: convert batches in parallel directly into the output */
+                PlyVertexLayout layout = plyVertexLayout(element, filepath);
+                std::vector<std::size_t> offsets;
+                std::size_t offset = 0;
+                for(const PlyProperty& property : element.properties)
+                {
+                    offsets.push_back(offset);
+                    offset += plySize(property.type);
+                }
+
+                vertices.resize(element.count);
+                const uint64_t batch = std::max<uint64_t>(1, chunkSize / recordSize);
+                std::deque<std::future<void>> inFlight;
+                FutureDrain<void> drain{inFlight};
+
+                for(uint64_t first = 0; first < element.count; first += batch)
+                {
+                    uint64_t count = std::min(batch, element.count - first);
+                    const char* data = reader.read(count * recordSize);
+                    if(!data)
+                    {
+                        importError("Truncated vertex data in PLY file " + filepath);
+                    }
+
+                    auto records = std::make_shared<std::vector<char>>(data, data + count * recordSize);
+                    Vertex* out = vertices.data() + first;
+                    /* everything is captured by value, the task must not depend on this stack frame if an error unwinds it */
+                    const Vector4D color = options.color;
+                    auto task = std::make_shared<std::packaged_task<void()>>([records, out, count, recordSize, element, offsets, layout, color, swap]() {
+                        /* sized from the header, layout indices can point at any property of the element */
+                        std::vector<double> values(element.properties.size());
+                        for(uint64_t i = 0; i < count; i++)
+                        {
+                            const char* record = records->data() + i * recordSize;
+                            for(std::size_t p = 0; p < values.size(); p++)
+                            {
+                                values[p] = plyBinaryValue(record + offsets[p], element.properties[p].type, swap);
+                            }
+                            out[i] = plyVertex(values.data(), layout, color);
+                        }
+                    });
+                    inFlight.push_back(task->get_future());
+                    threadPoolSubmit(pool, [task]() { (*task)(); });
+
+                    while(inFlight.size() >= maxInFlight)
+                    {
+                        inFlight.front().get();
+                        inFlight.pop_front();
+                    }
+                }
+
+                while(!inFlight.empty())
+                {
+                    inFlight.front().get();
+                    inFlight.pop_front();
+                }
+                continue;
+            }
+
+            /* records with lists are read sequentially */
+            const bool isVertex = element.name == "vertex";
+            const bool isFace = element.name == "face";
+            const int faceProperty = isFace ? plyFaceProperty(element) : -1;
+            PlyVertexLayout layout;
+            if(isVertex) { layout = plyVertexLayout(element, filepath); }
+
+            for(uint64_t r = 0; r < element.count; r++)
+            {
+                polygon.clear();
+                scalars.clear();
+                for(int p = 0; p < int(element.properties.size()); p++)
+                {
+                    const PlyProperty& property = element.properties[p];
+                    uint64_t count = 1;
+                    if(property.isList)
+                    {
+                        const char* c = reader.read(plySize(property.countType));
+                        if(!c) { importError("Truncated " + element.name + " in PLY file " + filepath); }
+                        count = plyListCount(plyBinaryValue(c, property.countType, swap), reader.left / plySize(property.type), filepath);
+                    }
+
+                    const std::size_t size = plySize(property.type);
+                    const char* data = reader.read(count * size);
+                    if(!data) { importError("Truncated " + element.name + " in PLY file " + filepath); }
+
+                    if(p == faceProperty)
+                    {
+                        for(uint64_t i = 0; i < count; i++)
+                        {
+                            polygon.push_back(int64_t(plyBinaryValue(data + i * size, property.type, swap)));
+                        }
+                    }
+                    scalars.push_back(property.isList ? 0.0 : plyBinaryValue(data, property.type, swap));
+                }
+
+                if(isVertex)
+                {
+                    vertices.push_back(plyVertex(scalars.data(), layout, options.color));
+                }
+                else if(isFace)
+                {
+                    triangulate(polygon, vertexCount, indices);
+                }
+            }
+        }
+    }
+
+    void finishImport(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const ImportOptions& options, ImportStats& stats,
+                      std::chrono::steady_clock::time_point start, ImportStats* out)
+    {
+        if(options.weld)
+        {
+            stats.weldedVertices = weldVertices(vertices, indices);
+        }
+
+        stats.vertices = vertices.size();
+        stats.triangles = indices.size() / 3;
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(out) { *out = stats; }
+    }
+
+    /*------------------------ welding ------------------------*/
+
+    inline uint32_t floatBits(float f)
+    {
+        /* +0.0 turns -0.0 into +0.0 so both weld together */
+        f += 0.0f;
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+
+    inline uint64_t hashVertex(const Vertex& v)
+    {
+        const float values[7] = {v.pos.x, v.pos.y, v.pos.z, v.color.x, v.color.y, v.color.z, v.color.w};
+        uint64_t h = 0x9E3779B97F4A7C15ull;
+        for(float value : values)
+        {
+            h ^= floatBits(value);
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 32;
+        }
+        return h;
+    }
+
+    inline bool sameVertex(const Vertex& a, const Vertex& b)
+    {
+        return floatBits(a.pos.x) == floatBits(b.pos.x) && floatBits(a.pos.y) == floatBits(b.pos.y) && floatBits(a.pos.z) == floatBits(b.pos.z)
+            && floatBits(a.color.x) == floatBits(b.color.x) && floatBits(a.color.y) == floatBits(b.color.y)
+            && floatBits(a.color.z) == floatBits(b.color.z) && floatBits(a.color.w) == floatBits(b.color.w);
+    }
+}
+
+void importOBJ(const std::string& filepath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const ImportOptions& options, ImportStats* stats)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::ifstream file(filepath, std::ios::binary);
+    if(!file.is_open())
+    {
+        detail::importError("Couldn't open OBJ file at " + filepath);
+    }
+
+    vertices.clear();
+    indices.clear();
+
+    auto pool = detail::importPool(options);
+    ImportStats importStats;
+    importStats.threads = (unsigned int) pool->workers.size();
+
+    const Vector4D color = options.color;
+    auto parse = [color](const char* begin, const char* end, detail::ObjChunk& chunk) { detail::parseObjChunk(begin, end, color, chunk); };
+
+    detail::streamLines<detail::ObjChunk>(file, options, pool.get(), importStats, parse, [&](detail::ObjChunk chunk) {
+        int64_t base = int64_t(vertices.size());
+        vertices.insert(vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+
+        for(int64_t index : chunk.faces)
+        {
+            int64_t resolved = index < -detail::OBJ_RELATIVE_BIAS / 2 ? base + index + detail::OBJ_RELATIVE_BIAS : index;
+            if(resolved < 0)
+            {
+                detail::importError("Invalid relative vertex index in OBJ file " + filepath);
+            }
+            /* checked before the cast, a huge index would wrap into range; the vertex count is checked at the end */
+            if(resolved > int64_t(std::numeric_limits<unsigned int>::max()))
+            {
+                detail::importError("Vertex index out of range in OBJ file " + filepath);
+            }
+            indices.push_back((unsigned int) resolved);
+        }
+    });
+
+    for(unsigned int index : indices)
+    {
+        if(index >= vertices.size())
+        {
+            detail::importError("Vertex index out of range in OBJ file " + filepath);
+        }
+    }
+
+    detail::finishImport(vertices, indices, options, importStats, start, stats);
+}
+
+void importPLY(const std::string& filepath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const ImportOptions& options, ImportStats* stats)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::ifstream file(filepath, std::ios::binary);
+    if(!file.is_open())
+    {
+        detail::importError("Couldn't open PLY file at " + filepath);
+    }
+
+    vertices.clear();
+    indices.clear();
+
+    detail::PlyHeader header = detail::readPlyHeader(file, filepath);
+
+    auto pool = detail::importPool(options);
+    ImportStats importStats;
+    importStats.threads = (unsigned int) pool->workers.size();
+    importStats.bytes = uint64_t(file.tellg());
+
+    /* counts in the header are checked against the size of the body */
+    file.seekg(0, std::ios::end);
+    const uint64_t bodyBytes = uint64_t(file.tellg()) - importStats.bytes;
+    file.seekg(std::streamoff(importStats.bytes));
+    detail::validatePlyCounts(header, bodyBytes, filepath);
+
+    if(header.format == detail::PlyFormat::Ascii)
+    {
+        detail::importPlyAscii(file, header, options, pool.get(), importStats, vertices, indices, filepath);
+    }
+    else
+    {
+        detail::importPlyBinary(file, bodyBytes, header, options, pool.get(), importStats, vertices, indices, filepath);
+    }
+
+    detail::finishImport(vertices, indices, options, importStats, start, stats);
+}
+
+void importMesh(const std::string& filepath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const ImportOptions& options, ImportStats* stats)
+{
+    std::string extension = filepath.substr(filepath.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+
+    if(extension == "obj")
+    {
+        importOBJ(filepath, vertices, indices, options, stats);
+    }
+    else if(extension == "ply")
+    {
+        importPLY(filepath, vertices, indices, options, stats);
+    }
+    else
+    {
+        detail::importError("Unsupported mesh file format " + filepath);
+    }
+}
+
+std::size_t weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    const uint32_t empty = ~0u;
+
+    std::size_t capacity = 16;
+    while(capacity < vertices.size() * 2) { capacity *= 2; }
+
+    std::vector<uint32_t> table(capacity, empty);
+    std::vector<uint32_t> remap(vertices.size());
+    uint32_t unique = 0;
+
+    for(std::size_t i = 0; i < vertices.size(); i++)
+    {
+        const Vertex v = vertices[i];
+        std::size_t slot = detail::hashVertex(v) & (capacity - 1);
+
+        while(table[slot] != empty && !detail::sameVertex(vertices[table[slot]], v))
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        if(table[slot] == empty)
+        {
+            /* unique vertices are compacted to the front, they never overwrite a vertex that is still to be visited */
+            table[slot] = unique;
+            vertices[unique] = v;
+            unique++;
+        }
+        remap[i] = table[slot];
+    }
+
+    for(unsigned int& index : indices)
+    {
+        index = remap[index];
+    }
+
+    std::size_t removed = vertices.size() - unique;
+    vertices.resize(unique);
+    return removed;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "mesh.h"
+#include "threadpool.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ImportOptions
+{
+    /* bytes read from the file per chunk, each chunk is parsed as one task */
+    std::size_t chunkSize = 4u << 20;
+    /* chunks read but not yet merged, bounds the memory used for file data to about chunkSize * maxChunksInFlight */
+    unsigned int maxChunksInFlight = 0;     // 0 = two per worker thread
+    /* worker threads used if no pool is given, 0 = one per hardware thread */
+    unsigned int threads = 0;
+    ThreadPool* pool = nullptr;
+
+    /* merge bitwise identical vertices after loading */
+    bool weld = true;
+    /* color of vertices without color information */
+    Vector4D color = {1.0f, 1.0f, 1.0f, 1.0f};
+};
+
+struct ImportStats
+{
+    uint64_t bytes = 0;
+    unsigned int chunks = 0;
+    unsigned int threads = 0;
+    double seconds = 0.0;
+
+    std::size_t vertices = 0;
+    std::size_t triangles = 0;
+    std::size_t weldedVertices = 0;
+
+    double megabytesPerSecond() const { return seconds > 0.0 ? double(bytes) / (1024.0 * 1024.0) / seconds : 0.0; }
+};
+
+/**
+ * @brief Load a triangle mesh from a Wavefront OBJ file. The file is read in chunks that are parsed in parallel on a
+ * thread pool and merged in file order. Polygons are triangulated as fans, texture coordinates and normals are ignored.
+ * Vertex colors are read from the "v x y z r g b" extension.
+ *
+ * @param filepath Path to OBJ file.
+ * @param vertices Receives the vertices of the mesh.
+ * @param indices Receives the triangle indices of the mesh.
+ * @param options Chunking, threading and welding options.
+ * @param stats Optional, receives throughput and size statistics.
+ *
+ * usage:
+ *
+ *   std::vector<Vertex> vertices;
+ *   std::vector<unsigned int> indices;
+ *   importOBJ("assets/bunny.obj", vertices, indices);
+ *   Mesh myMesh = meshCreate(vertices, indices, GL_STATIC_DRAW, GL_STATIC_DRAW);
+ *
+ */
+void importOBJ(const std::string& filepath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const ImportOptions& options = {}, ImportStats* stats = nullptr);
+
+/**
+ * @brief Load a triangle mesh from an ASCII or binary (little or big endian) PLY file. Uses the x, y, z and the optional
+ * red, green, blue, alpha properties of the "vertex" element and the vertex_indices list of the "face" element.
+ * ASCII files are parsed in parallel chunks like OBJ files, fixed size binary vertex records are converted in parallel.
+ *
+ * @param filepath Path to PLY file.
+ * @param vertices Receives the vertices of the mesh.
+ * @param indices Receives the triangle indices of the mesh.
+ * @param options Chunking, threading and welding options.
+ * @param stats Optional, receives throughput and size statistics.
+ */
+void importPLY(const std::string& filepath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const ImportOptions& options = {}, ImportStats* stats = nullptr);
+
+/**
+ * @brief Load a triangle mesh from an OBJ or PLY file, selected by the file extension.
+ */
+void importMesh(const std::string& filepath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const ImportOptions& options = {}, ImportStats* stats = nullptr);
+
+/**
+ * @brief Merge bitwise identical vertices using a hash table and rewrite the indices accordingly.
+ *
+ * @param vertices Vertices, compacted in place (first occurrence order is kept).
+ * @param indices Indices that get remapped to the compacted vertices.
+ *
+ * @return Number of removed vertices.
+ */
+std::size_t weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
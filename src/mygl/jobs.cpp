@@ -0,0 +1,386 @@
+#include "jobs.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+namespace detail
+{
+    /* worker the calling thread belongs to and how deep it is nested in job executions */
+    thread_local const JobScheduler* jobThreadScheduler = nullptr;
+    thread_local unsigned int jobThreadWorker = 0;
+    thread_local unsigned int jobThreadDepth = 0;
+
+    int64_t jobNow()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    unsigned int jobCurrentWorker(const JobScheduler* scheduler)
+    {
+        return jobThreadScheduler == scheduler ? jobThreadWorker : 0;
+    }
+
+    bool jobPush(JobQueue& queue, const Job& job)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.size == queue.jobs.size())
+        {
+            return false;
+        }
+        queue.jobs[(queue.front + queue.size) % queue.jobs.size()] = job;
+        queue.size++;
+        return true;
+    }
+
+    /* the owner takes the newest job, it is most likely still in the cache */
+    bool jobPop(JobQueue& queue, Job& job)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.size == 0)
+        {
+            return false;
+        }
+        queue.size--;
+        job = queue.jobs[(queue.front + queue.size) % queue.jobs.size()];
+        return true;
+    }
+
+    /* thieves take the oldest job, for recursively split work that is the largest one */
+    bool jobSteal(JobQueue& queue, Job& job)
+    {
+        std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+        if(!lock.owns_lock() || queue.size == 0)
+        {
+            return false;
+        }
+        job = queue.jobs[queue.front];
+        queue.front = (queue.front + 1) % queue.jobs.size();
+        queue.size--;
+        return true;
+    }
+
+    bool jobNext(JobScheduler* scheduler, unsigned int worker, Job& job)
+    {
+        if(scheduler->queued.load() == 0)
+        {
+            return false;
+        }
+        if(jobPop(scheduler->queues[worker], job))
+        {
+            scheduler->queued--;
+            return true;
+        }
+        for(unsigned int i = 1; i < scheduler->workerCount; i++)
+        {
+            unsigned int victim = (worker + i) % scheduler->workerCount;
+            if(jobSteal(scheduler->queues[victim], job))
+            {
+                scheduler->queued--;
+                scheduler->queues[worker].stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void jobExecute(JobScheduler* scheduler, unsigned int worker, const Job& job);
+
+    void jobEnqueue(JobScheduler* scheduler, const Job& job)
+    {
+        if(!jobPush(scheduler->queues[jobCurrentWorker(scheduler)], job))
+        {
+            /* queue full, running the job right away keeps scheduling free of allocations */
+            jobExecute(scheduler, jobCurrentWorker(scheduler), job);
+            return;
+        }
+        scheduler->queued++;
+        if(scheduler->sleeping.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(scheduler->sleepMutex);
+            scheduler->wake.notify_one();
+        }
+    }
+
+    void jobFinish(JobScheduler* scheduler, JobCounter& counter)
+    {
+        Job continuations[JOBCOUNTER_MAX_CONTINUATIONS];
+        unsigned int continuationCount = 0;
+        {
+            /* decrement under the lock, jobWait(...) takes it before returning so the counter outlives this block */
+            std::lock_guard<std::mutex> lock(counter._mutex);
+            if(--counter.pending == 0)
+            {
+                continuationCount = counter._continuationCount;
+                std::copy(counter._continuations, counter._continuations + continuationCount, continuations);
+                counter._continuationCount = 0;
+            }
+        }
+        for(unsigned int i = 0; i < continuationCount; i++)
+        {
+            jobEnqueue(scheduler, continuations[i]);
+        }
+    }
+
+    void jobExecute(JobScheduler* scheduler, unsigned int worker, const Job& job)
+    {
+        /* jobs executed while waiting inside another job are part of its busy time already */
+        const bool outermost = jobThreadDepth++ == 0;
+        const int64_t start = outermost ? jobNow() : 0;
+
+#ifdef MYGL_PROFILE_JOBS
+        {
+            PROFILE_SCOPE("job");
+            job.invoke(job.data);
+        }
+#else
+        job.invoke(job.data);
+#endif
+
+        JobQueue& queue = scheduler->queues[worker];
+        queue.executed.fetch_add(1, std::memory_order_relaxed);
+        if(outermost)
+        {
+            queue.busyNanoseconds.fetch_add(uint64_t(jobNow() - start), std::memory_order_relaxed);
+        }
+        jobThreadDepth--;
+
+        if(job.counter)
+        {
+            jobFinish(scheduler, *job.counter);
+        }
+    }
+
+    void jobWorkerLoop(JobScheduler* scheduler, unsigned int worker)
+    {
+        jobThreadScheduler = scheduler;
+        jobThreadWorker = worker;
+#ifdef MYGL_PROFILE
+        profilerThreadName("worker " + std::to_string(worker));
+#endif
+
+        Job job;
+        unsigned int idleRounds = 0;
+        while(true)
+        {
+            if(jobNext(scheduler, worker, job))
+            {
+                jobExecute(scheduler, worker, job);
+                idleRounds = 0;
+                continue;
+            }
+
+            /* spin briefly before sleeping, new jobs often follow right away */
+            if(++idleRounds < 64)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(scheduler->sleepMutex);
+            scheduler->sleeping++;
+            scheduler->wake.wait(lock, [scheduler]() { return scheduler->stop || scheduler->queued.load() > 0; });
+            scheduler->sleeping--;
+            if(scheduler->stop && scheduler->queued.load() == 0)
+            {
+                return;
+            }
+            idleRounds = 0;
+        }
+    }
+
+    struct JobParallelForState
+    {
+        JobScheduler* scheduler;
+        JobRangeFunction function;
+        const void* body;
+        std::size_t grain;
+        JobCounter counter;
+    };
+
+    void jobParallelForRange(JobParallelForState* state, std::size_t begin, std::size_t end)
+    {
+        /* hand out the upper halves as jobs until the rest is small enough */
+        while(end - begin > state->grain)
+        {
+            std::size_t middle = begin + (end - begin) / 2;
+            jobRun(state->scheduler, jobCreate([state, middle, end]() { jobParallelForRange(state, middle, end); }), &state->counter);
+            end = middle;
+        }
+        state->function(state->body, begin, end);
+    }
+
+    void jobParallelFor(JobScheduler* scheduler, std::size_t count, std::size_t grain, JobRangeFunction function, const void* body)
+    {
+        if(count == 0)
+        {
+            return;
+        }
+        if(grain == 0)
+        {
+            /* about eight chunks per worker */
+            grain = scheduler ? std::max<std::size_t>(1, count / (8 * scheduler->workerCount)) : count;
+        }
+        if(!scheduler || scheduler->workerCount == 1 || count <= grain)
+        {
+            function(body, 0, count);
+            return;
+        }
+
+        JobParallelForState state{scheduler, function, body, grain, {}};
+        jobParallelForRange(&state, 0, count);
+        jobWait(scheduler, state.counter);
+    }
+}
+
+JobScheduler* jobSchedulerCreate(unsigned int threads)
+{
+    if(threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    JobScheduler* scheduler = new JobScheduler;
+    scheduler->workerCount = threads;
+    scheduler->queues.reset(new JobQueue[threads]);
+    for(unsigned int i = 0; i < threads; i++)
+    {
+        scheduler->queues[i].jobs.resize(JOBQUEUE_CAPACITY);
+    }
+    scheduler->statsStart = detail::jobNow();
+
+    detail::jobThreadScheduler = scheduler;
+    detail::jobThreadWorker = 0;
+    for(unsigned int i = 1; i < threads; i++)
+    {
+        scheduler->threads.emplace_back(detail::jobWorkerLoop, scheduler, i);
+    }
+    return scheduler;
+}
+
+void jobSchedulerDelete(JobScheduler* scheduler)
+{
+    /* jobs left in the queue of the calling thread are executed here, the workers drain their own queues */
+    Job job;
+    while(detail::jobNext(scheduler, 0, job))
+    {
+        detail::jobExecute(scheduler, 0, job);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(scheduler->sleepMutex);
+        scheduler->stop = true;
+    }
+    scheduler->wake.notify_all();
+    for(std::thread& thread : scheduler->threads)
+    {
+        thread.join();
+    }
+
+    if(detail::jobThreadScheduler == scheduler)
+    {
+        detail::jobThreadScheduler = nullptr;
+    }
+    delete scheduler;
+}
+
+std::vector<JobWorkerStats> jobSchedulerStats(const JobScheduler* scheduler)
+{
+    const double elapsed = double(detail::jobNow() - scheduler->statsStart) * 1e-9;
+
+    std::vector<JobWorkerStats> stats(scheduler->workerCount);
+    for(unsigned int i = 0; i < scheduler->workerCount; i++)
+    {
+        const JobQueue& queue = scheduler->queues[i];
+        stats[i].executed = queue.executed.load(std::memory_order_relaxed);
+        stats[i].stolen = queue.stolen.load(std::memory_order_relaxed);
+        stats[i].busySeconds = double(queue.busyNanoseconds.load(std::memory_order_relaxed)) * 1e-9;
+        stats[i].utilization = elapsed > 0.0 ? std::min(1.0, stats[i].busySeconds / elapsed) : 0.0;
+    }
+    return stats;
+}
+
+void jobSchedulerResetStats(JobScheduler* scheduler)
+{
+    for(unsigned int i = 0; i < scheduler->workerCount; i++)
+    {
+        JobQueue& queue = scheduler->queues[i];
+        queue.executed.store(0, std::memory_order_relaxed);
+        queue.stolen.store(0, std::memory_order_relaxed);
+        queue.busyNanoseconds.store(0, std::memory_order_relaxed);
+    }
+    scheduler->statsStart = detail::jobNow();
+}
+
+void jobRun(JobScheduler* scheduler, const Job& job, JobCounter* counter)
+{
+    Job scheduled = job;
+    scheduled.counter = counter;
+    if(counter)
+    {
+        counter->pending++;
+    }
+    detail::jobEnqueue(scheduler, scheduled);
+}
+
+void jobRunAfter(JobScheduler* scheduler, const Job& job, JobCounter& dependency, JobCounter* counter)
+{
+    if(counter == &dependency)
+    {
+        std::cerr << "[Jobs] A job can't wait for its own counter" << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[Jobs] A job can't wait for its own counter");
+    }
+
+    Job scheduled = job;
+    scheduled.counter = counter;
+
+    {
+        std::lock_guard<std::mutex> lock(dependency._mutex);
+        if(dependency.pending.load() > 0)
+        {
+            /* checked before the counter is increased, so an error leaves it untouched */
+            if(dependency._continuationCount == JOBCOUNTER_MAX_CONTINUATIONS)
+            {
+                std::cerr << "[Jobs] Too many jobs waiting for the same counter" << std::endl;
+                std::cerr.flush();
+                throw std::runtime_error("[Jobs] Too many jobs waiting for the same counter");
+            }
+            if(counter)
+            {
+                counter->pending++;
+            }
+            dependency._continuations[dependency._continuationCount++] = scheduled;
+            return;
+        }
+    }
+    if(counter)
+    {
+        counter->pending++;
+    }
+    detail::jobEnqueue(scheduler, scheduled);
+}
+
+void jobWait(JobScheduler* scheduler, JobCounter& counter)
+{
+    const unsigned int worker = detail::jobCurrentWorker(scheduler);
+
+    Job job;
+    while(counter.pending.load() > 0)
+    {
+        if(detail::jobNext(scheduler, worker, job))
+        {
+            detail::jobExecute(scheduler, worker, job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    /* the job that finished the counter may still hold its lock */
+    std::lock_guard<std::mutex> lock(counter._mutex);
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/* bytes available for the captures of a job function, larger functions have to capture a pointer to their state */
+constexpr std::size_t JOB_DATA_SIZE = 48;
+
+/* jobs that can wait for the same counter at once */
+constexpr unsigned int JOBCOUNTER_MAX_CONTINUATIONS = 4;
+
+/* jobs each worker queue can hold, jobs scheduled into a full queue are executed right away */
+constexpr std::size_t JOBQUEUE_CAPACITY = 4096;
+
+struct JobCounter;
+
+/**
+ * A function with its captures stored inline, so scheduling a job never allocates. Create jobs with jobCreate(...).
+ */
+struct Job
+{
+    void (*invoke)(const void* data) = nullptr;
+    alignas(std::max_align_t) unsigned char data[JOB_DATA_SIZE];
+    JobCounter* counter = nullptr;
+};
+
+/**
+ * Number of unfinished jobs scheduled with the counter. Jobs scheduled with jobRunAfter(...) are started as soon as the
+ * counter drops to zero. Counters must not be destroyed while jobs are still using them, wait for them with jobWait(...).
+ */
+struct JobCounter
+{
+    std::atomic<uint32_t> pending{0};
+
+    std::mutex _mutex;
+    Job _continuations[JOBCOUNTER_MAX_CONTINUATIONS];
+    unsigned int _continuationCount = 0;
+};
+
+/* per worker counters, worker 0 is the thread that created the scheduler */
+struct JobWorkerStats
+{
+    uint64_t executed = 0;
+    uint64_t stolen = 0;
+    double busySeconds = 0.0;
+
+    /* busy time relative to the time since the last reset */
+    double utilization = 0.0;
+};
+
+/* fixed capacity ring buffer, the owner works at the back, other workers steal from the front */
+struct JobQueue
+{
+    std::mutex mutex;
+    std::vector<Job> jobs;
+    std::size_t front = 0;
+    std::size_t size = 0;
+
+    alignas(64) std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> stolen{0};
+    std::atomic<uint64_t> busyNanoseconds{0};
+};
+
+/**
+ * Work-stealing job scheduler with one queue per worker thread. The thread that creates the scheduler is worker 0 and
+ * executes jobs while it waits in jobWait(...), threads that are no workers schedule into and help from queue 0.
+ */
+struct JobScheduler
+{
+    std::vector<std::thread> threads;
+    std::unique_ptr<JobQueue[]> queues;
+    unsigned int workerCount = 0;
+
+    std::atomic<uint32_t> queued{0};
+    std::atomic<unsigned int> sleeping{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stop = false;
+
+    int64_t statsStart = 0;
+};
+
+/**
+ * @brief Create a scheduler and start its worker threads.
+ *
+ * @param threads Number of workers including the calling thread, 0 uses one per hardware thread.
+ *
+ * @return Scheduler, has to be deleted with jobSchedulerDelete(...).
+ */
+JobScheduler* jobSchedulerCreate(unsigned int threads = 0);
+
+/**
+ * @brief Finish all queued jobs, stop the worker threads and delete the scheduler.
+ *
+ * @param scheduler Scheduler to delete.
+ */
+void jobSchedulerDelete(JobScheduler* scheduler);
+
+/**
+ * @brief Read the per worker counters.
+ *
+ * @param scheduler Scheduler.
+ *
+ * @return One entry per worker.
+ */
+std::vector<JobWorkerStats> jobSchedulerStats(const JobScheduler* scheduler);
+
+/**
+ * @brief Reset the per worker counters and start a new utilization interval.
+ *
+ * @param scheduler Scheduler.
+ */
+void jobSchedulerResetStats(JobScheduler* scheduler);
+
+/**
+ * @brief Wrap a function into a job. The function has to fit into JOB_DATA_SIZE bytes and be trivially copyable, which
+ * is the case for lambdas capturing references, pointers and small values.
+ *
+ * @param function Function without parameters.
+ *
+ * @return Job calling the function.
+ */
+template<typename F>
+Job jobCreate(const F& function)
+{
+    static_assert(sizeof(F) <= JOB_DATA_SIZE, "job function captures too much, capture a pointer to the state instead");
+    static_assert(alignof(F) <= alignof(std::max_align_t), "job function is over-aligned");
+    static_assert(std::is_trivially_copyable<F>::value && std::is_trivially_destructible<F>::value,
+                  "job function has to be trivially copyable");
+
+    Job job;
+    new (job.data) F(function);
+    job.invoke = [](const void* data) { (*static_cast<const F*>(data))(); };
+    return job;
+}
+
+/**
+ * @brief Schedule a job on the queue of the calling worker.
+ *
+ * @param scheduler Scheduler.
+ * @param job Job to run.
+ * @param counter Optional, increased now and decreased when the job is finished.
+ */
+void jobRun(JobScheduler* scheduler, const Job& job, JobCounter* counter = nullptr);
+
+/**
+ * @brief Schedule a job to run once all jobs of another counter are finished (right away if there are none).
+ *
+ * @param scheduler Scheduler.
+ * @param job Job to run.
+ * @param dependency Counter to wait for.
+ * @param counter Optional, increased now and decreased when the job is finished. Has to be another counter than the
+ * dependency, the job would wait for itself.
+ */
+void jobRunAfter(JobScheduler* scheduler, const Job& job, JobCounter& dependency, JobCounter* counter = nullptr);
+
+/**
+ * @brief Execute queued jobs until all jobs of the counter are finished.
+ *
+ * @param scheduler Scheduler.
+ * @param counter Counter to wait for.
+ *
+ * usage:
+ *
+ *   JobCounter simulated, culled;
+ *   jobRun(scheduler, jobCreate([&]() { simulate(); }), &simulated);
+ *   jobRunAfter(scheduler, jobCreate([&]() { cull(); }), simulated, &culled);
+ *   jobWait(scheduler, culled);
+ *
+ */
+void jobWait(JobScheduler* scheduler, JobCounter& counter);
+
+namespace detail
+{
+    using JobRangeFunction = void (*)(const void* body, std::size_t begin, std::size_t end);
+    void jobParallelFor(JobScheduler* scheduler, std::size_t count, std::size_t grain, JobRangeFunction function, const void* body);
+}
+
+/**
+ * @brief Run a loop over [0, count) on all workers and block until it is finished. The range is split in halves
+ * recursively, idle workers steal the larger halves.
+ *
+ * @param scheduler Scheduler, nullptr runs the whole loop on the calling thread.
+ * @param count Number of iterations.
+ * @param body Called with the range [begin, end) of each chunk.
+ * @param grain Iterations per chunk at most, 0 picks it from the count and the number of workers.
+ *
+ * usage:
+ *
+ *   jobParallelFor(scheduler, values.size(), [&](std::size_t begin, std::size_t end)
+ *   {
+ *       for(std::size_t i = begin; i < end; i++) { values[i] *= 2.0f; }
+ *   });
+ *
+ */
+template<typename F>
+void jobParallelFor(JobScheduler* scheduler, std::size_t count, const F& body, std::size_t grain = 0)
+{
+    detail::jobParallelFor(scheduler, count, grain,
+                           [](const void* function, std::size_t begin, std::size_t end) { (*static_cast<const F*>(function))(begin, end); },
+                           &body);
+}
@@ -1,76 +1,102 @@
 #include "mesh.h"
+#include "meshpool.h"
+#include "glstate.h"
 
-Mesh meshCreate(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, GLenum vertexBufferUsage, GLenum indexBufferUsage)
+#include <algorithm>
+#include <cstring>
+
+Mesh meshCreate(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, GLenum vertexBufferUsage, GLenum indexBufferUsage)
 {
-    GLuint vao = 0, vbo = 0, ebo = 0;
+    return meshCreate(vertices, vertexCount, indices, indexCount, boundsCompute(vertices, vertexCount), vertexBufferUsage, indexBufferUsage);
+}
 
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ebo);
+Mesh meshCreate(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, const Bounds& bounds, GLenum vertexBufferUsage, GLenum indexBufferUsage)
+{
+    MeshPoolAllocation allocation = meshPoolAllocate(vertexCount, indexCount, vertexBufferUsage, indexBufferUsage);
+    const MeshPoolPage& page = meshPoolPage(allocation.page);
 
-    glBindVertexArray(vao);
-    {
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), vertexBufferUsage);
-        glCheckError();
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), indexBufferUsage);
-        glCheckError();
-
-        glEnableVertexAttribArray(eDataIdx::Position);
-        glEnableVertexAttribArray(eDataIdx::Color);
-        glVertexAttribPointer(eDataIdx::Position,   3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, pos));
-        glVertexAttribPointer(eDataIdx::Color,      4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, color));
-        glCheckError();
-    }
+    glStateBindBuffer(GL_ARRAY_BUFFER, page.vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, GLintptr(allocation.baseVertex) * sizeof(Vertex), GLsizeiptr(vertexCount) * sizeof(Vertex), vertices);
+    glCheckError();
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    /* element buffer binding is VAO state, use the copy target to not touch any VAO */
+    glStateBindBuffer(GL_COPY_WRITE_BUFFER, page.ebo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(allocation.firstIndex) * sizeof(unsigned int), GLsizeiptr(indexCount) * sizeof(unsigned int), indices);
+    glCheckError();
 
-    return Mesh{vao, vbo, ebo, (unsigned int) vertices.size(), (unsigned int) indices.size()};
+    return Mesh{page.vao, page.vbo, page.ebo, vertexCount, indexCount, allocation.page, allocation.baseVertex, allocation.firstIndex, bounds};
 }
 
-Mesh meshCreate(const std::vector<Vector3D>& positions, const std::vector<unsigned int>& indices, const Vector4D& color, GLenum vertexBufferUsage, GLenum indexBufferUsage) {
-    GLuint vao = 0, vbo = 0, ebo = 0;
-
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ebo);
+Mesh meshCreate(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, GLenum vertexBufferUsage, GLenum indexBufferUsage)
+{
+    return meshCreate(vertices.data(), (unsigned int) vertices.size(), indices.data(), (unsigned int) indices.size(), vertexBufferUsage, indexBufferUsage);
+}
 
+Mesh meshCreate(const std::vector<Vector3D>& positions, const std::vector<unsigned int>& indices, const Vector4D& color, GLenum vertexBufferUsage, GLenum indexBufferUsage) {
     std::vector<Vertex> vertices(positions.size());
     for (unsigned i=0; i<vertices.size(); i++) {
         vertices[i] = {positions[i], color};
     }
 
-    glBindVertexArray(vao);
+    return meshCreate(vertices.data(), (unsigned int) vertices.size(), indices.data(), (unsigned int) indices.size(), vertexBufferUsage, indexBufferUsage);
+}
+
+void meshDraw(const Mesh& mesh)
+{
+    glDrawElementsBaseVertex(GL_TRIANGLES, mesh.size_ibo, GL_UNSIGNED_INT, (void*) (std::size_t(mesh.firstIndex) * sizeof(unsigned int)), mesh.baseVertex);
+}
+
+void meshDrawInstanced(const Mesh& mesh, const Matrix4D* models, std::size_t count, const Vector4D* colors)
+{
+    const std::size_t instanceBytes = sizeof(Matrix4D) + (colors ? sizeof(Vector4D) : 0);
+    const std::size_t batchSize = MESHPOOL_INSTANCE_BUFFER_SIZE / instanceBytes;
+
+    glStateBindVertexArray(meshPoolInstancedVao(mesh.page));
+    if(!colors)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), vertexBufferUsage);
-        glCheckError();
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), indexBufferUsage);
-        glCheckError();
-
-        glEnableVertexAttribArray(eDataIdx::Position);
-        glEnableVertexAttribArray(eDataIdx::Color);
-        glVertexAttribPointer(eDataIdx::Position,   3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, pos));
-        glVertexAttribPointer(eDataIdx::Color,      4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, color));
-        glCheckError();
+        glDisableVertexAttribArray(eDataIdx::InstanceColor);
+        glVertexAttrib4f(eDataIdx::InstanceColor, 1.0f, 1.0f, 1.0f, 1.0f);
+    }
+    else
+    {
+        glEnableVertexAttribArray(eDataIdx::InstanceColor);
     }
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    for(std::size_t first = 0; first < count; first += batchSize)
+    {
+        const std::size_t instances = std::min(batchSize, count - first);
+
+        /* models and colors are written as two consecutive arrays of one mapped range */
+        std::size_t offset = 0;
+        char* data = static_cast<char*>(meshPoolMapInstances(instances * instanceBytes, offset));
+        std::memcpy(data, models + first, instances * sizeof(Matrix4D));
+        if(colors)
+        {
+            std::memcpy(data + instances * sizeof(Matrix4D), colors + first, instances * sizeof(Vector4D));
+        }
+        meshPoolUnmapInstances();
+
+        for(unsigned int column = 0; column < 4; column++)
+        {
+            glVertexAttribPointer(eDataIdx::InstanceModel + column, 4, GL_FLOAT, GL_FALSE, sizeof(Matrix4D),
+                                  (void*) (offset + column * 4 * sizeof(float)));
+        }
+        if(colors)
+        {
+            glVertexAttribPointer(eDataIdx::InstanceColor, 4, GL_FLOAT, GL_FALSE, sizeof(Vector4D), (void*) (offset + instances * sizeof(Matrix4D)));
+        }
+
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.size_ibo, GL_UNSIGNED_INT, (void*) (std::size_t(mesh.firstIndex) * sizeof(unsigned int)),
+                                          GLsizei(instances), mesh.baseVertex);
+    }
+}
 
-    return Mesh{vao, vbo, ebo, (unsigned int) vertices.size(), (unsigned int) indices.size()};
+void meshDrawInstanced(const Mesh& mesh, const std::vector<Matrix4D>& models)
+{
+    meshDrawInstanced(mesh, models.data(), models.size());
 }
 
 void meshDelete(const Mesh &mesh)
 {
-    glDeleteBuffers(1, &mesh.vbo);
-    glDeleteBuffers(1, &mesh.ebo);
-    glDeleteVertexArrays(1, &mesh.vao);
+    meshPoolFree(MeshPoolAllocation{mesh.page, mesh.baseVertex, mesh.firstIndex}, mesh.size_vbo, mesh.size_ibo);
 }
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "base.h"
+#include "bounds.h"
 
 #include <vector>
 
-enum eDataIdx { Position = 0, Color = 1 };
+/* per-instance attributes of instanced draws, InstanceModel is a mat4 and uses the locations 2 to 5 */
+enum eDataIdx { Position = 0, Color = 1, InstanceModel = 2, InstanceColor = 6 };
 
 struct Vertex
 {
@@ -13,6 +15,11 @@ struct Vertex
 };
 
 
+/**
+ * A mesh is a range of vertices and indices inside a shared pool page (see meshpool.h). vao, vbo and ebo are the
+ * buffers of that page and are shared with all other meshes of the same page and buffer usage. bounds holds the model
+ * space bounding box and sphere of the vertices.
+ */
 struct Mesh
 {
     GLuint vao = 0;
@@ -21,11 +28,17 @@ struct Mesh
 
     unsigned int size_vbo = 0;
     unsigned int size_ibo = 0;
+
+    unsigned int page = 0;
+    unsigned int baseVertex = 0;
+    unsigned int firstIndex = 0;
+
+    Bounds bounds;
 };
 
 /**
- * @brief Initializes all buffer objects (VBO, IBO) required for the mesh and fill it with data. Further, a vertex array
- * object (VAO) is created and the buffer objects are bind to it.
+ * @brief Reserves space for the mesh in the shared mesh pool and uploads the vertex and index data. Meshes with the
+ * same buffer usage share their buffer objects (VBO, IBO) and vertex array object (VAO).
  *
  * @param vertices Data for each vertex of the mesh (position, color, normal and uv coordinate data).
  * @param indices List of indices that form polygons in the mesh.
@@ -37,15 +50,15 @@ struct Mesh
  * usage:
  *
  *   Mesh myMesh = meshCreate(vertex-data, index-data, GL_STATIC_DRAW, GL_STATIC_DRAW);
- *   glBindVertexArray(myMesh.vao);
- *   glDrawElements(GL_TRIANGLES, myMesh.size_ibo, GL_UNSIGNED_INT, nullptr);
+ *   glStateBindVertexArray(myMesh.vao);
+ *   meshDraw(myMesh);
  *
  */
 Mesh meshCreate(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, GLenum vertexBufferUsage, GLenum indexBufferUsage);
 
 /**
- * @brief Initializes all buffer objects (VBO, IBO) required for the mesh and fill it with data. Further, a vertex array
- * object (VAO) is created and the buffer objects are bind to it.
+ * @brief Reserves space for the mesh in the shared mesh pool and uploads the vertex and index data. Meshes with the
+ * same buffer usage share their buffer objects (VBO, IBO) and vertex array object (VAO).
  *
  * @param positions Position data for each vertex of the mesh.
  * @param indices List of indices that form polygons in the mesh.
@@ -58,14 +71,71 @@ Mesh meshCreate(const std::vector<Vertex>& vertices, const std::vector<unsigned
  * usage:
  *
  *   Mesh myMesh = meshCreate(position-data, index-data, color, GL_STATIC_DRAW, GL_STATIC_DRAW);
- *   glBindVertexArray(myMesh.vao);
- *   glDrawElements(GL_TRIANGLES, myMesh.size_ibo, GL_UNSIGNED_INT, nullptr);
+ *   glStateBindVertexArray(myMesh.vao);
+ *   meshDraw(myMesh);
  *
  */
 Mesh meshCreate(const std::vector<Vector3D>& positions, const std::vector<unsigned int>& indices, const Vector4D& color, GLenum vertexBufferUsage, GLenum indexBufferUsage);
 
 /**
- * @brief Cleanup and delete all OpenGL buffers of a mesh. Has to be called for each mesh after it is not used anymore.
+ * @brief Reserves space for the mesh in the shared mesh pool and uploads the vertex and index data directly from the
+ * given memory (e.g. a memory mapped file, see meshfile.h) without any intermediate copy. The bounds of the mesh are
+ * computed from the vertices.
+ *
+ * @param vertices Pointer to vertexCount vertices.
+ * @param vertexCount Number of vertices.
+ * @param indices Pointer to indexCount indices.
+ * @param indexCount Number of indices.
+ * @param vertexBufferUsage enum to hint the usage of the vertex buffer (see usage parameter in glBufferData function).
+ * @param indexBufferUsage enum to hint the usage of the index buffer (see usage parameter in glBufferData function).
+ *
+ * @return Initialized mesh structure that can be drawn with OpenGL.
+ */
+Mesh meshCreate(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, GLenum vertexBufferUsage, GLenum indexBufferUsage);
+
+/**
+ * @brief Same as above with known bounds, the vertices are only uploaded and never read on the CPU.
+ *
+ * @param bounds Model space bounds of the vertices, e.g. stored in a mesh file.
+ */
+Mesh meshCreate(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, const Bounds& bounds, GLenum vertexBufferUsage, GLenum indexBufferUsage);
+
+/**
+ * @brief Draw a mesh with glDrawElementsBaseVertex. The VAO of the mesh (mesh.vao) has to be bound, consecutive meshes
+ * with the same VAO can be drawn without binding it again.
+ *
+ * @param mesh Mesh to draw.
+ */
+void meshDraw(const Mesh& mesh);
+
+/**
+ * @brief Draw count copies of a mesh with one glDrawElementsInstancedBaseVertex call per batch. The model matrices (and
+ * colors) are streamed into the instance buffer of the mesh pool and read as per-instance attributes, see the INSTANCED
+ * variant of shader/default.vert. Binds the instanced VAO of the mesh page, a program using the instanced attributes has
+ * to be bound. Without colors every instance uses white. Large counts are split into batches that fit the instance buffer.
+ *
+ * @param mesh Mesh to draw.
+ * @param models Pointer to count model matrices.
+ * @param count Number of instances.
+ * @param colors Optional pointer to count colors that are multiplied with the vertex colors.
+ *
+ * usage:
+ *
+ *   glStateUseProgram(myInstancedShader.id);
+ *   meshDrawInstanced(myMesh, models.data(), models.size());
+ *
+ */
+void meshDrawInstanced(const Mesh& mesh, const Matrix4D* models, std::size_t count, const Vector4D* colors = nullptr);
+
+/**
+ * @brief Draw one copy of a mesh per model matrix, see meshDrawInstanced(const Mesh&, const Matrix4D*, std::size_t,
+ * const Vector4D*).
+ */
+void meshDrawInstanced(const Mesh& mesh, const std::vector<Matrix4D>& models);
+
+/**
+ * @brief Release the pool ranges of a mesh. Has to be called for each mesh after it is not used anymore. The shared
+ * OpenGL buffers are deleted with meshPoolRelease().
  *
  * @param mesh Mesh to delete.
  */
@@ -0,0 +1,225 @@
+#include "meshfile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace detail
+{
+    void meshFileError(const std::string& message)
+    {
+        std::cerr << "[MeshFile] " << message << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[MeshFile] " + message);
+    }
+
+    uint64_t alignToBlob(uint64_t value)
+    {
+        return (value + MESHFILE_ALIGNMENT - 1) / MESHFILE_ALIGNMENT * MESHFILE_ALIGNMENT;
+    }
+
+    /* layout of the Vertex struct as stored in the file */
+    void meshFileLayout(MeshFileHeader& header)
+    {
+        header.vertexStride = sizeof(Vertex);
+        header.attributeCount = 2;
+        header.attributes[0] = {eDataIdx::Position, 3, GL_FLOAT, offsetof(Vertex, pos)};
+        header.attributes[1] = {eDataIdx::Color,    4, GL_FLOAT, offsetof(Vertex, color)};
+    }
+
+    void validateHeader(const MeshFileHeader& header, std::size_t fileSize, const std::string& filepath)
+    {
+        if(std::memcmp(header.magic, MESHFILE_MAGIC, sizeof(MESHFILE_MAGIC)) != 0 || header.version != MESHFILE_VERSION)
+        {
+            meshFileError("Unsupported mesh file " + filepath);
+        }
+
+        MeshFileHeader expected{};
+        meshFileLayout(expected);
+        if(header.vertexStride != expected.vertexStride || header.attributeCount != expected.attributeCount
+           || std::memcmp(header.attributes, expected.attributes, sizeof(MeshFileAttribute) * expected.attributeCount) != 0)
+        {
+            meshFileError("Vertex layout of " + filepath + " doesn't match the Vertex struct");
+        }
+
+        if(header.vertexBytes != uint64_t(header.vertexCount) * header.vertexStride
+           || header.indexBytes != uint64_t(header.indexCount) * sizeof(unsigned int)
+           || header.vertexOffset % MESHFILE_ALIGNMENT != 0 || header.indexOffset % MESHFILE_ALIGNMENT != 0
+           /* offset + bytes could wrap around with a crafted header */
+           || header.vertexOffset > fileSize || header.vertexBytes > fileSize - header.vertexOffset
+           || header.indexOffset > fileSize || header.indexBytes > fileSize - header.indexOffset)
+        {
+            meshFileError("Corrupt mesh file " + filepath);
+        }
+    }
+
+    /* indices go to the GPU as they are, one past the vertex blob would read outside the vertex buffer */
+    void validateIndices(const unsigned int* indices, uint32_t indexCount, uint32_t vertexCount, const std::string& filepath)
+    {
+        unsigned int maxIndex = 0;
+        for(uint32_t i = 0; i < indexCount; i++)
+        {
+            maxIndex = std::max(maxIndex, indices[i]);
+        }
+        if(indexCount > 0 && maxIndex >= vertexCount)
+        {
+            meshFileError("Vertex index " + std::to_string(maxIndex) + " out of range (" + std::to_string(vertexCount)
+                          + " vertices) in mesh file " + filepath);
+        }
+    }
+}
+
+void meshFileWrite(const std::string& filepath, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    MeshFileHeader header{};
+    std::memcpy(header.magic, MESHFILE_MAGIC, sizeof(MESHFILE_MAGIC));
+    header.version = MESHFILE_VERSION;
+    header.vertexCount = (uint32_t) vertices.size();
+    header.indexCount = (uint32_t) indices.size();
+    detail::meshFileLayout(header);
+
+    header.vertexOffset = detail::alignToBlob(sizeof(MeshFileHeader));
+    header.vertexBytes = uint64_t(vertices.size()) * sizeof(Vertex);
+    header.indexOffset = detail::alignToBlob(header.vertexOffset + header.vertexBytes);
+    header.indexBytes = uint64_t(indices.size()) * sizeof(unsigned int);
+
+    for(int i = 0; i < 3; i++)
+    {
+        header.boundsMin[i] = vertices.empty() ? 0.0f : std::numeric_limits<float>::max();
+        header.boundsMax[i] = vertices.empty() ? 0.0f : std::numeric_limits<float>::lowest();
+    }
+    for(const Vertex& v : vertices)
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            header.boundsMin[i] = std::min(header.boundsMin[i], v.pos[i]);
+            header.boundsMax[i] = std::max(header.boundsMax[i], v.pos[i]);
+        }
+    }
+
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+    if(!file.is_open())
+    {
+        detail::meshFileError("Couldn't open mesh file for writing at " + filepath);
+    }
+
+    const char padding[MESHFILE_ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, std::streamsize(header.vertexOffset - sizeof(header)));
+    file.write(reinterpret_cast<const char*>(vertices.data()), std::streamsize(header.vertexBytes));
+    file.write(padding, std::streamsize(header.indexOffset - header.vertexOffset - header.vertexBytes));
+    file.write(reinterpret_cast<const char*>(indices.data()), std::streamsize(header.indexBytes));
+
+    if(!file.good())
+    {
+        detail::meshFileError("Couldn't write mesh file at " + filepath);
+    }
+}
+
+MeshFile meshFileOpen(const std::string& filepath)
+{
+    MeshFile file;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(handle == INVALID_HANDLE_VALUE)
+    {
+        detail::meshFileError("Couldn't open mesh file at " + filepath);
+    }
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(handle, &size);
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+    file._file = handle;
+    file._fileMapping = mapping;
+    file._mapping = data;
+    file._mappingSize = std::size_t(size.QuadPart);
+#else
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        detail::meshFileError("Couldn't open mesh file at " + filepath);
+    }
+
+    struct stat info;
+    void* data = nullptr;
+    if(fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        data = mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED) { data = nullptr; }
+    }
+    /* the mapping keeps its own reference to the file */
+    close(fd);
+
+    if(data)
+    {
+        madvise(data, std::size_t(info.st_size), MADV_SEQUENTIAL);
+        madvise(data, std::size_t(info.st_size), MADV_WILLNEED);
+    }
+
+    file._mapping = data;
+    file._mappingSize = data ? std::size_t(info.st_size) : 0;
+#endif
+
+    if(!file._mapping || file._mappingSize < sizeof(MeshFileHeader))
+    {
+        meshFileClose(file);
+        detail::meshFileError("Couldn't map mesh file at " + filepath);
+    }
+
+    const char* base = static_cast<const char*>(file._mapping);
+    file.header = reinterpret_cast<const MeshFileHeader*>(base);
+    try
+    {
+        detail::validateHeader(*file.header, file._mappingSize, filepath);
+        detail::validateIndices(reinterpret_cast<const unsigned int*>(base + file.header->indexOffset), file.header->indexCount,
+                                file.header->vertexCount, filepath);
+    }
+    catch(...)
+    {
+        meshFileClose(file);
+        throw;
+    }
+
+    file.vertices = reinterpret_cast<const Vertex*>(base + file.header->vertexOffset);
+    file.indices = reinterpret_cast<const unsigned int*>(base + file.header->indexOffset);
+
+    return file;
+}
+
+void meshFileClose(MeshFile& file)
+{
+#ifdef _WIN32
+    if(file._mapping) { UnmapViewOfFile(file._mapping); }
+    if(file._fileMapping) { CloseHandle(file._fileMapping); }
+    if(file._file) { CloseHandle(file._file); }
+#else
+    if(file._mapping) { munmap(file._mapping, file._mappingSize); }
+#endif
+    file = MeshFile{};
+}
+
+Mesh meshCreate(const MeshFile& file, GLenum vertexBufferUsage, GLenum indexBufferUsage)
+{
+    /* the bounds are stored in the file, the mapped vertices are not read on the CPU */
+    const AABB box{{file.header->boundsMin[0], file.header->boundsMin[1], file.header->boundsMin[2]},
+                   {file.header->boundsMax[0], file.header->boundsMax[1], file.header->boundsMax[2]}};
+    return meshCreate(file.vertices, file.header->vertexCount, file.indices, file.header->indexCount, boundsFromBox(box), vertexBufferUsage,
+                      indexBufferUsage);
+}
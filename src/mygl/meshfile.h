@@ -0,0 +1,109 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Binary mesh container (*.vcm). The file starts with a MeshFileHeader followed by the vertex and the index blob, both
+ * aligned to MESHFILE_ALIGNMENT bytes. All values are stored little endian. The blobs have exactly the layout of the
+ * GPU buffers, so a mapped file can be uploaded without any parsing.
+ */
+constexpr char MESHFILE_MAGIC[4] = {'V', 'C', 'M', 'B'};
+constexpr uint32_t MESHFILE_VERSION = 1;
+constexpr uint32_t MESHFILE_ALIGNMENT = 64;
+constexpr uint32_t MESHFILE_MAX_ATTRIBUTES = 4;
+
+struct MeshFileAttribute
+{
+    uint32_t location;      // attribute location, see eDataIdx
+    uint32_t components;    // number of components (1-4)
+    uint32_t type;          // GL component type, e.g. GL_FLOAT
+    uint32_t offset;        // byte offset inside a vertex
+};
+
+struct MeshFileHeader
+{
+    char magic[4];
+    uint32_t version;
+
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t vertexStride;
+    uint32_t attributeCount;
+    MeshFileAttribute attributes[MESHFILE_MAX_ATTRIBUTES];
+
+    uint64_t vertexOffset;
+    uint64_t vertexBytes;
+    uint64_t indexOffset;
+    uint64_t indexBytes;
+
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+/**
+ * Read-only view of a memory mapped mesh file. vertices and indices point directly into the mapping and stay valid
+ * until meshFileClose(...) is called.
+ */
+struct MeshFile
+{
+    const MeshFileHeader* header = nullptr;
+    const Vertex* vertices = nullptr;
+    const unsigned int* indices = nullptr;
+
+    void* _mapping = nullptr;
+    std::size_t _mappingSize = 0;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _fileMapping = nullptr;
+#endif
+};
+
+/**
+ * @brief Write vertices and indices into a binary mesh file.
+ *
+ * @param filepath Path to output file.
+ * @param vertices Vertex data.
+ * @param indices Index data.
+ */
+void meshFileWrite(const std::string& filepath, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+
+/**
+ * @brief Memory map a binary mesh file and validate its header and indices. The vertex layout stored in the file has to
+ * match the Vertex struct, every index has to be below the vertex count.
+ *
+ * @param filepath Path to mesh file.
+ *
+ * @return View of the mapped file.
+ */
+MeshFile meshFileOpen(const std::string& filepath);
+
+/**
+ * @brief Unmap a mesh file. Has to be called for each opened file after its data is not used anymore.
+ *
+ * @param file Mesh file to close.
+ */
+void meshFileClose(MeshFile& file);
+
+/**
+ * @brief Upload the vertex and index blobs of a mapped mesh file into the mesh pool, directly from the mapping. The
+ * bounds come from the header, the vertices are not read on the CPU (see boundsFromBox(...)).
+ *
+ * @param file Opened mesh file.
+ * @param vertexBufferUsage enum to hint the usage of the vertex buffer (see usage parameter in glBufferData function).
+ * @param indexBufferUsage enum to hint the usage of the index buffer (see usage parameter in glBufferData function).
+ *
+ * @return Initialized mesh structure that can be drawn with OpenGL.
+ *
+ * usage:
+ *
+ *   MeshFile file = meshFileOpen("assets/cube.vcm");
+ *   Mesh myMesh = meshCreate(file, GL_STATIC_DRAW, GL_STATIC_DRAW);
+ *   meshFileClose(file);
+ *
+ */
+Mesh meshCreate(const MeshFile& file, GLenum vertexBufferUsage, GLenum indexBufferUsage);
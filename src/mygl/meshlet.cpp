@@ -0,0 +1,185 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace detail
+{
+    /* bounding sphere and normal cone of the triangles of a meshlet */
+    void meshletBounds(Meshlet& meshlet, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+    {
+        const unsigned int* first = indices.data() + meshlet.firstIndex;
+        const unsigned int count = meshlet.triangleCount * 3;
+
+        const float inf = std::numeric_limits<float>::max();
+        AABB box{Vector3D(inf, inf, inf), Vector3D(-inf, -inf, -inf)};
+        for(unsigned int i = 0; i < count; i++)
+        {
+            const Vector3D& p = vertices[first[i]].pos;
+            for(unsigned int c = 0; c < 3; c++)
+            {
+                box.min[c] = std::min(box.min[c], p[c]);
+                box.max[c] = std::max(box.max[c], p[c]);
+            }
+        }
+
+        meshlet.sphere.center = (box.min + box.max) * 0.5f;
+        float radius2 = 0.0f;
+        for(unsigned int i = 0; i < count; i++)
+        {
+            Vector3D d = vertices[first[i]].pos - meshlet.sphere.center;
+            radius2 = std::max(radius2, dot(d, d));
+        }
+        meshlet.sphere.radius = std::sqrt(radius2);
+
+        /* cone axis is the mean normal, the cutoff is the sine of the largest angle between axis and a normal */
+        std::vector<Vector3D> normals;
+        normals.reserve(meshlet.triangleCount);
+        Vector3D axis;
+        for(unsigned int i = 0; i < count; i += 3)
+        {
+            const Vector3D& a = vertices[first[i]].pos;
+            Vector3D n = cross(vertices[first[i + 1]].pos - a, vertices[first[i + 2]].pos - a);
+            float length2 = dot(n, n);
+            if(length2 > 0.0f)
+            {
+                normals.push_back(n / std::sqrt(length2));
+                axis += normals.back();
+            }
+        }
+
+        meshlet.coneAxis = Vector3D(0.0f, 0.0f, 0.0f);
+        meshlet.coneCutoff = 1.0f;
+        if(normals.empty() || dot(axis, axis) == 0.0f)
+        {
+            return;
+        }
+
+        axis = normalize(axis);
+        float minDot = 1.0f;
+        for(const Vector3D& n : normals)
+        {
+            minDot = std::min(minDot, dot(axis, n));
+        }
+
+        /* cones wider than ~84 degrees reject too little to be worth testing */
+        if(minDot > 0.1f)
+        {
+            meshlet.coneAxis = axis;
+            meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+    }
+}
+
+std::vector<Meshlet> meshletBuild(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned int maxVertices, unsigned int maxTriangles)
+{
+    std::vector<Meshlet> meshlets;
+    if(indices.size() < 3)
+    {
+        return meshlets;
+    }
+
+    /* id of the last meshlet that referenced a vertex */
+    std::vector<unsigned int> marker(vertices.size(), ~0u);
+    unsigned int current = 0;
+    Meshlet meshlet;
+
+    for(unsigned int i = 0; i + 2 < indices.size(); i += 3)
+    {
+        unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        unsigned int newVertices = (marker[a] != current) + (marker[b] != current && b != a) + (marker[c] != current && c != a && c != b);
+
+        if(meshlet.vertexCount + newVertices > maxVertices || meshlet.triangleCount + 1 > maxTriangles)
+        {
+            meshlets.push_back(meshlet);
+            current++;
+            meshlet = Meshlet();
+            meshlet.firstIndex = i;
+            newVertices = 1 + (b != a) + (c != a && c != b);
+        }
+
+        marker[a] = marker[b] = marker[c] = current;
+        meshlet.vertexCount += newVertices;
+        meshlet.triangleCount++;
+    }
+    meshlets.push_back(meshlet);
+
+    for(Meshlet& m : meshlets)
+    {
+        detail::meshletBounds(m, vertices, indices);
+    }
+    return meshlets;
+}
+
+void meshletCull(const Mesh& mesh, const std::vector<Meshlet>& meshlets, const Matrix4D& model, const Matrix4D& viewProjection,
+                 const Vector3D& cameraPosition, MeshletDrawList& drawList, MeshletCullStats* stats)
+{
+    /* bring frustum and camera into model space instead of transforming every meshlet */
+    Frustum frustum = frustumExtract(viewProjection * model);
+    Vector3D camera = Vector3D(inverse(model) * Vector4D(cameraPosition, 1.0f));
+
+    MeshletCullStats local;
+    unsigned int rangeEnd = ~0u;
+
+    for(const Meshlet& meshlet : meshlets)
+    {
+        local.meshlets++;
+        local.triangles += meshlet.triangleCount;
+
+        if(!frustumTestSphere(frustum, meshlet.sphere))
+        {
+            local.frustumCulled++;
+            continue;
+        }
+
+        Vector3D view = meshlet.sphere.center - camera;
+        if(dot(view, meshlet.coneAxis) >= meshlet.coneCutoff * length(view) + meshlet.sphere.radius)
+        {
+            local.backfaceCulled++;
+            continue;
+        }
+
+        local.visibleMeshlets++;
+        local.visibleTriangles += meshlet.triangleCount;
+
+        if(rangeEnd == meshlet.firstIndex)
+        {
+            drawList.counts.back() += GLsizei(meshlet.triangleCount * 3);
+        }
+        else
+        {
+            drawList.counts.push_back(GLsizei(meshlet.triangleCount * 3));
+            drawList.offsets.push_back((const void*) (std::size_t(mesh.firstIndex + meshlet.firstIndex) * sizeof(unsigned int)));
+            drawList.baseVertices.push_back(GLint(mesh.baseVertex));
+        }
+        rangeEnd = meshlet.firstIndex + meshlet.triangleCount * 3;
+    }
+
+    if(stats)
+    {
+        stats->meshlets += local.meshlets;
+        stats->visibleMeshlets += local.visibleMeshlets;
+        stats->frustumCulled += local.frustumCulled;
+        stats->backfaceCulled += local.backfaceCulled;
+        stats->triangles += local.triangles;
+        stats->visibleTriangles += local.visibleTriangles;
+    }
+}
+
+void meshletDrawListClear(MeshletDrawList& drawList)
+{
+    drawList.counts.clear();
+    drawList.offsets.clear();
+    drawList.baseVertices.clear();
+}
+
+void meshletDraw(const MeshletDrawList& drawList)
+{
+    if(drawList.counts.empty())
+    {
+        return;
+    }
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawList.counts.data(), GL_UNSIGNED_INT, drawList.offsets.data(),
+                                  GLsizei(drawList.counts.size()), drawList.baseVertices.data());
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "mesh.h"
+#include "frustum.h"
+
+#include <vector>
+
+constexpr unsigned int MESHLET_MAX_VERTICES = 64;
+constexpr unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+/**
+ * Cluster of consecutive triangles of a mesh. The triangles are the index range [firstIndex, firstIndex + 3 *
+ * triangleCount) relative to the first index of the mesh. sphere bounds the cluster and the normal cone (coneAxis,
+ * coneCutoff) allows rejecting clusters that face away from the camera, coneCutoff is 1 if the cone is too wide.
+ */
+struct Meshlet
+{
+    unsigned int firstIndex = 0;
+    unsigned int triangleCount = 0;
+    unsigned int vertexCount = 0;
+
+    BoundingSphere sphere;
+    Vector3D coneAxis;
+    float coneCutoff = 1.0f;
+};
+
+/**
+ * Ranges for glMultiDrawElementsBaseVertex produced by meshletCull(...). Neighbouring visible meshlets are merged into
+ * one range.
+ */
+struct MeshletDrawList
+{
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+};
+
+struct MeshletCullStats
+{
+    unsigned int meshlets = 0;
+    unsigned int visibleMeshlets = 0;
+    unsigned int frustumCulled = 0;
+    unsigned int backfaceCulled = 0;
+
+    std::size_t triangles = 0;
+    std::size_t visibleTriangles = 0;
+
+    float culledPercent() const { return triangles ? 100.0f * float(triangles - visibleTriangles) / float(triangles) : 0.0f; }
+};
+
+/**
+ * @brief Split an index buffer into meshlets of consecutive triangles with at most maxVertices unique vertices and
+ * maxTriangles triangles each, and compute their bounding spheres and normal cones.
+ *
+ * @param vertices Vertex data of the mesh.
+ * @param indices Triangle indices of the mesh (same data as uploaded with meshCreate(...)).
+ * @param maxVertices Maximum number of unique vertices per meshlet.
+ * @param maxTriangles Maximum number of triangles per meshlet.
+ *
+ * @return Meshlets covering all triangles in index order.
+ */
+std::vector<Meshlet> meshletBuild(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                  unsigned int maxVertices = MESHLET_MAX_VERTICES, unsigned int maxTriangles = MESHLET_MAX_TRIANGLES);
+
+/**
+ * @brief Cull meshlets of a mesh against the view frustum and by their normal cones, and append the draw ranges of the
+ * remaining ones. Culling is done in model space, the cone test assumes the model matrix has a uniform scale.
+ *
+ * @param mesh Mesh the meshlets were built for.
+ * @param meshlets Meshlets of the mesh.
+ * @param model Model matrix of the mesh.
+ * @param viewProjection Projection * view matrix of the camera.
+ * @param cameraPosition Camera position in world space.
+ * @param drawList Visible ranges are appended to this list.
+ * @param stats Optional, statistics are accumulated into it.
+ */
+void meshletCull(const Mesh& mesh, const std::vector<Meshlet>& meshlets, const Matrix4D& model, const Matrix4D& viewProjection,
+                 const Vector3D& cameraPosition, MeshletDrawList& drawList, MeshletCullStats* stats = nullptr);
+
+/**
+ * @brief Clear a draw list for the next frame, keeping its memory.
+ */
+void meshletDrawListClear(MeshletDrawList& drawList);
+
+/**
+ * @brief Draw all ranges of a draw list with one glMultiDrawElementsBaseVertex call. The VAO of the mesh has to be
+ * bound.
+ *
+ * usage:
+ *
+ *   meshletDrawListClear(drawList);
+ *   meshletCull(myMesh, myMeshlets, model, cameraViewProjection(cam), cam.position, drawList);
+ *   glStateBindVertexArray(myMesh.vao);
+ *   meshletDraw(drawList);
+ *
+ */
+void meshletDraw(const MeshletDrawList& drawList);
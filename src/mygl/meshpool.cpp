@@ -0,0 +1,360 @@
+#include "meshpool.h"
+#include "mesh.h"
+#include "glstate.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace detail
+{
+    struct MeshPool
+    {
+        unsigned int pageVertices = 1u << 18;
+        unsigned int pageIndices = 1u << 20;
+        std::vector<MeshPoolPage> pages;
+
+        GLuint instanceBuffer = 0;
+        std::size_t instanceOffset = 0;
+    };
+
+    MeshPool& pool()
+    {
+        static MeshPool meshPool;
+        return meshPool;
+    }
+
+    MeshPoolPage createPage(unsigned int vertexCount, unsigned int indexCount, GLenum vertexBufferUsage, GLenum indexBufferUsage)
+    {
+        MeshPoolPage page;
+        page.vertexBufferUsage = vertexBufferUsage;
+        page.indexBufferUsage = indexBufferUsage;
+        page.vertices = rangeAllocatorCreate(vertexCount);
+        page.indices = rangeAllocatorCreate(indexCount);
+
+        glGenVertexArrays(1, &page.vao);
+        glGenBuffers(1, &page.vbo);
+        glGenBuffers(1, &page.ebo);
+
+        glStateBindVertexArray(page.vao);
+        {
+            glStateBindBuffer(GL_ARRAY_BUFFER, page.vbo);
+            glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(vertexCount) * sizeof(Vertex), nullptr, vertexBufferUsage);
+            glCheckError();
+
+            glStateBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.ebo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(indexCount) * sizeof(unsigned int), nullptr, indexBufferUsage);
+            glCheckError();
+
+            glEnableVertexAttribArray(eDataIdx::Position);
+            glEnableVertexAttribArray(eDataIdx::Color);
+            glVertexAttribPointer(eDataIdx::Position,   3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, pos));
+            glVertexAttribPointer(eDataIdx::Color,      4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, color));
+            glCheckError();
+        }
+
+        return page;
+    }
+
+    void instanceBufferCreate(MeshPool& meshPool)
+    {
+        if(!glVertexAttribDivisorARB)
+        {
+            std::cerr << "[MeshPool] Instanced arrays are not supported by the OpenGL context!" << std::endl;
+            std::cerr.flush();
+            throw std::runtime_error("[MeshPool] Instanced arrays are not supported by the OpenGL context!");
+        }
+
+        glGenBuffers(1, &meshPool.instanceBuffer);
+        glStateBindBuffer(GL_ARRAY_BUFFER, meshPool.instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(MESHPOOL_INSTANCE_BUFFER_SIZE), nullptr, GL_STREAM_DRAW);
+        glCheckError();
+        meshPool.instanceOffset = 0;
+    }
+
+    float fragmentation(const RangeAllocator& allocator, unsigned int largestFree)
+    {
+        unsigned int totalFree = allocator.capacity - allocator.used;
+        return totalFree == 0 ? 0.0f : 1.0f - float(largestFree) / float(totalFree);
+    }
+}
+
+RangeAllocator rangeAllocatorCreate(unsigned int capacity)
+{
+    RangeAllocator allocator;
+    allocator.capacity = capacity;
+    if(capacity > 0)
+    {
+        allocator.freeBlocks.push_back({0, capacity});
+    }
+    return allocator;
+}
+
+bool rangeAllocate(RangeAllocator& allocator, unsigned int size, unsigned int& offset)
+{
+    if(size == 0)
+    {
+        offset = 0;
+        return true;
+    }
+
+    /* best fit keeps large blocks intact for large meshes */
+    auto best = allocator.freeBlocks.end();
+    for(auto it = allocator.freeBlocks.begin(); it != allocator.freeBlocks.end(); ++it)
+    {
+        if(it->size >= size && (best == allocator.freeBlocks.end() || it->size < best->size))
+        {
+            best = it;
+            if(best->size == size) { break; }
+        }
+    }
+
+    if(best == allocator.freeBlocks.end())
+    {
+        return false;
+    }
+
+    offset = best->offset;
+    best->offset += size;
+    best->size -= size;
+    if(best->size == 0)
+    {
+        allocator.freeBlocks.erase(best);
+    }
+    allocator.used += size;
+
+    return true;
+}
+
+void rangeFree(RangeAllocator& allocator, unsigned int offset, unsigned int size)
+{
+    if(size == 0) { return; }
+
+    auto& blocks = allocator.freeBlocks;
+    auto next = std::lower_bound(blocks.begin(), blocks.end(), offset,
+                                 [](const RangeAllocator::Block& b, unsigned int o) { return b.offset < o; });
+
+    bool mergePrev = next != blocks.begin() && std::prev(next)->offset + std::prev(next)->size == offset;
+    bool mergeNext = next != blocks.end() && offset + size == next->offset;
+
+    if(mergePrev && mergeNext)
+    {
+        std::prev(next)->size += size + next->size;
+        blocks.erase(next);
+    }
+    else if(mergePrev)
+    {
+        std::prev(next)->size += size;
+    }
+    else if(mergeNext)
+    {
+        next->offset = offset;
+        next->size += size;
+    }
+    else
+    {
+        blocks.insert(next, {offset, size});
+    }
+
+    allocator.used -= size;
+}
+
+void meshPoolSetPageSize(unsigned int vertexCount, unsigned int indexCount)
+{
+    detail::pool().pageVertices = vertexCount;
+    detail::pool().pageIndices = indexCount;
+}
+
+MeshPoolAllocation meshPoolAllocate(unsigned int vertexCount, unsigned int indexCount, GLenum vertexBufferUsage, GLenum indexBufferUsage)
+{
+    auto& pool = detail::pool();
+    MeshPoolAllocation allocation;
+
+    for(unsigned int i = 0; i < pool.pages.size(); i++)
+    {
+        MeshPoolPage& page = pool.pages[i];
+        if(page.vertexBufferUsage != vertexBufferUsage || page.indexBufferUsage != indexBufferUsage)
+        {
+            continue;
+        }
+
+        if(!rangeAllocate(page.vertices, vertexCount, allocation.baseVertex))
+        {
+            continue;
+        }
+        if(!rangeAllocate(page.indices, indexCount, allocation.firstIndex))
+        {
+            rangeFree(page.vertices, allocation.baseVertex, vertexCount);
+            continue;
+        }
+
+        allocation.page = i;
+        return allocation;
+    }
+
+    /* no page with enough space left, meshes larger than the default page size get a page of their own */
+    pool.pages.push_back(detail::createPage(std::max(vertexCount, pool.pageVertices), std::max(indexCount, pool.pageIndices),
+                                            vertexBufferUsage, indexBufferUsage));
+    MeshPoolPage& page = pool.pages.back();
+
+    if(!rangeAllocate(page.vertices, vertexCount, allocation.baseVertex) || !rangeAllocate(page.indices, indexCount, allocation.firstIndex))
+    {
+        std::cerr << "[MeshPool] Couldn't allocate mesh in new page!" << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[MeshPool] Couldn't allocate mesh in new page!");
+    }
+
+    allocation.page = (unsigned int) pool.pages.size() - 1;
+    return allocation;
+}
+
+void meshPoolFree(const MeshPoolAllocation& allocation, unsigned int vertexCount, unsigned int indexCount)
+{
+    MeshPoolPage& page = detail::pool().pages.at(allocation.page);
+    rangeFree(page.vertices, allocation.baseVertex, vertexCount);
+    rangeFree(page.indices, allocation.firstIndex, indexCount);
+}
+
+const MeshPoolPage& meshPoolPage(unsigned int page)
+{
+    return detail::pool().pages.at(page);
+}
+
+GLuint meshPoolInstancedVao(unsigned int pageIndex)
+{
+    detail::MeshPool& pool = detail::pool();
+    MeshPoolPage& page = pool.pages.at(pageIndex);
+    if(page.vaoInstanced)
+    {
+        return page.vaoInstanced;
+    }
+    if(!pool.instanceBuffer)
+    {
+        detail::instanceBufferCreate(pool);
+    }
+
+    glGenVertexArrays(1, &page.vaoInstanced);
+    glStateBindVertexArray(page.vaoInstanced);
+    {
+        glStateBindBuffer(GL_ARRAY_BUFFER, page.vbo);
+        glStateBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.ebo);
+        glEnableVertexAttribArray(eDataIdx::Position);
+        glEnableVertexAttribArray(eDataIdx::Color);
+        glVertexAttribPointer(eDataIdx::Position,   3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, pos));
+        glVertexAttribPointer(eDataIdx::Color,      4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, color));
+
+        /* a mat4 attribute occupies one location per column */
+        for(unsigned int column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(eDataIdx::InstanceModel + column);
+            glVertexAttribDivisorARB(eDataIdx::InstanceModel + column, 1);
+        }
+        glVertexAttribDivisorARB(eDataIdx::InstanceColor, 1);
+        glCheckError();
+    }
+
+    return page.vaoInstanced;
+}
+
+GLuint meshPoolInstanceBuffer()
+{
+    detail::MeshPool& pool = detail::pool();
+    if(!pool.instanceBuffer)
+    {
+        detail::instanceBufferCreate(pool);
+    }
+    return pool.instanceBuffer;
+}
+
+void* meshPoolMapInstances(std::size_t bytes, std::size_t& offset)
+{
+    detail::MeshPool& pool = detail::pool();
+    if(!pool.instanceBuffer)
+    {
+        detail::instanceBufferCreate(pool);
+    }
+    if(bytes > MESHPOOL_INSTANCE_BUFFER_SIZE)
+    {
+        std::cerr << "[MeshPool] Instance data exceeds the instance buffer!" << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[MeshPool] Instance data exceeds the instance buffer!");
+    }
+
+    glStateBindBuffer(GL_ARRAY_BUFFER, pool.instanceBuffer);
+
+    /* ranges start 16 byte aligned, when the buffer is full its storage is orphaned and writing restarts at 0 */
+    pool.instanceOffset = (pool.instanceOffset + 15) & ~std::size_t(15);
+    if(pool.instanceOffset + bytes > MESHPOOL_INSTANCE_BUFFER_SIZE)
+    {
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(MESHPOOL_INSTANCE_BUFFER_SIZE), nullptr, GL_STREAM_DRAW);
+        pool.instanceOffset = 0;
+    }
+
+    offset = pool.instanceOffset;
+    pool.instanceOffset += bytes;
+    void* data = glMapBufferRange(GL_ARRAY_BUFFER, GLintptr(offset), GLsizeiptr(bytes),
+                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if(!data)
+    {
+        std::cerr << "[MeshPool] Couldn't map the instance buffer!" << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[MeshPool] Couldn't map the instance buffer!");
+    }
+    return data;
+}
+
+void meshPoolUnmapInstances()
+{
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+MeshPoolStats meshPoolStats()
+{
+    MeshPoolStats stats;
+    RangeAllocator vertexTotal, indexTotal;
+
+    for(const MeshPoolPage& page : detail::pool().pages)
+    {
+        stats.pages++;
+
+        vertexTotal.capacity += page.vertices.capacity;
+        vertexTotal.used += page.vertices.used;
+        indexTotal.capacity += page.indices.capacity;
+        indexTotal.used += page.indices.used;
+
+        stats.vertexFreeBlocks += (unsigned int) page.vertices.freeBlocks.size();
+        stats.indexFreeBlocks += (unsigned int) page.indices.freeBlocks.size();
+        for(const auto& block : page.vertices.freeBlocks) { stats.vertexLargestFree = std::max(stats.vertexLargestFree, block.size); }
+        for(const auto& block : page.indices.freeBlocks)  { stats.indexLargestFree = std::max(stats.indexLargestFree, block.size); }
+    }
+
+    stats.vertexCapacity = vertexTotal.capacity;
+    stats.vertexUsed = vertexTotal.used;
+    stats.indexCapacity = indexTotal.capacity;
+    stats.indexUsed = indexTotal.used;
+
+    stats.vertexOccupancy = stats.vertexCapacity ? float(stats.vertexUsed) / float(stats.vertexCapacity) : 0.0f;
+    stats.indexOccupancy = stats.indexCapacity ? float(stats.indexUsed) / float(stats.indexCapacity) : 0.0f;
+    stats.vertexFragmentation = detail::fragmentation(vertexTotal, stats.vertexLargestFree);
+    stats.indexFragmentation = detail::fragmentation(indexTotal, stats.indexLargestFree);
+
+    return stats;
+}
+
+void meshPoolRelease()
+{
+    for(const MeshPoolPage& page : detail::pool().pages)
+    {
+        glStateDeleteBuffer(page.vbo);
+        glStateDeleteBuffer(page.ebo);
+        glStateDeleteVertexArray(page.vao);
+        if(page.vaoInstanced) { glStateDeleteVertexArray(page.vaoInstanced); }
+    }
+    detail::pool().pages.clear();
+
+    if(detail::pool().instanceBuffer)
+    {
+        glStateDeleteBuffer(detail::pool().instanceBuffer);
+        detail::pool().instanceBuffer = 0;
+    }
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "base.h"
+
+#include <vector>
+
+/**
+ * Free-list allocator over a linear range of elements (vertices or indices). Free blocks are kept sorted by offset so
+ * that neighbouring blocks can be coalesced when a range is released.
+ */
+struct RangeAllocator
+{
+    struct Block
+    {
+        unsigned int offset;
+        unsigned int size;
+    };
+
+    unsigned int capacity = 0;
+    unsigned int used = 0;
+    std::vector<Block> freeBlocks;
+};
+
+/**
+ * @brief Create a range allocator managing the elements [0, capacity).
+ *
+ * @param capacity Number of elements that can be handed out.
+ *
+ * @return Initialized allocator with a single free block.
+ */
+RangeAllocator rangeAllocatorCreate(unsigned int capacity);
+
+/**
+ * @brief Allocate a contiguous range of elements (best fit).
+ *
+ * @param allocator Allocator to allocate from.
+ * @param size Number of elements.
+ * @param offset Receives the first element of the range on success.
+ *
+ * @return False if no free block is large enough.
+ */
+bool rangeAllocate(RangeAllocator& allocator, unsigned int size, unsigned int& offset);
+
+/**
+ * @brief Return a range of elements previously obtained from rangeAllocate(...) to the allocator.
+ *
+ * @param allocator Allocator the range was allocated from.
+ * @param offset First element of the range.
+ * @param size Number of elements.
+ */
+void rangeFree(RangeAllocator& allocator, unsigned int offset, unsigned int size);
+
+/* size of the streaming buffer for per-instance data in bytes */
+constexpr std::size_t MESHPOOL_INSTANCE_BUFFER_SIZE = std::size_t(1) << 24;
+
+/**
+ * One page of the mesh pool: a large vertex and index buffer pair together with the vertex array object that
+ * describes the vertex format. All meshes living in a page are drawn from the same VAO. vaoInstanced additionally
+ * sources the per-instance attributes from the instance buffer and is only created when needed.
+ */
+struct MeshPoolPage
+{
+    GLuint vao = 0;
+    GLuint vaoInstanced = 0;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+
+    GLenum vertexBufferUsage = GL_STATIC_DRAW;
+    GLenum indexBufferUsage = GL_STATIC_DRAW;
+
+    RangeAllocator vertices;
+    RangeAllocator indices;
+};
+
+/**
+ * Location of a mesh inside the pool.
+ */
+struct MeshPoolAllocation
+{
+    unsigned int page = 0;
+    unsigned int baseVertex = 0;
+    unsigned int firstIndex = 0;
+};
+
+struct MeshPoolStats
+{
+    unsigned int pages = 0;
+
+    unsigned int vertexCapacity = 0;
+    unsigned int vertexUsed = 0;
+    unsigned int indexCapacity = 0;
+    unsigned int indexUsed = 0;
+
+    /* number of free blocks and size of the largest one, summed/maxed over all pages (in elements) */
+    unsigned int vertexFreeBlocks = 0;
+    unsigned int vertexLargestFree = 0;
+    unsigned int indexFreeBlocks = 0;
+    unsigned int indexLargestFree = 0;
+
+    /* fraction of used elements, 0..1 */
+    float vertexOccupancy = 0.0f;
+    float indexOccupancy = 0.0f;
+
+    /* 1 - largestFreeBlock / totalFree, 0 means all free space is in one block */
+    float vertexFragmentation = 0.0f;
+    float indexFragmentation = 0.0f;
+};
+
+/**
+ * @brief Set the number of vertices and indices of newly created pool pages. Meshes that do not fit into a default page
+ * get a page of their own size.
+ *
+ * @param vertexCount Vertices per page.
+ * @param indexCount Indices per page.
+ */
+void meshPoolSetPageSize(unsigned int vertexCount, unsigned int indexCount);
+
+/**
+ * @brief Reserve space for a mesh in a page with matching buffer usage. A new page is created if no existing page has
+ * enough free space.
+ *
+ * @param vertexCount Number of vertices of the mesh.
+ * @param indexCount Number of indices of the mesh.
+ * @param vertexBufferUsage Usage hint of the vertex buffer (see usage parameter in glBufferData function).
+ * @param indexBufferUsage Usage hint of the index buffer (see usage parameter in glBufferData function).
+ *
+ * @return Page and offsets of the reserved ranges.
+ */
+MeshPoolAllocation meshPoolAllocate(unsigned int vertexCount, unsigned int indexCount, GLenum vertexBufferUsage, GLenum indexBufferUsage);
+
+/**
+ * @brief Release ranges obtained from meshPoolAllocate(...). The GL buffers of the page are kept for reuse.
+ */
+void meshPoolFree(const MeshPoolAllocation& allocation, unsigned int vertexCount, unsigned int indexCount);
+
+/**
+ * @brief Access a page of the pool, e.g. to get its VAO or buffers.
+ */
+const MeshPoolPage& meshPoolPage(unsigned int page);
+
+/**
+ * @brief Get the instanced vertex array object of a page, creating it on first use. It shares the vertex and index
+ * buffer of the page and has the attributes eDataIdx::InstanceModel (4 columns) and eDataIdx::InstanceColor enabled
+ * with a divisor of 1. Their pointers into the instance buffer are set per draw.
+ */
+GLuint meshPoolInstancedVao(unsigned int page);
+
+/**
+ * @brief Get the buffer object per-instance data is streamed into.
+ */
+GLuint meshPoolInstanceBuffer();
+
+/**
+ * @brief Map a range of the instance buffer for writing. Ranges are handed out round robin without synchronization,
+ * the buffer storage is orphaned when the end is reached so the driver never has to wait for pending draws.
+ *
+ * @param bytes Size of the range, at most MESHPOOL_INSTANCE_BUFFER_SIZE.
+ * @param offset Receives the byte offset of the range inside the instance buffer.
+ *
+ * @return Pointer to write the data to, valid until meshPoolUnmapInstances() is called.
+ */
+void* meshPoolMapInstances(std::size_t bytes, std::size_t& offset);
+
+/**
+ * @brief Unmap the range returned by meshPoolMapInstances(...). The instance buffer stays bound to GL_ARRAY_BUFFER.
+ */
+void meshPoolUnmapInstances();
+
+/**
+ * @brief Collect occupancy and fragmentation statistics over all pages.
+ */
+MeshPoolStats meshPoolStats();
+
+/**
+ * @brief Delete the OpenGL buffers of all pages and the instance buffer. Has to be called once after all meshes are
+ * deleted.
+ */
+void meshPoolRelease();
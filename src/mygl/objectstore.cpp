@@ -0,0 +1,183 @@
+#include "objectstore.h"
+#include "profiler.h"
+
+namespace detail
+{
+    /* objects per chunk of the parallel systems */
+    constexpr std::size_t OBJECTSTORE_GRAIN = 4096;
+}
+
+ObjectHandle objectStoreAdd(ObjectStore& store, const Mesh* mesh, const Matrix4D& local, SceneNode parent, float spin)
+{
+    uint32_t slot;
+    if(!store._freeSlots.empty())
+    {
+        slot = store._freeSlots.back();
+        store._freeSlots.pop_back();
+    }
+    else
+    {
+        slot = uint32_t(store._denseOf.size());
+        store._denseOf.push_back(OBJECTSTORE_INVALID);
+        store._generations.push_back(0);
+    }
+
+    store._denseOf[slot] = uint32_t(store.local.size());
+    store._slotOf.push_back(slot);
+
+    store.local.push_back(local);
+    store.parent.push_back(parent);
+    store.world.push_back(local);
+    store.mesh.push_back(mesh);
+    store.localBounds.push_back(mesh->bounds);
+    Bounds world;
+    boundsTransform(&mesh->bounds, &local, &world, 1);
+    store.worldBounds.push_back(world);
+    store.bounds.push_back(world.box);
+    store.spin.push_back(spin);
+    store.dirty.push_back(1);
+    store._anyDirty = true;
+
+    return ObjectHandle{slot, store._generations[slot]};
+}
+
+bool objectStoreRemove(ObjectStore& store, ObjectHandle handle)
+{
+    const uint32_t index = objectStoreIndex(store, handle);
+    if(index == OBJECTSTORE_INVALID)
+    {
+        return false;
+    }
+
+    /* move the last object into the gap */
+    const uint32_t last = uint32_t(store.local.size() - 1);
+    if(index != last)
+    {
+        store.local[index] = store.local[last];
+        store.parent[index] = store.parent[last];
+        store.world[index] = store.world[last];
+        store.mesh[index] = store.mesh[last];
+        store.localBounds[index] = store.localBounds[last];
+        store.worldBounds[index] = store.worldBounds[last];
+        store.bounds[index] = store.bounds[last];
+        store.spin[index] = store.spin[last];
+        store.dirty[index] = store.dirty[last];
+        store._slotOf[index] = store._slotOf[last];
+        store._denseOf[store._slotOf[index]] = index;
+    }
+    store.local.pop_back();
+    store.parent.pop_back();
+    store.world.pop_back();
+    store.mesh.pop_back();
+    store.localBounds.pop_back();
+    store.worldBounds.pop_back();
+    store.bounds.pop_back();
+    store.spin.pop_back();
+    store.dirty.pop_back();
+    store._slotOf.pop_back();
+
+    store._denseOf[handle.slot] = OBJECTSTORE_INVALID;
+    store._generations[handle.slot]++;
+    store._freeSlots.push_back(handle.slot);
+    return true;
+}
+
+uint32_t objectStoreIndex(const ObjectStore& store, ObjectHandle handle)
+{
+    if(handle.slot >= store._denseOf.size() || store._generations[handle.slot] != handle.generation)
+    {
+        return OBJECTSTORE_INVALID;
+    }
+    return store._denseOf[handle.slot];
+}
+
+std::size_t objectStoreSize(const ObjectStore& store)
+{
+    return store.local.size();
+}
+
+void objectStoreClear(ObjectStore& store)
+{
+    for(uint32_t slot : store._slotOf)
+    {
+        store._denseOf[slot] = OBJECTSTORE_INVALID;
+        store._generations[slot]++;
+        store._freeSlots.push_back(slot);
+    }
+    store.local.clear();
+    store.parent.clear();
+    store.world.clear();
+    store.mesh.clear();
+    store.localBounds.clear();
+    store.worldBounds.clear();
+    store.bounds.clear();
+    store.spin.clear();
+    store.dirty.clear();
+    store._anyDirty = false;
+    store._slotOf.clear();
+}
+
+void objectStoreSpin(ObjectStore& store, float directionX, float directionY, float dt, JobScheduler* scheduler)
+{
+    if(directionX == 0.0f && directionY == 0.0f)
+    {
+        return;
+    }
+
+    jobParallelFor(scheduler, store.local.size(), [&](std::size_t begin, std::size_t end)
+    {
+        for(std::size_t i = begin; i < end; i++)
+        {
+            const float angle = store.spin[i] * dt;
+            if(angle != 0.0f)
+            {
+                store.local[i] = Matrix4D::rotationY(directionY * angle) * Matrix4D::rotationX(directionX * angle) * store.local[i];
+                store.dirty[i] = 1;
+            }
+        }
+    }, detail::OBJECTSTORE_GRAIN);
+    store._anyDirty = true;
+}
+
+void objectStoreUpdateTransforms(ObjectStore& store, const SceneGraph& graph, JobScheduler* scheduler)
+{
+    PROFILE_SCOPE("objectStoreUpdateTransforms");
+
+    if(!store._anyDirty && graph.stats.recomputed == 0)
+    {
+        return;
+    }
+
+    jobParallelFor(scheduler, store.local.size(), [&](std::size_t begin, std::size_t end)
+    {
+        /* bounds of a run of updated objects are transformed together, runs end at the first object that is kept */
+        std::size_t run = begin;
+        for(std::size_t i = begin; i <= end; i++)
+        {
+            bool update = false;
+            if(i < end)
+            {
+                const SceneNode parent = store.parent[i];
+                update = store.dirty[i] || (parent != SCENEGRAPH_NO_PARENT && graph.changed[parent]);
+                if(update)
+                {
+                    store.world[i] = parent == SCENEGRAPH_NO_PARENT ? store.local[i] : graph.world[parent] * store.local[i];
+                    store.dirty[i] = 0;
+                }
+            }
+            if(!update)
+            {
+                if(i > run)
+                {
+                    boundsTransform(&store.localBounds[run], &store.world[run], &store.worldBounds[run], i - run);
+                    for(std::size_t k = run; k < i; k++)
+                    {
+                        store.bounds[k] = store.worldBounds[k].box;
+                    }
+                }
+                run = i + 1;
+            }
+        }
+    }, detail::OBJECTSTORE_GRAIN);
+    store._anyDirty = false;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "mesh.h"
+#include "bounds.h"
+#include "scenegraph.h"
+#include "jobs.h"
+
+#include <cstdint>
+#include <vector>
+
+constexpr uint32_t OBJECTSTORE_INVALID = ~0u;
+
+/**
+ * Stable reference to an object of an ObjectStore. The generation of a slot is increased every time its object is
+ * removed, so handles to removed objects are detected even after the slot has been reused.
+ */
+struct ObjectHandle
+{
+    uint32_t slot = OBJECTSTORE_INVALID;
+    uint32_t generation = 0;
+};
+
+/**
+ * Objects stored as densely packed component arrays, all indexed by the same dense index. Removing an object moves the
+ * last object into its place, so dense indices change on removal while handles stay valid.
+ *
+ * Components:
+ *   local  - transformation relative to the parent node
+ *   parent - scene graph node the object is attached to, SCENEGRAPH_NO_PARENT for none
+ *   world  - model matrix, written by objectStoreUpdateTransforms(...)
+ *   mesh   - mesh drawn for the object, not owned by the store
+ *   localBounds - model space bounds of the mesh, copied on add so the transform system reads one dense array
+ *   worldBounds - world space box and sphere, written by objectStoreUpdateTransforms(...)
+ *   bounds - world space box alone (the box of worldBounds), the array the BVH is built and refit from
+ *   spin   - rotation speed in radians per second used by objectStoreSpin(...)
+ *   dirty  - local matrix changed since the last objectStoreUpdateTransforms(...)
+ */
+struct ObjectStore
+{
+    std::vector<Matrix4D> local;
+    std::vector<SceneNode> parent;
+    std::vector<Matrix4D> world;
+    std::vector<const Mesh*> mesh;
+    std::vector<Bounds> localBounds;
+    std::vector<Bounds> worldBounds;
+    std::vector<AABB> bounds;
+    std::vector<float> spin;
+    std::vector<uint8_t> dirty;
+    bool _anyDirty = false;
+
+    /* dense index -> slot and slot -> dense index/generation */
+    std::vector<uint32_t> _slotOf;
+    std::vector<uint32_t> _denseOf;
+    std::vector<uint32_t> _generations;
+    std::vector<uint32_t> _freeSlots;
+};
+
+/**
+ * @brief Add an object in O(1). Its world matrix and bounds are valid after the next objectStoreUpdateTransforms(...).
+ *
+ * @param store Object store.
+ * @param mesh Mesh of the object, has to outlive the object.
+ * @param local Transformation relative to the parent node.
+ * @param parent Scene graph node the object is attached to.
+ * @param spin Rotation speed in radians per second.
+ *
+ * @return Handle of the new object.
+ */
+ObjectHandle objectStoreAdd(ObjectStore& store, const Mesh* mesh, const Matrix4D& local, SceneNode parent = SCENEGRAPH_NO_PARENT, float spin = 0.0f);
+
+/**
+ * @brief Remove an object in O(1) by moving the last object into its place.
+ *
+ * @param store Object store.
+ * @param handle Object to remove.
+ *
+ * @return False if the handle doesn't refer to an object of the store (anymore).
+ */
+bool objectStoreRemove(ObjectStore& store, ObjectHandle handle);
+
+/**
+ * @brief Look up the dense index of an object, e.g. to access store.world[index].
+ *
+ * @param store Object store.
+ * @param handle Object to look up.
+ *
+ * @return Dense index, OBJECTSTORE_INVALID for stale or invalid handles.
+ */
+uint32_t objectStoreIndex(const ObjectStore& store, ObjectHandle handle);
+
+/**
+ * @brief Number of objects in the store.
+ */
+std::size_t objectStoreSize(const ObjectStore& store);
+
+/**
+ * @brief Remove all objects, keeping the memory. All handles become stale.
+ *
+ * @param store Object store.
+ */
+void objectStoreClear(ObjectStore& store);
+
+/**
+ * @brief Spin system: rotate the local matrix of every object with a spin speed around the x and y axis of its parent
+ * space, like local = rotationY(directionY * spin * dt) * rotationX(directionX * spin * dt) * local.
+ *
+ * @param store Object store.
+ * @param directionX Rotation direction around the x axis (-1, 0, 1).
+ * @param directionY Rotation direction around the y axis (-1, 0, 1).
+ * @param dt Time step in seconds.
+ * @param scheduler Job scheduler to run the loop on, nullptr runs it on the calling thread.
+ */
+void objectStoreSpin(ObjectStore& store, float directionX, float directionY, float dt, JobScheduler* scheduler = nullptr);
+
+/**
+ * @brief Transform system: compute the world matrix and world space bounds of every object that is dirty or whose parent
+ * node was recomputed by the last sceneGraphUpdate(...), from its local matrix and the world matrix of its parent node.
+ * The bounds of consecutive updated objects are transformed in batches with boundsTransform(...).
+ *
+ * @param store Object store.
+ * @param graph Scene graph the parent nodes belong to, has to be updated before.
+ * @param scheduler Job scheduler to run the loop on, nullptr runs it on the calling thread.
+ *
+ * usage:
+ *
+ *   objectStoreSpin(store, 0.0f, 1.0f, dt, scheduler);
+ *   sceneGraphUpdate(graph);
+ *   objectStoreUpdateTransforms(store, graph, scheduler);
+ *   // store.world[i], store.bounds[i], ...
+ *
+ */
+void objectStoreUpdateTransforms(ObjectStore& store, const SceneGraph& graph, JobScheduler* scheduler = nullptr);
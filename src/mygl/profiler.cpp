@@ -0,0 +1,293 @@
+#include "profiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace detail
+{
+    /* thread id 0 is the GPU timeline in traces */
+    constexpr uint32_t PROFILER_GPU_THREAD = 0;
+
+    struct ProfilerCapturedEvent
+    {
+        uint32_t thread;
+        ProfilerEvent event;
+    };
+
+    struct Profiler
+    {
+        const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        /* only locked to register a thread and while collecting */
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ProfilerThreadBuffer>> threads;
+
+        /* begin and end timestamp query per scope, per frame in flight */
+        GLuint queries[PROFILER_GPU_FRAMES][2 * PROFILER_GPU_SCOPES] = {};
+        const char* gpuNames[PROFILER_GPU_FRAMES][PROFILER_GPU_SCOPES] = {};
+        unsigned int gpuCount[PROFILER_GPU_FRAMES] = {};
+
+        /* profiler clock - GPU clock, sampled at the first GPU scope of a frame */
+        int64_t gpuOffset[PROFILER_GPU_FRAMES] = {};
+        unsigned int frame = 0;
+        bool queriesCreated = false;
+
+        bool capturing = false;
+        unsigned int captureFrames = 0;
+        unsigned int capturedFrames = 0;
+        std::string capturePath;
+        std::vector<ProfilerCapturedEvent> captured;
+        uint64_t gpuDropped = 0;
+    };
+
+    Profiler& profiler()
+    {
+        static Profiler instance;
+        return instance;
+    }
+
+    thread_local ProfilerThreadBuffer* profilerThreadBuffer = nullptr;
+
+    ProfilerThreadBuffer& profilerThread()
+    {
+        if(!profilerThreadBuffer)
+        {
+            Profiler& p = profiler();
+            std::lock_guard<std::mutex> lock(p.mutex);
+            p.threads.push_back(std::make_unique<ProfilerThreadBuffer>());
+            profilerThreadBuffer = p.threads.back().get();
+            profilerThreadBuffer->id = uint32_t(p.threads.size());
+            profilerThreadBuffer->name = "thread " + std::to_string(profilerThreadBuffer->id);
+        }
+        return *profilerThreadBuffer;
+    }
+
+    uint64_t profilerNow()
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profiler().epoch).count());
+    }
+
+    /* reads the timestamps of a frame slot, false if they are not there yet and waiting isn't allowed */
+    bool profilerReadGpu(Profiler& p, unsigned int slot, bool wait)
+    {
+        const unsigned int count = p.gpuCount[slot];
+        if(count == 0)
+        {
+            return true;
+        }
+
+        /* with nested scopes the last end query isn't the last one issued, check them all */
+        for(unsigned int i = 0; i < count && !wait; i++)
+        {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(p.queries[slot][2 * i + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if(available == GL_FALSE)
+            {
+                return false;
+            }
+        }
+
+        for(unsigned int i = 0; i < count && p.capturing; i++)
+        {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(p.queries[slot][2 * i], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(p.queries[slot][2 * i + 1], GL_QUERY_RESULT, &end);
+            const int64_t offset = p.gpuOffset[slot];
+            p.captured.push_back({PROFILER_GPU_THREAD, {p.gpuNames[slot][i], uint64_t(int64_t(begin) + offset),
+                                                        uint64_t(int64_t(end) + offset)}});
+        }
+        return true;
+    }
+
+    void profilerCollect(Profiler& p)
+    {
+        std::lock_guard<std::mutex> lock(p.mutex);
+        for(const std::unique_ptr<ProfilerThreadBuffer>& thread : p.threads)
+        {
+            const uint64_t tail = thread->tail.load(std::memory_order_relaxed);
+            const uint64_t head = thread->head.load(std::memory_order_acquire);
+            if(p.capturing)
+            {
+                for(uint64_t i = tail; i < head; i++)
+                {
+                    p.captured.push_back({thread->id, thread->events[i % PROFILER_RING_CAPACITY]});
+                }
+            }
+            thread->tail.store(head, std::memory_order_release);
+        }
+    }
+
+    void profilerWriteTrace(Profiler& p)
+    {
+        std::ofstream file(p.capturePath);
+        if(!file.is_open())
+        {
+            std::cerr << "[Profiler] Couldn't write trace " << p.capturePath << std::endl;
+            return;
+        }
+
+        /* complete events ("X") in microseconds, nested scopes are stacked by their times */
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << PROFILER_GPU_THREAD
+             << ", \"args\": {\"name\": \"GPU\"}}";
+        uint64_t dropped = p.gpuDropped;
+        {
+            std::lock_guard<std::mutex> lock(p.mutex);
+            for(const std::unique_ptr<ProfilerThreadBuffer>& thread : p.threads)
+            {
+                file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << thread->id
+                     << ", \"args\": {\"name\": \"" << thread->name << "\"}}";
+                dropped += thread->dropped.exchange(0);
+            }
+        }
+        for(const ProfilerCapturedEvent& captured : p.captured)
+        {
+            file << ",\n{\"name\": \"" << captured.event.name << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << captured.thread
+                 << ", \"ts\": " << double(captured.event.start) * 1e-3
+                 << ", \"dur\": " << double(captured.event.end - captured.event.start) * 1e-3 << "}";
+        }
+        file << "\n]}\n";
+
+        std::cout << "[Profiler] " << p.captured.size() << " events of " << p.capturedFrames << " frames written to "
+                  << p.capturePath;
+        if(dropped > 0)
+        {
+            std::cout << ", " << dropped << " dropped";
+        }
+        std::cout << std::endl;
+    }
+}
+
+ProfilerScope::ProfilerScope(const char* name) : _name(name), _start(detail::profilerNow())
+{
+}
+
+ProfilerScope::~ProfilerScope()
+{
+    ProfilerThreadBuffer& thread = detail::profilerThread();
+    const uint64_t head = thread.head.load(std::memory_order_relaxed);
+    if(head - thread.tail.load(std::memory_order_acquire) >= PROFILER_RING_CAPACITY)
+    {
+        thread.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    thread.events[head % PROFILER_RING_CAPACITY] = {_name, _start, detail::profilerNow()};
+    thread.head.store(head + 1, std::memory_order_release);
+}
+
+ProfilerGpuScope::ProfilerGpuScope(const char* name) : _index(-1)
+{
+    /* timestamps cost a query and a clock read per scope, outside of captures nobody reads them */
+    detail::Profiler& p = detail::profiler();
+    if(!p.capturing)
+    {
+        return;
+    }
+    if(!p.queriesCreated)
+    {
+        glGenQueries(GLsizei(PROFILER_GPU_FRAMES * 2 * PROFILER_GPU_SCOPES), &p.queries[0][0]);
+        p.queriesCreated = true;
+    }
+
+    const unsigned int slot = p.frame % PROFILER_GPU_FRAMES;
+    if(p.gpuCount[slot] >= PROFILER_GPU_SCOPES)
+    {
+        p.gpuDropped++;
+        return;
+    }
+    if(p.gpuCount[slot] == 0)
+    {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        p.gpuOffset[slot] = int64_t(detail::profilerNow()) - int64_t(gpuNow);
+    }
+
+    _index = int(p.gpuCount[slot]++);
+    p.gpuNames[slot][_index] = name;
+    glQueryCounter(p.queries[slot][2 * _index], GL_TIMESTAMP);
+}
+
+ProfilerGpuScope::~ProfilerGpuScope()
+{
+    if(_index >= 0)
+    {
+        detail::Profiler& p = detail::profiler();
+        glQueryCounter(p.queries[p.frame % PROFILER_GPU_FRAMES][2 * _index + 1], GL_TIMESTAMP);
+    }
+}
+
+void profilerThreadName(const std::string& name)
+{
+    ProfilerThreadBuffer& thread = detail::profilerThread();
+    std::lock_guard<std::mutex> lock(detail::profiler().mutex);
+    thread.name = name;
+}
+
+void profilerFrameEnd()
+{
+    detail::Profiler& p = detail::profiler();
+    detail::profilerCollect(p);
+
+    /* the slot of the next frame holds the oldest frame in flight, its results are dropped if they are still missing */
+    p.frame++;
+    const unsigned int slot = p.frame % PROFILER_GPU_FRAMES;
+    if(!detail::profilerReadGpu(p, slot, false))
+    {
+        p.gpuDropped += p.gpuCount[slot];
+    }
+    p.gpuCount[slot] = 0;
+
+    if(p.capturing && ++p.capturedFrames >= p.captureFrames)
+    {
+        /* the frames still in flight are waited for once, at the end of the capture */
+        for(unsigned int i = 1; i < PROFILER_GPU_FRAMES; i++)
+        {
+            const unsigned int pending = (p.frame + i) % PROFILER_GPU_FRAMES;
+            detail::profilerReadGpu(p, pending, true);
+            p.gpuCount[pending] = 0;
+        }
+        detail::profilerWriteTrace(p);
+        p.capturing = false;
+        p.captured.clear();
+        p.captured.shrink_to_fit();
+    }
+}
+
+void profilerCapture(unsigned int frames, const std::string& path)
+{
+    detail::Profiler& p = detail::profiler();
+    if(p.capturing || frames == 0)
+    {
+        return;
+    }
+    p.capturing = true;
+    p.captureFrames = frames;
+    p.capturedFrames = 0;
+    p.capturePath = path;
+    p.gpuDropped = 0;
+    p.captured.clear();
+}
+
+bool profilerCapturing()
+{
+    return detail::profiler().capturing;
+}
+
+void profilerRelease()
+{
+    detail::Profiler& p = detail::profiler();
+    if(p.queriesCreated)
+    {
+        glDeleteQueries(GLsizei(PROFILER_GPU_FRAMES * 2 * PROFILER_GPU_SCOPES), &p.queries[0][0]);
+        p.queriesCreated = false;
+    }
+    for(unsigned int& count : p.gpuCount)
+    {
+        count = 0;
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "base.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Frame profiler. PROFILE_SCOPE(name) times the rest of the enclosing block on the CPU, PROFILE_GPU_SCOPE(name) the GL
+ * commands issued in it. Both compile to nothing without MYGL_PROFILE (CMake option ENABLE_PROFILER, off by default).
+ * GPU scopes only issue queries while a capture runs. Single jobs are only timed with MYGL_PROFILE_JOBS (CMake option
+ * ENABLE_PROFILER_JOBS). Names have to be string literals, only the pointer is stored.
+ */
+#ifdef MYGL_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfilerScope PROFILE_CONCAT(profilerScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) ProfilerGpuScope PROFILE_CONCAT(profilerGpuScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void) 0)
+#define PROFILE_GPU_SCOPE(name) ((void) 0)
+#endif
+
+/* events each thread can record between two profilerFrameEnd() calls, more are dropped */
+constexpr std::size_t PROFILER_RING_CAPACITY = 1 << 14;
+
+/* GPU scopes per frame and frames of timestamp queries in flight, results are read PROFILER_GPU_FRAMES - 1 frames later */
+constexpr unsigned int PROFILER_GPU_SCOPES = 64;
+constexpr unsigned int PROFILER_GPU_FRAMES = 4;
+
+/* one timed scope, nanoseconds on the profiler clock */
+struct ProfilerEvent
+{
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+/**
+ * Events of one thread. Single producer (the thread) and single consumer (profilerFrameEnd() on the render thread), so
+ * recording never takes a lock.
+ */
+struct ProfilerThreadBuffer
+{
+    uint32_t id = 0;
+    std::string name;
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+    ProfilerEvent events[PROFILER_RING_CAPACITY];
+};
+
+/* times the enclosing scope on the calling thread, use PROFILE_SCOPE */
+struct ProfilerScope
+{
+    explicit ProfilerScope(const char* name);
+    ~ProfilerScope();
+
+    const char* _name;
+    uint64_t _start;
+};
+
+/* brackets the enclosing scope with GL_TIMESTAMP queries during captures, use PROFILE_GPU_SCOPE on the GL thread */
+struct ProfilerGpuScope
+{
+    explicit ProfilerGpuScope(const char* name);
+    ~ProfilerGpuScope();
+
+    int _index;
+};
+
+/**
+ * @brief Name the calling thread in traces, threads are called "thread N" otherwise.
+ *
+ * @param name Thread name.
+ */
+void profilerThreadName(const std::string& name);
+
+/**
+ * @brief Close a frame: collects the events of all threads and reads the GPU timestamps of an older frame (never waits
+ * for the GPU). Call once per frame on the render thread after the last draw.
+ */
+void profilerFrameEnd();
+
+/**
+ * @brief Record the next frames and write them as Chrome trace (chrome://tracing, ui.perfetto.dev) once they are done.
+ *
+ * @param frames Number of frames to record.
+ * @param path Path of the trace file.
+ *
+ * usage:
+ *
+ *   // on a key press, or right away with a frame count from the command line
+ *   profilerCapture(120, "trace.json");
+ *   ...
+ *   // every frame
+ *   {
+ *       PROFILE_SCOPE("sceneDraw");
+ *       PROFILE_GPU_SCOPE("sceneDraw");
+ *       ...
+ *   }
+ *   profilerFrameEnd();
+ *
+ */
+void profilerCapture(unsigned int frames, const std::string& path);
+
+/**
+ * @brief Check if a capture is running.
+ */
+bool profilerCapturing();
+
+/**
+ * @brief Release the GL queries, the context has to be current.
+ */
+void profilerRelease();
@@ -0,0 +1,188 @@
+#include "renderqueue.h"
+#include "glstate.h"
+#include "profiler.h"
+#include "transform.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace detail
+{
+    void renderQueueError(const std::string& message)
+    {
+        std::cerr << "[RenderQueue] " << message << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[RenderQueue] " + message);
+    }
+
+    uint16_t vaoSlot(RenderQueue& queue, GLuint vao)
+    {
+        auto it = queue._vaos.find(vao);
+        if(it != queue._vaos.end())
+        {
+            return it->second;
+        }
+        if(queue._vaos.size() >= (1u << RENDERQUEUE_VAO_BITS))
+        {
+            renderQueueError("Too many vertex array objects");
+        }
+        uint16_t slot = uint16_t(queue._vaos.size());
+        queue._vaos.emplace(vao, slot);
+        return slot;
+    }
+
+    const RenderQueueProgram& programSlot(RenderQueue& queue, const ShaderProgram& program)
+    {
+        auto it = queue._programs.find(program.id);
+        if(it != queue._programs.end())
+        {
+            return it->second;
+        }
+        if(queue._programs.size() >= (1u << RENDERQUEUE_PROGRAM_BITS))
+        {
+            renderQueueError("Too many shader programs");
+        }
+
+        RenderQueueProgram entry;
+        entry.slot = uint16_t(queue._programs.size());
+        entry.mvp = shaderUniformHandle<Matrix4D>(program, "uMVP", false);
+        entry.model = shaderUniformHandle<Matrix4D>(program, "uModel", false);
+        return queue._programs.emplace(program.id, entry).first->second;
+    }
+}
+
+void renderQueueBegin(RenderQueue& queue, const Camera& camera)
+{
+    queue.items.clear();
+    queue.keys.clear();
+    queue.stats = RenderQueueStats();
+    queue.camera = camera;
+    queue._forward = normalize(camera.lookAt - camera.position);
+    queue._sorted = true;
+}
+
+void renderQueueSubmit(RenderQueue& queue, const ShaderProgram& program, const Mesh& mesh, const Matrix4D& model, uint16_t material)
+{
+    uint64_t programBits = detail::programSlot(queue, program).slot;
+    uint64_t vaoBits = detail::vaoSlot(queue, mesh.vao);
+
+    /* view depth of the bounding sphere center, normalized to the far plane */
+    Vector3D center = Vector3D(model * Vector4D(mesh.bounds.sphere.center, 1.0f));
+    float depth = std::clamp(dot(center - queue.camera.position, queue._forward) / queue.camera.farPlane, 0.0f, 1.0f);
+    uint64_t depthBits = uint64_t(depth * float((1u << RENDERQUEUE_DEPTH_BITS) - 1));
+
+    uint64_t key = programBits << (RENDERQUEUE_VAO_BITS + RENDERQUEUE_MATERIAL_BITS + RENDERQUEUE_DEPTH_BITS)
+                 | vaoBits << (RENDERQUEUE_MATERIAL_BITS + RENDERQUEUE_DEPTH_BITS)
+                 | uint64_t(material) << RENDERQUEUE_DEPTH_BITS
+                 | depthBits;
+
+    queue.items.push_back({program.id, mesh.vao, GLsizei(mesh.size_ibo), mesh.firstIndex, GLint(mesh.baseVertex), model});
+    queue.keys.push_back(key);
+    queue.stats.items++;
+    queue._sorted = false;
+}
+
+void renderQueueSort(RenderQueue& queue)
+{
+    const std::size_t count = queue.keys.size();
+
+    /* keys and item indices are moved together so every pass reads and writes one array */
+    std::vector<RenderQueueSortEntry>& entries = queue._sortEntries;
+    std::vector<RenderQueueSortEntry>& temp = queue._sortTemp;
+    entries.resize(count);
+    temp.resize(count);
+
+    /* histograms of all 8 key bytes in a single read pass */
+    uint32_t histograms[8][256] = {};
+    uint64_t differing = 0;
+    for(std::size_t i = 0; i < count; i++)
+    {
+        uint64_t key = queue.keys[i];
+        entries[i] = {key, uint32_t(i)};
+        differing |= key ^ queue.keys[0];
+        for(unsigned int b = 0; b < 8; b++)
+        {
+            histograms[b][(key >> (8 * b)) & 0xFF]++;
+        }
+    }
+
+    for(unsigned int b = 0; b < 8; b++)
+    {
+        /* bytes that are equal for all keys would not change the order */
+        if(((differing >> (8 * b)) & 0xFF) == 0)
+        {
+            continue;
+        }
+
+        uint32_t offsets[256];
+        uint32_t sum = 0;
+        for(unsigned int d = 0; d < 256; d++)
+        {
+            offsets[d] = sum;
+            sum += histograms[b][d];
+        }
+        for(const RenderQueueSortEntry& entry : entries)
+        {
+            temp[offsets[(entry.key >> (8 * b)) & 0xFF]++] = entry;
+        }
+        entries.swap(temp);
+    }
+
+    queue.order.resize(count);
+    for(std::size_t i = 0; i < count; i++)
+    {
+        queue.order[i] = entries[i].item;
+    }
+    queue._sorted = true;
+}
+
+void renderQueueFlush(RenderQueue& queue)
+{
+    PROFILE_SCOPE("renderQueueFlush");
+    PROFILE_GPU_SCOPE("renderQueueFlush");
+
+    if(!queue._sorted || queue.order.size() != queue.items.size())
+    {
+        renderQueueSort(queue);
+    }
+
+    GLuint currentProgram = 0;
+    GLuint currentVao = 0;
+    const Matrix4D& viewProj = cameraViewProjection(queue.camera);
+    const RenderQueueProgram* program = nullptr;
+
+    for(uint32_t index : queue.order)
+    {
+        const DrawItem& item = queue.items[index];
+
+        if(item.program != currentProgram)
+        {
+            /* every program was registered by renderQueueSubmit(...) */
+            program = &queue._programs.find(item.program)->second;
+            glStateUseProgram(item.program);
+            currentProgram = item.program;
+            queue.stats.programSwitches++;
+        }
+        if(item.vao != currentVao)
+        {
+            glStateBindVertexArray(item.vao);
+            currentVao = item.vao;
+            queue.stats.vaoSwitches++;
+        }
+
+        /* the vertex shader only has to do one matrix-vector product per vertex */
+        if(program->mvp.location >= 0)
+        {
+            shaderUniform(program->mvp, matrixMultiply(viewProj, item.model));
+        }
+        shaderUniform(program->model, item.model);
+        glDrawElementsBaseVertex(GL_TRIANGLES, item.count, GL_UNSIGNED_INT, (void*) (std::size_t(item.firstIndex) * sizeof(unsigned int)), item.baseVertex);
+        queue.stats.draws++;
+    }
+}
+
+void renderQueueRelease(RenderQueue& queue)
+{
+    queue = RenderQueue();
+}
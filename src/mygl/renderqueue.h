@@ -0,0 +1,124 @@
+#pragma once
+
+#include "mesh.h"
+#include "shader.h"
+#include "camera.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Layout of the 64 bit sort key, from most to least significant bits: program (12), VAO (12), material (16) and view
+ * depth (24). Sorting by the key groups draws by program, then by VAO and material, and draws them front to back inside
+ * each group. Program and VAO names are mapped to small slots in submission order.
+ */
+constexpr unsigned int RENDERQUEUE_PROGRAM_BITS = 12;
+constexpr unsigned int RENDERQUEUE_VAO_BITS = 12;
+constexpr unsigned int RENDERQUEUE_MATERIAL_BITS = 16;
+constexpr unsigned int RENDERQUEUE_DEPTH_BITS = 24;
+
+struct DrawItem
+{
+    GLuint program;
+    GLuint vao;
+    GLsizei count;
+    unsigned int firstIndex;
+    GLint baseVertex;
+    Matrix4D model;
+};
+
+/* per frame counters, reset by renderQueueBegin(...) */
+struct RenderQueueStats
+{
+    unsigned int items = 0;
+    unsigned int draws = 0;
+    unsigned int programSwitches = 0;
+    unsigned int vaoSwitches = 0;
+};
+
+/* uniforms of a program used by the queue */
+struct RenderQueueProgram
+{
+    uint16_t slot;
+    ShaderUniform<Matrix4D> mvp;
+    ShaderUniform<Matrix4D> model;
+};
+
+struct RenderQueueSortEntry
+{
+    uint64_t key;
+    uint32_t item;
+};
+
+/**
+ * Draw items of one frame with their sort keys. order holds the item indices in key order after sorting. Uniform
+ * handles are cached per program name, so the queue has to be released when programs are deleted and recreated.
+ */
+struct RenderQueue
+{
+    std::vector<DrawItem> items;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order;
+    RenderQueueStats stats;
+
+    Camera camera;
+    Vector3D _forward;
+    std::vector<RenderQueueSortEntry> _sortEntries;
+    std::vector<RenderQueueSortEntry> _sortTemp;
+    std::unordered_map<GLuint, RenderQueueProgram> _programs;
+    std::unordered_map<GLuint, uint16_t> _vaos;
+    bool _sorted = false;
+};
+
+/**
+ * @brief Start a new frame. Removes all draw items of the last frame (keeping the memory) and resets the counters.
+ *
+ * @param queue Render queue.
+ * @param camera Camera used for the depth part of the keys.
+ */
+void renderQueueBegin(RenderQueue& queue, const Camera& camera);
+
+/**
+ * @brief Add a draw of a mesh. The queue sets the uniforms uMVP (projection * view * model of the queue camera) and
+ * uModel if the program has them, other camera data comes from the "Camera" uniform block (see CameraBlock), which has
+ * to be written before the flush.
+ *
+ * @param queue Render queue.
+ * @param program Shader program to draw the mesh with, has to be ready (see shaderSelect(...)).
+ * @param mesh Mesh to draw.
+ * @param model Model matrix of the mesh.
+ * @param material Material id, draws with the same program and VAO are grouped by it.
+ */
+void renderQueueSubmit(RenderQueue& queue, const ShaderProgram& program, const Mesh& mesh, const Matrix4D& model, uint16_t material = 0);
+
+/**
+ * @brief Sort the submitted draw items by their keys (LSD radix sort, 8 bits per pass). Passes over bytes that are
+ * equal for all keys are skipped. Called by renderQueueFlush(...) if necessary.
+ *
+ * @param queue Render queue.
+ */
+void renderQueueSort(RenderQueue& queue);
+
+/**
+ * @brief Issue all draw items in key order. glUseProgram and glBindVertexArray are only called when the program or
+ * VAO actually changes. Program and VAO stay bound afterwards.
+ *
+ * @param queue Render queue.
+ *
+ * usage:
+ *
+ *   renderQueueBegin(queue, cam);
+ *   renderQueueSubmit(queue, myShader, myMesh, model);
+ *   renderQueueFlush(queue);
+ *   // queue.stats.draws, queue.stats.programSwitches, ...
+ *
+ */
+void renderQueueFlush(RenderQueue& queue);
+
+/**
+ * @brief Free all memory of the queue and forget the cached programs and VAOs.
+ *
+ * @param queue Render queue.
+ */
+void renderQueueRelease(RenderQueue& queue);
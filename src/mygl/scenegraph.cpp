@@ -0,0 +1,81 @@
+#include "scenegraph.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+SceneNode sceneGraphAdd(SceneGraph& graph, const Matrix4D& local, SceneNode parent)
+{
+    const SceneNode node = SceneNode(graph.local.size());
+    if(parent != SCENEGRAPH_NO_PARENT && parent >= node)
+    {
+        std::cerr << "[SceneGraph] Parent node " << parent << " does not exist" << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[SceneGraph] Parent node does not exist");
+    }
+
+    graph.local.push_back(local);
+    graph.world.push_back(local);
+    graph.parent.push_back(parent);
+    graph.dirty.push_back(1);
+    graph.changed.push_back(0);
+    graph._anyDirty = true;
+    return node;
+}
+
+void sceneGraphSetLocal(SceneGraph& graph, SceneNode node, const Matrix4D& local)
+{
+    graph.local[node] = local;
+    graph.dirty[node] = 1;
+    graph._anyDirty = true;
+}
+
+void sceneGraphUpdate(SceneGraph& graph)
+{
+    PROFILE_SCOPE("sceneGraphUpdate");
+
+    const std::size_t count = graph.local.size();
+    graph.stats.nodes = unsigned(count);
+    graph.stats.recomputed = 0;
+
+    if(!graph._anyDirty)
+    {
+        /* nothing changed, only forget the changes of the last update */
+        if(graph._anyChanged)
+        {
+            std::fill(graph.changed.begin(), graph.changed.end(), 0);
+            graph._anyChanged = false;
+        }
+        return;
+    }
+
+    /* parents come first, so their changed flag is final when their children are visited */
+    for(std::size_t i = 0; i < count; i++)
+    {
+        const SceneNode parent = graph.parent[i];
+        const bool parentChanged = parent != SCENEGRAPH_NO_PARENT && graph.changed[parent];
+        graph.changed[i] = graph.dirty[i] || parentChanged;
+        graph.dirty[i] = 0;
+
+        if(graph.changed[i])
+        {
+            graph.world[i] = parent == SCENEGRAPH_NO_PARENT ? graph.local[i] : graph.world[parent] * graph.local[i];
+            graph.stats.recomputed++;
+        }
+    }
+    graph._anyDirty = false;
+    graph._anyChanged = graph.stats.recomputed > 0;
+}
+
+void sceneGraphClear(SceneGraph& graph)
+{
+    graph.local.clear();
+    graph.world.clear();
+    graph.parent.clear();
+    graph.dirty.clear();
+    graph.changed.clear();
+    graph.stats = SceneGraphStats();
+    graph._anyDirty = false;
+    graph._anyChanged = false;
+}
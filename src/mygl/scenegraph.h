@@ -0,0 +1,79 @@
+#pragma once
+
+#include "base.h"
+
+#include <cstdint>
+#include <vector>
+
+/* index of a node in a scene graph */
+using SceneNode = uint32_t;
+constexpr SceneNode SCENEGRAPH_NO_PARENT = ~0u;
+
+/* counters of the last sceneGraphUpdate(...) */
+struct SceneGraphStats
+{
+    unsigned int nodes = 0;
+    unsigned int recomputed = 0;
+};
+
+/**
+ * Transform hierarchy stored as parallel arrays. Nodes can only be added below existing nodes, so the arrays are always
+ * in topological order (parents before children) and the world matrices are updated by a single linear sweep.
+ */
+struct SceneGraph
+{
+    std::vector<Matrix4D> local;
+    std::vector<Matrix4D> world;
+    std::vector<SceneNode> parent;
+
+    /* local matrix changed since the last update / world matrix recomputed by the last update */
+    std::vector<uint8_t> dirty;
+    std::vector<uint8_t> changed;
+
+    SceneGraphStats stats;
+    bool _anyDirty = false;
+    bool _anyChanged = false;
+};
+
+/**
+ * @brief Add a node to the graph. Its world matrix is computed by the next sceneGraphUpdate(...).
+ *
+ * @param graph Scene graph.
+ * @param local Transformation relative to the parent.
+ * @param parent Parent node, SCENEGRAPH_NO_PARENT for a root node.
+ *
+ * @return The new node.
+ */
+SceneNode sceneGraphAdd(SceneGraph& graph, const Matrix4D& local, SceneNode parent = SCENEGRAPH_NO_PARENT);
+
+/**
+ * @brief Replace the local matrix of a node and mark it dirty.
+ *
+ * @param graph Scene graph.
+ * @param node Node to change.
+ * @param local New transformation relative to the parent.
+ */
+void sceneGraphSetLocal(SceneGraph& graph, SceneNode node, const Matrix4D& local);
+
+/**
+ * @brief Recompute the world matrices of all dirty nodes and their descendants, all other world matrices are kept.
+ * Afterwards graph.changed flags the nodes whose world matrix was recomputed and graph.stats holds the counts.
+ *
+ * @param graph Scene graph.
+ *
+ * usage:
+ *
+ *   SceneNode root = sceneGraphAdd(graph, Matrix4D::translation({0.0f, 4.0f, 0.0f}));
+ *   SceneNode child = sceneGraphAdd(graph, Matrix4D::scale(2.0f, 2.0f, 2.0f), root);
+ *   sceneGraphUpdate(graph);
+ *   // graph.world[child] == translation * scale
+ *
+ */
+void sceneGraphUpdate(SceneGraph& graph);
+
+/**
+ * @brief Remove all nodes, keeping the memory.
+ *
+ * @param graph Scene graph.
+ */
+void sceneGraphClear(SceneGraph& graph);
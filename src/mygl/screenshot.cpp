@@ -0,0 +1,247 @@
+#include "screenshot.h"
+
+#include "glstate.h"
+#include "simd.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <stb_image/stb_image_write.h>
+
+namespace detail
+{
+    /* runs on an encoder thread: rows are flipped while copied out of the mapped buffer, stb's flip flag is never used */
+    void screenshotEncode(ScreenshotQueue* queue, ScreenshotSlot* slot, const uint8_t* mapped)
+    {
+        const std::size_t rowBytes = std::size_t(slot->width) * 4;
+        const unsigned int width = slot->width;
+        const unsigned int height = slot->height;
+        const std::string path = slot->path;
+
+        std::vector<uint8_t> pixels(rowBytes * height);
+        screenshotFlipRows(mapped, pixels.data(), rowBytes, height);
+        slot->copied.store(true, std::memory_order_release);
+
+        if(stbi_write_png(path.c_str(), int(width), int(height), 4, pixels.data(), int(rowBytes)) != 0)
+        {
+            queue->written.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            std::cerr << "[Screenshot] Couldn't write " << path << std::endl;
+            queue->failed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+ScreenshotQueue* screenshotQueueCreate(unsigned int encoderThreads)
+{
+    ScreenshotQueue* queue = new ScreenshotQueue;
+    queue->encoders = threadPoolCreate(encoderThreads == 0 ? 1 : encoderThreads);
+    return queue;
+}
+
+bool screenshotRequest(ScreenshotQueue* queue, const std::string& path)
+{
+    ScreenshotSlot* slot = nullptr;
+    for(ScreenshotSlot& candidate : queue->slots)
+    {
+        if(screenshotSlotFree(candidate))
+        {
+            slot = &candidate;
+            break;
+        }
+    }
+    if(!slot)
+    {
+        queue->skipped++;
+        return false;
+    }
+
+    screenshotSlotRead(*slot, path);
+    return true;
+}
+
+void screenshotUpdate(ScreenshotQueue* queue)
+{
+    for(ScreenshotSlot& slot : queue->slots)
+    {
+        if(slot.mapped && slot.copied.load(std::memory_order_acquire))
+        {
+            screenshotSlotUnmap(slot);
+        }
+        if(slot.fence == nullptr)
+        {
+            continue;
+        }
+
+        const uint8_t* mapped = screenshotSlotMap(slot);
+        if(!mapped)
+        {
+            if(slot.fence == nullptr)
+            {
+                queue->failed.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        ScreenshotSlot* target = &slot;
+        threadPoolSubmit(queue->encoders, [queue, target, mapped]()
+        {
+            detail::screenshotEncode(queue, target, mapped);
+        });
+    }
+}
+
+bool screenshotPending(ScreenshotQueue* queue)
+{
+    for(const ScreenshotSlot& slot : queue->slots)
+    {
+        if(!screenshotSlotFree(slot))
+        {
+            return true;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(queue->encoders->mutex);
+    return !queue->encoders->tasks.empty() || queue->encoders->running > 0;
+}
+
+void screenshotQueueDelete(ScreenshotQueue* queue)
+{
+    /* readbacks still in flight are written too, this is the only place that waits */
+    for(ScreenshotSlot& slot : queue->slots)
+    {
+        if(slot.fence)
+        {
+            glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        }
+    }
+    screenshotUpdate(queue);
+    threadPoolWait(queue->encoders);
+    screenshotUpdate(queue);
+
+    for(ScreenshotSlot& slot : queue->slots)
+    {
+        screenshotSlotDelete(slot);
+    }
+    threadPoolDelete(queue->encoders);
+    delete queue;
+}
+
+void screenshotFlipRows(const uint8_t* source, uint8_t* target, std::size_t rowBytes, unsigned int rows)
+{
+    for(unsigned int row = 0; row < rows; row++)
+    {
+        const uint8_t* from = source + std::size_t(rows - 1 - row) * rowBytes;
+        uint8_t* to = target + std::size_t(row) * rowBytes;
+        std::size_t i = 0;
+#ifdef MYGL_SSE
+        /* 64 bytes per iteration, the source is often uncached mapped memory so every load should be a full vector */
+        for(; i + 64 <= rowBytes; i += 64)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i + 16));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i + 32));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i + 48));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i), a);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i + 16), b);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i + 32), c);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i + 48), d);
+        }
+#endif
+        std::memcpy(to + i, from + i, rowBytes - i);
+    }
+}
+
+bool screenshotSlotFree(const ScreenshotSlot& slot)
+{
+    return slot.fence == nullptr && !slot.mapped;
+}
+
+void screenshotSlotRead(ScreenshotSlot& slot, const std::string& path)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    slot.width = unsigned(viewport[2]);
+    slot.height = unsigned(viewport[3]);
+    slot.path = path;
+    const std::size_t size = std::size_t(slot.width) * slot.height * 4;
+
+    if(slot.pbo == 0)
+    {
+        glGenBuffers(1, &slot.pbo);
+    }
+    glStateBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if(size > slot.capacity)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(size), nullptr, GL_STREAM_READ);
+        slot.capacity = size;
+    }
+
+    /* the default framebuffer is read from the back buffer, framebuffer objects from their first color attachment */
+    GLint readFramebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+    if(readFramebuffer == 0)
+    {
+        glReadBuffer(GL_BACK);
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(viewport[0], viewport[1], GLsizei(slot.width), GLsizei(slot.height), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glStateBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+const uint8_t* screenshotSlotMap(ScreenshotSlot& slot, GLuint64 timeout)
+{
+    /* the flush bit only makes sure the fence gets to the GPU at all */
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if(status == GL_TIMEOUT_EXPIRED)
+    {
+        return nullptr;
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    if(status == GL_WAIT_FAILED)
+    {
+        return nullptr;
+    }
+
+    glStateBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(std::size_t(slot.width) * slot.height * 4), GL_MAP_READ_BIT);
+    glStateBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if(!mapped)
+    {
+        std::cerr << "[Screenshot] Couldn't map the readback of " << slot.path << std::endl;
+        return nullptr;
+    }
+
+    slot.mapped = true;
+    slot.copied.store(false, std::memory_order_relaxed);
+    return static_cast<const uint8_t*>(mapped);
+}
+
+void screenshotSlotUnmap(ScreenshotSlot& slot)
+{
+    glStateBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glStateBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.mapped = false;
+}
+
+void screenshotSlotDelete(ScreenshotSlot& slot)
+{
+    if(slot.fence)
+    {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+    if(slot.pbo != 0)
+    {
+        glStateDeleteBuffer(slot.pbo);
+        slot.pbo = 0;
+        slot.capacity = 0;
+    }
+}
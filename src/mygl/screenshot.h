@@ -0,0 +1,152 @@
+#pragma once
+
+#include "base.h"
+#include "threadpool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* readbacks in flight, a request while all of them are busy is skipped */
+constexpr unsigned int SCREENSHOT_SLOTS = 3;
+
+/* one readback: pixel buffer the frame is copied to on the GPU and the fence telling when the copy is done */
+struct ScreenshotSlot
+{
+    GLuint pbo = 0;
+    std::size_t capacity = 0;
+    GLsync fence = nullptr;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    std::string path;
+
+    /* the buffer is mapped while an encoder thread copies the rows out, it is unmapped once copied is set */
+    bool mapped = false;
+    std::atomic<bool> copied{false};
+};
+
+/**
+ * Asynchronous screenshots. A request only queues a glReadPixels into a pixel buffer object and a fence, the render
+ * thread never waits for the GPU. Once the fence has passed (usually a frame or two later) the buffer is mapped and
+ * handed to an encoder thread, which copies the rows out bottom-up and writes the PNG. The render thread only maps and
+ * unmaps.
+ */
+struct ScreenshotQueue
+{
+    ScreenshotSlot slots[SCREENSHOT_SLOTS];
+    ThreadPool* encoders = nullptr;
+
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> failed{0};
+    uint64_t skipped = 0;
+};
+
+/**
+ * @brief Create a screenshot queue and its encoder threads.
+ *
+ * @param encoderThreads Number of encoder threads.
+ *
+ * @return Screenshot queue, has to be deleted with screenshotQueueDelete(...).
+ *
+ * usage:
+ *
+ *   ScreenshotQueue* screenshots = screenshotQueueCreate();
+ *   ...
+ *   // every frame
+ *   sceneDraw();
+ *   if(requested)
+ *   {
+ *       screenshotRequest(screenshots, "screenshot.png");
+ *   }
+ *   glfwSwapBuffers(window);
+ *   screenshotUpdate(screenshots);
+ *   ...
+ *   screenshotQueueDelete(screenshots);
+ *
+ */
+ScreenshotQueue* screenshotQueueCreate(unsigned int encoderThreads = 1);
+
+/**
+ * @brief Queue a readback of the current viewport of the bound read framebuffer (the back buffer for the window, so
+ * call it after the last draw and before the swap). Does not wait for the GPU.
+ *
+ * @param queue Screenshot queue.
+ * @param path Path of the PNG.
+ *
+ * @return False if all slots are busy and the screenshot was skipped.
+ */
+bool screenshotRequest(ScreenshotQueue* queue, const std::string& path);
+
+/**
+ * @brief Hand finished readbacks to the encoder threads and release the buffers they are done with. Never waits, call
+ * once per frame on the render thread.
+ *
+ * @param queue Screenshot queue.
+ */
+void screenshotUpdate(ScreenshotQueue* queue);
+
+/**
+ * @brief Check if a screenshot is still being read back or encoded.
+ *
+ * @param queue Screenshot queue.
+ */
+bool screenshotPending(ScreenshotQueue* queue);
+
+/**
+ * @brief Wait for all screenshots to be written, delete the buffers and stop the encoder threads. The context has to
+ * be current.
+ *
+ * @param queue Screenshot queue to delete.
+ */
+void screenshotQueueDelete(ScreenshotQueue* queue);
+
+/**
+ * @brief Copy an image in reverse row order (OpenGL's bottom-up rows to top-down), with SSE where available.
+ *
+ * @param source First row of the source image.
+ * @param target First row of the target image, must not overlap the source.
+ * @param rowBytes Bytes per row of both images.
+ * @param rows Number of rows.
+ */
+void screenshotFlipRows(const uint8_t* source, uint8_t* target, std::size_t rowBytes, unsigned int rows);
+
+/*
+ * Single readbacks, used by the queue above and by frame capture (capture.h). All of them have to be called on the
+ * render thread.
+ */
+
+/**
+ * @brief Check if a slot can take a new readback (no fence pending, not mapped).
+ */
+bool screenshotSlotFree(const ScreenshotSlot& slot);
+
+/**
+ * @brief Read the current viewport of the bound read framebuffer into the slot's pixel buffer and set its fence. The
+ * slot has to be free.
+ *
+ * @param slot Free slot.
+ * @param path Path stored with the readback.
+ */
+void screenshotSlotRead(ScreenshotSlot& slot, const std::string& path);
+
+/**
+ * @brief Map the pixel buffer once the readback has finished.
+ *
+ * @param slot Slot with a pending readback.
+ * @param timeout Nanoseconds to wait for the fence, 0 only polls.
+ *
+ * @return Bottom-up RGBA rows, valid until screenshotSlotUnmap(...). nullptr if the readback isn't done yet (the fence is
+ * kept) or failed (the fence is gone and the slot is free again).
+ */
+const uint8_t* screenshotSlotMap(ScreenshotSlot& slot, GLuint64 timeout = 0);
+
+/**
+ * @brief Unmap a mapped slot, which makes it free again.
+ */
+void screenshotSlotUnmap(ScreenshotSlot& slot);
+
+/**
+ * @brief Delete fence and pixel buffer of a slot that is not mapped.
+ */
+void screenshotSlotDelete(ScreenshotSlot& slot);
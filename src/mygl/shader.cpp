@@ -1,18 +1,24 @@
 #include "shader.h"
+#include "shadercache.h"
+#include "shadervariant.h"
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <stdexcept>
 
 namespace detail
 {
+    /* only submits, the status is queried by compileCheck(...) once the program is needed */
     void compile(GLuint handle, const char* source, const int size)
     {
-        GLint compileResult = 0;
-
         glShaderSource(handle, 1, &source, &size);
         glCompileShader(handle);
+    }
+
+    void compileCheck(GLuint handle)
+    {
+        GLint compileResult = 0;
         glGetShaderiv(handle, GL_COMPILE_STATUS, &compileResult);
 
         if(compileResult == GL_FALSE)
@@ -31,10 +37,8 @@ namespace detail
         }
     }
 
-    void link(GLuint handle)
+    void linkCheck(GLuint handle)
     {
-        glLinkProgram(handle);
-
         GLint result;
         glGetProgramiv(handle, GL_LINK_STATUS, &result);
 
@@ -57,88 +61,291 @@ namespace detail
             throw std::runtime_error((std::string("[Shader] ERROR link shaderprogram: \n") + programLog));
         }
     }
+
+    /* KHR_parallel_shader_compile (or the ARB version): lets the driver use all its compiler threads */
+    bool shaderParallelCompile()
+    {
+        static int supported = -1;
+        if(supported < 0)
+        {
+            supported = 0;
+            if(GLAD_GL_KHR_parallel_shader_compile && glMaxShaderCompilerThreadsKHR)
+            {
+                glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+                supported = 1;
+            }
+            else if(GLAD_GL_ARB_parallel_shader_compile && glMaxShaderCompilerThreadsARB)
+            {
+                glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+                supported = 1;
+            }
+        }
+        return supported == 1;
+    }
+
+    /* uniform blocks with a fixed binding point */
+    const struct
+    {
+        const char* name;
+        GLuint binding;
+    } shaderBlockBindings[] = {{"Camera", SHADER_BINDING_CAMERA}};
+
+    void bindUniformBlocks(GLuint handle)
+    {
+        for(const auto& block : shaderBlockBindings)
+        {
+            GLuint index = glGetUniformBlockIndex(handle, block.name);
+            if(index != GL_INVALID_INDEX)
+            {
+                glUniformBlockBinding(handle, index, block.binding);
+            }
+        }
+    }
+
+    /* collects all active uniforms outside of uniform blocks, sorted by name */
+    std::vector<ShaderUniformInfo> reflectUniforms(GLuint handle)
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(handle, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(handle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::vector<ShaderUniformInfo> uniforms;
+        std::string name(std::size_t(std::max(maxLength, 1)), '\0');
+        for(GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(handle, GLuint(i), GLsizei(name.size()), &length, &size, &type, &name[0]);
+
+            /* members of uniform blocks have no location */
+            std::string uniformName = name.substr(0, std::size_t(length));
+            GLint location = glGetUniformLocation(handle, uniformName.c_str());
+            if(location < 0)
+            {
+                continue;
+            }
+
+            /* arrays are reported as "name[0]", the elements of plain arrays have consecutive locations */
+            if(uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            {
+                uniformName.resize(uniformName.size() - 3);
+            }
+            uniforms.push_back({uniformName, location, type, size});
+        }
+
+        std::sort(uniforms.begin(), uniforms.end(), [](const ShaderUniformInfo& a, const ShaderUniformInfo& b) { return a.name < b.name; });
+        return uniforms;
+    }
+
+    void shaderUniformError(const std::string& message)
+    {
+        std::cerr << "[Shader] " << message << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[Shader] " + message);
+    }
+
+    bool shaderIsSampler(GLenum type)
+    {
+        switch(type)
+        {
+            case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_1D_SHADOW: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_CUBE_SHADOW:
+            case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_1D_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW:
+            case GL_SAMPLER_2D_RECT: case GL_SAMPLER_2D_RECT_SHADOW: case GL_SAMPLER_BUFFER:
+            case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+            case GL_INT_SAMPLER_1D: case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE:
+            case GL_INT_SAMPLER_1D_ARRAY: case GL_INT_SAMPLER_2D_ARRAY: case GL_INT_SAMPLER_2D_RECT: case GL_INT_SAMPLER_BUFFER:
+            case GL_INT_SAMPLER_2D_MULTISAMPLE: case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+            case GL_UNSIGNED_INT_SAMPLER_1D: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D: case GL_UNSIGNED_INT_SAMPLER_CUBE:
+            case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+            case GL_UNSIGNED_INT_SAMPLER_BUFFER: case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE: case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    double shaderSeconds()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /* status queries of a submitted program, they block until the driver is done with it */
+    void shaderFinish(ShaderProgram& program)
+    {
+        /* the compile logs say more than the link log of a program with a broken shader */
+        compileCheck(program._vertexID);
+        compileCheck(program._fragmentID);
+        linkCheck(program.id);
+        bindUniformBlocks(program.id);
+        program.uniforms = reflectUniforms(program.id);
+        program.ready = true;
+
+        if(program._cacheStore)
+        {
+            shaderCacheStore(program.id, program._cacheKey);
+            shaderCacheRecord(false, shaderSeconds() - program._submitted);
+            program._cacheStore = false;
+        }
+    }
 }
 
-ShaderProgram shaderCreate(const std::string &vertexSource, const std::string &fragmentSource)
+ShaderProgram shaderSubmit(const std::string &vertexSource, const std::string &fragmentSource)
 {
-    ShaderProgram program{glCreateProgram(), glCreateShader(GL_VERTEX_SHADER), glCreateShader(GL_FRAGMENT_SHADER)};
+    ShaderProgram program;
+    program.id = glCreateProgram();
+    program._submitted = detail::shaderSeconds();
+
+    if(!program.id)
+    {
+        std::cerr << "[Shader] Couldn't create shader program!" << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[Shader] Couldn't create shader program!");
+    }
+
+    /* a cached binary replaces compiling and linking, block bindings are not part of it */
+    const bool cached = shaderCacheEnabled();
+    const uint64_t key = cached ? shaderCacheKey(vertexSource, fragmentSource) : 0;
+    if(cached && shaderCacheLoad(program.id, key))
+    {
+        detail::bindUniformBlocks(program.id);
+        program.uniforms = detail::reflectUniforms(program.id);
+        program.ready = true;
+        detail::shaderCacheRecord(true, detail::shaderSeconds() - program._submitted);
+        return program;
+    }
 
-    if(!program._vertexID || !program._fragmentID || !program.id)
+    program._vertexID = glCreateShader(GL_VERTEX_SHADER);
+    program._fragmentID = glCreateShader(GL_FRAGMENT_SHADER);
+    if(!program._vertexID || !program._fragmentID)
     {
         std::cerr << "[Shader] Couldn't create shader program!" << std::endl;
         std::cerr.flush();
         throw std::runtime_error("[Shader] Couldn't create shader program!");
     }
 
+    /* nothing here queries a status, the driver is free to compile and link in the background */
+    detail::shaderParallelCompile();
     detail::compile(program._vertexID, vertexSource.c_str(), vertexSource.size());
     glAttachShader(program.id, program._vertexID);
 
     detail::compile(program._fragmentID, fragmentSource.c_str(), fragmentSource.size());
     glAttachShader(program.id, program._fragmentID);
 
-    detail::link(program.id);
+    if(cached)
+    {
+        glProgramParameteri(program.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program.id);
 
+    program._cacheStore = cached;
+    program._cacheKey = key;
     return program;
 }
 
-ShaderProgram shaderLoad(const std::string &vertexPath, const std::string &fragmentPath)
+ShaderProgram shaderLoadAsync(const std::string &vertexPath, const std::string &fragmentPath)
 {
-    std::ifstream vertexFile(vertexPath);
-    std::ifstream fragmentFile(fragmentPath);
+    return shaderSubmit(shaderPreprocess(vertexPath), shaderPreprocess(fragmentPath));
+}
 
-    if(!vertexFile.is_open())
+bool shaderPoll(ShaderProgram &program)
+{
+    if(program.ready)
     {
-        std::cerr << "[Shader] Couldn't open vertex shader file at " << std::endl;
-        std::cerr.flush();
-        throw std::runtime_error("[Shader] Couldn't open vertex shader file at " + vertexPath);
+        return true;
     }
 
-    if(!fragmentFile.is_open())
+    /* without the extension there is no way to ask, the status queries in shaderFinish(...) wait for the driver */
+    if(detail::shaderParallelCompile())
     {
-        std::cerr << "[Shader] Couldn't open fragment shader file at " << std::endl;
-        std::cerr.flush();
-        throw std::runtime_error("[Shader] Couldn't open fragment shader file at " + fragmentPath);
+        GLint complete = GL_FALSE;
+        glGetProgramiv(program.id, GL_COMPLETION_STATUS_KHR, &complete);
+        if(complete == GL_FALSE)
+        {
+            return false;
+        }
     }
 
-    std::stringstream vertexSourceBuffer;
-    vertexSourceBuffer << vertexFile.rdbuf();
+    detail::shaderFinish(program);
+    return true;
+}
 
-    std::stringstream fragmentSourceBuffer;
-    fragmentSourceBuffer << fragmentFile.rdbuf();
+void shaderWait(ShaderProgram &program)
+{
+    if(!program.ready)
+    {
+        detail::shaderFinish(program);
+    }
+}
 
-    return shaderCreate(vertexSourceBuffer.str(), fragmentSourceBuffer.str());
+const ShaderProgram& shaderSelect(ShaderProgram &program, const ShaderProgram &fallback)
+{
+    return shaderPoll(program) ? program : fallback;
+}
+
+ShaderProgram shaderCreateFallback()
+{
+    const char* vertexSource = R"(#version 330 core
+layout(location = 0) in vec3 aPosition;
+uniform mat4 uMVP;
+void main(void)
+{
+    gl_Position = uMVP * vec4(aPosition, 1.0);
+})";
+
+    const char* fragmentSource = R"(#version 330 core
+out vec4 FragColor;
+void main(void)
+{
+    FragColor = vec4(0.5, 0.5, 0.5, 1.0);
+})";
+
+    return shaderCreate(vertexSource, fragmentSource);
+}
+
+ShaderProgram shaderCreate(const std::string &vertexSource, const std::string &fragmentSource)
+{
+    ShaderProgram program = shaderSubmit(vertexSource, fragmentSource);
+    shaderWait(program);
+    return program;
+}
+
+ShaderProgram shaderLoad(const std::string &vertexPath, const std::string &fragmentPath)
+{
+    return shaderCreate(shaderPreprocess(vertexPath), shaderPreprocess(fragmentPath));
 }
 
 void shaderDelete(const ShaderProgram &program)
 {
-    glDetachShader(program.id, program._vertexID);
-    glDetachShader(program.id, program._fragmentID);
-    glDeleteShader(program._vertexID);
-    glDeleteShader(program._fragmentID);
+    /* programs loaded from the binary cache have no shader objects */
+    if(program._vertexID)
+    {
+        glDetachShader(program.id, program._vertexID);
+        glDeleteShader(program._vertexID);
+    }
+    if(program._fragmentID)
+    {
+        glDetachShader(program.id, program._fragmentID);
+        glDeleteShader(program._fragmentID);
+    }
 
     glDeleteProgram(program.id);
 }
 
+const ShaderUniformInfo* shaderUniformFind(const ShaderProgram& program, const std::string& name)
+{
+    auto it = std::lower_bound(program.uniforms.begin(), program.uniforms.end(), name,
+                               [](const ShaderUniformInfo& uniform, const std::string& key) { return uniform.name < key; });
+    return it != program.uniforms.end() && it->name == name ? &*it : nullptr;
+}
+
 void shaderUniform(ShaderProgram &shader, const std::string &name, const Matrix4D &value)
 {
-    GLint index = glGetUniformLocation(shader.id, name.c_str());
-    if(index < 0)
-    {
-        std::cerr << "[Shader] Couldn't set value for uniform " << name << std::endl;
-        std::cerr.flush();
-        throw std::runtime_error("[Shader] Couldn't set value for uniform " + name);
-    }
-    glUniformMatrix4fv(index, 1, GL_FALSE, value.ptr());
+    shaderUniform(shaderUniformHandle<Matrix4D>(shader, name), value);
 }
 
 void shaderUniform(ShaderProgram &shader, const std::string &name, int value)
 {
-    GLint index = glGetUniformLocation(shader.id, name.c_str());
-    if(index < 0)
-    {
-        std::cerr << "[Shader] Couldn't set value for uniform " << name << std::endl;
-        std::cerr.flush();
-        throw std::runtime_error("[Shader] Couldn't set value for uniform " + name);
-    }
-    glUniform1i(index, value);
+    shaderUniform(shaderUniformHandle<int>(shader, name), value);
 }
@@ -2,13 +2,78 @@
 
 #include "base.h"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Fixed uniform buffer binding points. GLSL 330 has no binding qualifier, shaderCreate(...) binds the uniform blocks
+ * with these names after linking.
+ */
+constexpr GLuint SHADER_BINDING_CAMERA = 0;     // "Camera", see CameraBlock
+
+/* active uniform of a linked program */
+struct ShaderUniformInfo
+{
+    /* array uniforms are stored without the "[0]" suffix */
+    std::string name;
+    GLint location;
+
+    /* GL_FLOAT_VEC3, GL_FLOAT_MAT4, GL_SAMPLER_2D, ... */
+    GLenum type;
+
+    /* number of array elements, 1 for plain uniforms */
+    GLint size;
+};
+
+/**
+ * Linked shader program. All active uniforms outside of uniform blocks are reflected once after linking, uniforms is
+ * sorted by name. Programs from shaderSubmit(...) are compiled in the background and can't be used before they are ready,
+ * see shaderPoll(...).
+ */
 struct ShaderProgram
 {
     GLuint id = 0;
     GLuint _vertexID = 0;
     GLuint _fragmentID = 0;
+    std::vector<ShaderUniformInfo> uniforms;
+
+    /* linked, blocks bound and uniforms reflected */
+    bool ready = false;
+
+    /* pending programs: binary cache key if the binary is stored once linked, submit time in seconds */
+    bool _cacheStore = false;
+    uint64_t _cacheKey = 0;
+    double _submitted = 0.0;
 };
 
+/**
+ * Pre-resolved uniform of type T. Setting it is a single glUniform* call without any name lookup. A handle with location
+ * -1 belongs to a uniform the program doesn't use, setting it does nothing.
+ */
+template<typename T>
+struct ShaderUniform
+{
+    GLint location = -1;
+
+    /* number of array elements */
+    GLsizei size = 0;
+};
+
+/* column-major float matrix with C columns and R rows for the GLSL matCxR types without a math type */
+template<unsigned int C, unsigned int R>
+struct ShaderMatrix
+{
+    float n[C][R];
+};
+
+/* GLSL ivecN / bvecN and uvecN */
+template<unsigned int N>
+using ShaderIntVector = std::array<int, N>;
+template<unsigned int N>
+using ShaderUintVector = std::array<unsigned int, N>;
+
 /**
  * @brief Function to load vertex and fragment shader from file and compile and link them to create shader program.
  *
@@ -20,7 +85,9 @@ struct ShaderProgram
 ShaderProgram shaderLoad(const std::string& vertexPath, const std::string& fragmentPath);
 
 /**
- * @brief Function to compile and link vertex and fragement source strings to create shader program.
+ * @brief Function to compile and link vertex and fragement source strings to create shader program. If the binary cache
+ * is enabled (see shaderCacheEnable(...)) a cached binary of the same sources is loaded instead, newly linked programs
+ * are added to the cache. Waits for the driver, shaderSubmit(...) doesn't.
  *
  * @param vertexSource Source string holding vertex shader code.
  * @param fragmentSource Source string holding fragment shader code.
@@ -29,6 +96,73 @@ ShaderProgram shaderLoad(const std::string& vertexPath, const std::string& fragm
  */
 ShaderProgram shaderCreate(const std::string& vertexSource, const std::string& fragmentSource);
 
+/**
+ * @brief Submit vertex and fragment source strings for compiling and linking without waiting for the driver. Submit all
+ * programs first and poll them later, with KHR_parallel_shader_compile the driver compiles them on its own threads in the
+ * meantime. Programs found in the binary cache are ready right away.
+ *
+ * @param vertexSource Source string holding vertex shader code.
+ * @param fragmentSource Source string holding fragment shader code.
+ *
+ * @return Shader program, not ready yet.
+ *
+ * usage:
+ *
+ *   ShaderProgram fallback = shaderCreateFallback();
+ *   ShaderProgram program = shaderSubmit(vertexSource, fragmentSource);
+ *   ...
+ *   // every frame, draws with the fallback until the program is linked
+ *   renderQueueSubmit(queue, shaderSelect(program, fallback), mesh, model);
+ *
+ */
+ShaderProgram shaderSubmit(const std::string& vertexSource, const std::string& fragmentSource);
+
+/**
+ * @brief Function to load vertex and fragment shader from file and submit them like shaderSubmit(...).
+ *
+ * @param vertexPath Path to vertex shader file.
+ * @param fragmentPath Path to fragment shader file.
+ *
+ * @return Shader program, not ready yet.
+ */
+ShaderProgram shaderLoadAsync(const std::string& vertexPath, const std::string& fragmentPath);
+
+/**
+ * @brief Check if a submitted program is linked and finish it (bind uniform blocks, reflect uniforms, store its binary).
+ * Never waits with KHR_parallel_shader_compile, without it the first call waits for the driver. Throws with the info log
+ * if compiling or linking failed.
+ *
+ * @param program Shader program.
+ *
+ * @return True if the program is ready.
+ */
+bool shaderPoll(ShaderProgram& program);
+
+/**
+ * @brief Wait until a submitted program is ready.
+ *
+ * @param program Shader program.
+ */
+void shaderWait(ShaderProgram& program);
+
+/**
+ * @brief Pick the program to draw with this frame.
+ *
+ * @param program Submitted shader program, polled.
+ * @param fallback Ready program used while program is compiling.
+ *
+ * @return program if it is ready, fallback otherwise.
+ */
+const ShaderProgram& shaderSelect(ShaderProgram& program, const ShaderProgram& fallback);
+
+/**
+ * @brief Create a tiny program that draws flat grey with uMVP, compiles in no time and stands in for programs that are
+ * not ready yet.
+ *
+ * @return Shader program, ready.
+ */
+ShaderProgram shaderCreateFallback();
+
 /**
  * @brief Cleanup and delete all shaders of a shader program and the program itself. Has to be called for each shader program after it is not used anymore.
  *
@@ -37,7 +171,18 @@ ShaderProgram shaderCreate(const std::string& vertexSource, const std::string& f
 void shaderDelete(const ShaderProgram& program);
 
 /**
- * @brief Function to set uniform in shader program.
+ * @brief Find a reflected uniform by name, arrays by their name without "[0]".
+ *
+ * @param program Shader program.
+ * @param name Uniform name.
+ *
+ * @return Uniform info or nullptr if the program has no active uniform with this name.
+ */
+const ShaderUniformInfo* shaderUniformFind(const ShaderProgram& program, const std::string& name);
+
+/**
+ * @brief Function to set uniform in shader program. Looks the uniform up in the reflected table, code that runs every
+ * frame should resolve a ShaderUniform handle once instead.
  *
  * @param shader Shader program.
  * @param name Uniform naem.
@@ -53,3 +198,209 @@ void shaderUniform(ShaderProgram& shader, const std::string& name, const Matrix4
  * @param value Value to which the uniform should be set.
  */
 void shaderUniform(ShaderProgram& shader, const std::string& name, int value);
+
+namespace detail
+{
+    [[noreturn]] void shaderUniformError(const std::string& message);
+    bool shaderIsSampler(GLenum type);
+
+    /* GLSL types a C++ type can be uploaded to and the matching glUniform* call */
+    template<typename T>
+    struct ShaderUniformTraits;
+
+    template<>
+    struct ShaderUniformTraits<float>
+    {
+        static bool accepts(GLenum type) { return type == GL_FLOAT; }
+        static void upload(GLint location, GLsizei count, const float* values) { glUniform1fv(location, count, values); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<Vector2D>
+    {
+        static_assert(sizeof(Vector2D) == 2 * sizeof(float), "Vector2D has to be tightly packed");
+        static bool accepts(GLenum type) { return type == GL_FLOAT_VEC2; }
+        static void upload(GLint location, GLsizei count, const Vector2D* values) { glUniform2fv(location, count, &values->x); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<Vector3D>
+    {
+        static_assert(sizeof(Vector3D) == 3 * sizeof(float), "Vector3D has to be tightly packed");
+        static bool accepts(GLenum type) { return type == GL_FLOAT_VEC3; }
+        static void upload(GLint location, GLsizei count, const Vector3D* values) { glUniform3fv(location, count, &values->x); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<Vector4D>
+    {
+        static_assert(sizeof(Vector4D) == 4 * sizeof(float), "Vector4D has to be tightly packed");
+        static bool accepts(GLenum type) { return type == GL_FLOAT_VEC4; }
+        static void upload(GLint location, GLsizei count, const Vector4D* values) { glUniform4fv(location, count, &values->x); }
+    };
+
+    /* bool uniforms and samplers (texture unit index) are set as int */
+    template<>
+    struct ShaderUniformTraits<int>
+    {
+        static bool accepts(GLenum type) { return type == GL_INT || type == GL_BOOL || shaderIsSampler(type); }
+        static void upload(GLint location, GLsizei count, const int* values) { glUniform1iv(location, count, values); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<unsigned int>
+    {
+        static bool accepts(GLenum type) { return type == GL_UNSIGNED_INT; }
+        static void upload(GLint location, GLsizei count, const unsigned int* values) { glUniform1uiv(location, count, values); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<ShaderIntVector<2>>
+    {
+        static bool accepts(GLenum type) { return type == GL_INT_VEC2 || type == GL_BOOL_VEC2; }
+        static void upload(GLint location, GLsizei count, const ShaderIntVector<2>* values) { glUniform2iv(location, count, values->data()); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<ShaderIntVector<3>>
+    {
+        static bool accepts(GLenum type) { return type == GL_INT_VEC3 || type == GL_BOOL_VEC3; }
+        static void upload(GLint location, GLsizei count, const ShaderIntVector<3>* values) { glUniform3iv(location, count, values->data()); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<ShaderIntVector<4>>
+    {
+        static bool accepts(GLenum type) { return type == GL_INT_VEC4 || type == GL_BOOL_VEC4; }
+        static void upload(GLint location, GLsizei count, const ShaderIntVector<4>* values) { glUniform4iv(location, count, values->data()); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<ShaderUintVector<2>>
+    {
+        static bool accepts(GLenum type) { return type == GL_UNSIGNED_INT_VEC2; }
+        static void upload(GLint location, GLsizei count, const ShaderUintVector<2>* values) { glUniform2uiv(location, count, values->data()); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<ShaderUintVector<3>>
+    {
+        static bool accepts(GLenum type) { return type == GL_UNSIGNED_INT_VEC3; }
+        static void upload(GLint location, GLsizei count, const ShaderUintVector<3>* values) { glUniform3uiv(location, count, values->data()); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<ShaderUintVector<4>>
+    {
+        static bool accepts(GLenum type) { return type == GL_UNSIGNED_INT_VEC4; }
+        static void upload(GLint location, GLsizei count, const ShaderUintVector<4>* values) { glUniform4uiv(location, count, values->data()); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<Matrix3D>
+    {
+        static_assert(sizeof(Matrix3D) == 9 * sizeof(float), "Matrix3D has to be tightly packed");
+        static bool accepts(GLenum type) { return type == GL_FLOAT_MAT3; }
+        static void upload(GLint location, GLsizei count, const Matrix3D* values) { glUniformMatrix3fv(location, count, GL_FALSE, values->ptr()); }
+    };
+
+    template<>
+    struct ShaderUniformTraits<Matrix4D>
+    {
+        static_assert(sizeof(Matrix4D) == 16 * sizeof(float), "Matrix4D has to be tightly packed");
+        static bool accepts(GLenum type) { return type == GL_FLOAT_MAT4; }
+        static void upload(GLint location, GLsizei count, const Matrix4D* values) { glUniformMatrix4fv(location, count, GL_FALSE, values->ptr()); }
+    };
+
+    template<unsigned int C, unsigned int R>
+    struct ShaderUniformTraits<ShaderMatrix<C, R>>
+    {
+        static bool accepts(GLenum type)
+        {
+            const GLenum types[3][3] = {{GL_FLOAT_MAT2, GL_FLOAT_MAT2x3, GL_FLOAT_MAT2x4},
+                                        {GL_FLOAT_MAT3x2, GL_FLOAT_MAT3, GL_FLOAT_MAT3x4},
+                                        {GL_FLOAT_MAT4x2, GL_FLOAT_MAT4x3, GL_FLOAT_MAT4}};
+            return type == types[C - 2][R - 2];
+        }
+
+        static void upload(GLint location, GLsizei count, const ShaderMatrix<C, R>* values)
+        {
+            static_assert(C >= 2 && C <= 4 && R >= 2 && R <= 4, "GLSL matrices have 2 to 4 columns and rows");
+            const GLfloat* data = &values->n[0][0];
+            if(C == 2 && R == 2) glUniformMatrix2fv(location, count, GL_FALSE, data);
+            else if(C == 2 && R == 3) glUniformMatrix2x3fv(location, count, GL_FALSE, data);
+            else if(C == 2 && R == 4) glUniformMatrix2x4fv(location, count, GL_FALSE, data);
+            else if(C == 3 && R == 2) glUniformMatrix3x2fv(location, count, GL_FALSE, data);
+            else if(C == 3 && R == 3) glUniformMatrix3fv(location, count, GL_FALSE, data);
+            else if(C == 3 && R == 4) glUniformMatrix3x4fv(location, count, GL_FALSE, data);
+            else if(C == 4 && R == 2) glUniformMatrix4x2fv(location, count, GL_FALSE, data);
+            else if(C == 4 && R == 3) glUniformMatrix4x3fv(location, count, GL_FALSE, data);
+            else glUniformMatrix4fv(location, count, GL_FALSE, data);
+        }
+    };
+}
+
+/**
+ * @brief Resolve a uniform once, e.g. after loading the shader. The C++ type has to match the GLSL type: float,
+ * Vector2D/3D/4D, int (also for bool and samplers), unsigned int, ShaderIntVector<N> (ivecN, bvecN),
+ * ShaderUintVector<N> (uvecN), Matrix3D, Matrix4D or ShaderMatrix<C, R> (matCxR). Arrays use the element type.
+ *
+ * @param program Shader program.
+ * @param name Uniform name, arrays without "[0]".
+ * @param required Throw if the program has no active uniform with this name, otherwise an unused handle is returned.
+ *
+ * @return Uniform handle.
+ *
+ * usage:
+ *
+ *   ShaderUniform<Matrix4D> model = shaderUniformHandle<Matrix4D>(program, "uModel");
+ *   ShaderUniform<Vector3D> lights = shaderUniformHandle<Vector3D>(program, "uLightPositions");
+ *   ...
+ *   glStateUseProgram(program.id);
+ *   shaderUniform(model, modelMatrix);
+ *   shaderUniform(lights, positions.data(), GLsizei(positions.size()));
+ *
+ */
+template<typename T>
+ShaderUniform<T> shaderUniformHandle(const ShaderProgram& program, const std::string& name, bool required = true)
+{
+    const ShaderUniformInfo* info = shaderUniformFind(program, name);
+    if(!info)
+    {
+        if(required)
+        {
+            detail::shaderUniformError("Couldn't find uniform " + name);
+        }
+        return ShaderUniform<T>();
+    }
+    if(!detail::ShaderUniformTraits<T>::accepts(info->type))
+    {
+        detail::shaderUniformError("Type doesn't match the declaration of uniform " + name);
+    }
+    return ShaderUniform<T>{info->location, info->size};
+}
+
+/**
+ * @brief Set a uniform of the program in use.
+ *
+ * @param uniform Uniform handle.
+ * @param value Value to which the uniform (or the first array element) should be set.
+ */
+template<typename T>
+void shaderUniform(const ShaderUniform<T>& uniform, const T& value)
+{
+    detail::ShaderUniformTraits<T>::upload(uniform.location, 1, &value);
+}
+
+/**
+ * @brief Set the first elements of an array uniform of the program in use.
+ *
+ * @param uniform Uniform handle.
+ * @param values Values, surplus values beyond the array size are ignored.
+ * @param count Number of values.
+ */
+template<typename T>
+void shaderUniform(const ShaderUniform<T>& uniform, const T* values, GLsizei count)
+{
+    detail::ShaderUniformTraits<T>::upload(uniform.location, std::min(count, uniform.size), values);
+}
@@ -0,0 +1,227 @@
+#include "shadercache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace detail
+{
+    struct ShaderCache
+    {
+        bool enabled = false;
+        std::string directory;
+
+        /* hash of the driver strings, part of every key */
+        uint64_t driverHash = 0;
+
+        ShaderCacheStats stats;
+    };
+
+    ShaderCache& shaderCache()
+    {
+        static ShaderCache cache;
+        return cache;
+    }
+
+    constexpr uint64_t SHADERCACHE_FNV_OFFSET = 14695981039346656037ull;
+    constexpr uint64_t SHADERCACHE_FNV_PRIME = 1099511628211ull;
+
+    /* the length goes in first, so that ("ab", "c") and ("a", "bc") give different keys */
+    uint64_t shaderCacheHash(uint64_t hash, const char* data, std::size_t size)
+    {
+        uint64_t length = size;
+        for(std::size_t i = 0; i < sizeof(length); i++)
+        {
+            hash = (hash ^ uint8_t(length >> (8 * i))) * SHADERCACHE_FNV_PRIME;
+        }
+        for(std::size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ uint8_t(data[i])) * SHADERCACHE_FNV_PRIME;
+        }
+        return hash;
+    }
+
+    uint64_t shaderCacheHashString(uint64_t hash, GLenum name)
+    {
+        const char* value = reinterpret_cast<const char*>(glGetString(name));
+        return value ? shaderCacheHash(hash, value, std::strlen(value)) : shaderCacheHash(hash, "", 0);
+    }
+
+    std::string shaderCachePath(uint64_t key)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.vcp", (unsigned long long) key);
+        return (std::filesystem::path(shaderCache().directory) / name).string();
+    }
+
+    void shaderCacheRecord(bool hit, double seconds)
+    {
+        ShaderCacheStats& stats = shaderCache().stats;
+        if(hit)
+        {
+            stats.hits++;
+            stats.loadSeconds += seconds;
+        }
+        else
+        {
+            stats.misses++;
+            stats.compileSeconds += seconds;
+        }
+    }
+}
+
+bool shaderCacheEnable(const std::string& directory)
+{
+    detail::ShaderCache& cache = detail::shaderCache();
+    cache.enabled = false;
+
+    GLint formats = 0;
+    if(GLAD_GL_ARB_get_program_binary || GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1))
+    {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    if(formats <= 0 || !glProgramBinary || !glGetProgramBinary || !glProgramParameteri)
+    {
+        std::cerr << "[ShaderCache] Program binaries are not supported, shaders are compiled from source" << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if(error)
+    {
+        std::cerr << "[ShaderCache] Couldn't create cache directory " << directory << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    uint64_t hash = detail::SHADERCACHE_FNV_OFFSET;
+    hash = detail::shaderCacheHash(hash, reinterpret_cast<const char*>(&SHADERCACHE_VERSION), sizeof(SHADERCACHE_VERSION));
+    hash = detail::shaderCacheHashString(hash, GL_VENDOR);
+    hash = detail::shaderCacheHashString(hash, GL_RENDERER);
+    hash = detail::shaderCacheHashString(hash, GL_VERSION);
+    hash = detail::shaderCacheHashString(hash, GL_SHADING_LANGUAGE_VERSION);
+
+    cache.directory = directory;
+    cache.driverHash = hash;
+    cache.enabled = true;
+    return true;
+}
+
+void shaderCacheDisable()
+{
+    detail::shaderCache().enabled = false;
+}
+
+bool shaderCacheEnabled()
+{
+    return detail::shaderCache().enabled;
+}
+
+uint64_t shaderCacheKey(const std::string& vertexSource, const std::string& fragmentSource)
+{
+    uint64_t hash = detail::shaderCache().driverHash;
+    hash = detail::shaderCacheHash(hash, vertexSource.data(), vertexSource.size());
+    hash = detail::shaderCacheHash(hash, fragmentSource.data(), fragmentSource.size());
+    return hash;
+}
+
+bool shaderCacheLoad(GLuint program, uint64_t key)
+{
+    const std::string path = detail::shaderCachePath(key);
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    ShaderCacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    std::vector<char> binary;
+    bool valid = file.good() && std::memcmp(header.magic, SHADERCACHE_MAGIC, sizeof(SHADERCACHE_MAGIC)) == 0
+                 && header.version == SHADERCACHE_VERSION && header.key == key && header.size > 0;
+    if(valid)
+    {
+        binary.resize(header.size);
+        file.read(binary.data(), std::streamsize(binary.size()));
+        valid = file.gcount() == std::streamsize(binary.size());
+    }
+    file.close();
+
+    GLint linked = GL_FALSE;
+    if(valid)
+    {
+        glProgramBinary(program, GLenum(header.format), binary.data(), GLsizei(binary.size()));
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+    if(linked == GL_FALSE)
+    {
+        /* corrupt file or the driver doesn't accept its own binary anymore */
+        detail::shaderCache().stats.rejected++;
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+    return true;
+}
+
+void shaderCacheStore(GLuint program, uint64_t key)
+{
+    GLint size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    if(size <= 0)
+    {
+        return;
+    }
+
+    ShaderCacheHeader header{};
+    std::memcpy(header.magic, SHADERCACHE_MAGIC, sizeof(SHADERCACHE_MAGIC));
+    header.version = SHADERCACHE_VERSION;
+    header.key = key;
+
+    std::vector<char> binary(static_cast<std::size_t>(size));
+    GLenum format = 0;
+    GLsizei length = 0;
+    glGetProgramBinary(program, size, &length, &format, binary.data());
+    if(length <= 0)
+    {
+        return;
+    }
+    header.format = format;
+    header.size = uint32_t(length);
+
+    /* written under a temporary name, a crash never leaves a truncated binary behind */
+    const std::string path = detail::shaderCachePath(key);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), std::streamsize(length));
+        if(!file.good())
+        {
+            std::cerr << "[ShaderCache] Couldn't write program binary " << temporary << std::endl;
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if(error)
+    {
+        std::cerr << "[ShaderCache] Couldn't write program binary " << path << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+    detail::shaderCache().stats.stored++;
+}
+
+const ShaderCacheStats& shaderCacheStats()
+{
+    return detail::shaderCache().stats;
+}
+
+void shaderCacheResetStats()
+{
+    detail::shaderCache().stats = ShaderCacheStats();
+}
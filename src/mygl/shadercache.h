@@ -0,0 +1,115 @@
+#pragma once
+
+#include "base.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * On-disk cache of linked program binaries (*.vcp), used by shaderCreate(...) once enabled. Each file holds one
+ * ShaderCacheHeader followed by the driver binary. The key is a hash of both sources (so also of all #defines in them)
+ * and the GL vendor, renderer and version strings, a driver update therefore never loads an old binary. Binaries the
+ * driver rejects anyway are deleted and the program is compiled from source.
+ */
+constexpr char SHADERCACHE_MAGIC[4] = {'V', 'C', 'P', 'B'};
+constexpr uint32_t SHADERCACHE_VERSION = 1;
+
+struct ShaderCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;        // binary format returned by glGetProgramBinary
+    uint32_t size;          // bytes of the binary after the header
+};
+
+/* counters since the last shaderCacheResetStats() */
+struct ShaderCacheStats
+{
+    /* programs loaded from a binary */
+    unsigned int hits = 0;
+
+    /* programs compiled from source, including rejected binaries */
+    unsigned int misses = 0;
+
+    /* binaries the driver didn't accept */
+    unsigned int rejected = 0;
+
+    /* binaries written */
+    unsigned int stored = 0;
+
+    /* time from submitting a program until it was ready, for cache hits and for compiled programs */
+    double loadSeconds = 0.0;
+    double compileSeconds = 0.0;
+};
+
+/**
+ * @brief Enable the cache. Needs a current context, does nothing if the driver has no program binary formats.
+ *
+ * @param directory Directory of the cache files, created if it doesn't exist.
+ *
+ * @return True if binaries are used from now on.
+ *
+ * usage:
+ *
+ *   shaderCacheEnable("shadercache");
+ *   ShaderProgram program = shaderLoad("shader/default.vert", "shader/default.frag");
+ *   // shaderCacheStats().hits, shaderCacheStats().loadSeconds, ...
+ *
+ */
+bool shaderCacheEnable(const std::string& directory);
+
+/**
+ * @brief Disable the cache, programs are always compiled from source again.
+ */
+void shaderCacheDisable();
+
+/**
+ * @brief Check if the cache is enabled.
+ */
+bool shaderCacheEnabled();
+
+/**
+ * @brief Compute the cache key of a program.
+ *
+ * @param vertexSource Vertex shader source.
+ * @param fragmentSource Fragment shader source.
+ *
+ * @return 64 bit FNV-1a hash of the sources and the driver strings.
+ */
+uint64_t shaderCacheKey(const std::string& vertexSource, const std::string& fragmentSource);
+
+/**
+ * @brief Load a cached binary into a program object.
+ *
+ * @param program Program object without attached shaders.
+ * @param key Cache key.
+ *
+ * @return True if the program is linked, false if there is no binary or the driver rejected it (the file is deleted).
+ */
+bool shaderCacheLoad(GLuint program, uint64_t key);
+
+/**
+ * @brief Write the binary of a linked program to the cache. The program has to be linked with
+ * GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+ *
+ * @param program Linked program.
+ * @param key Cache key.
+ */
+void shaderCacheStore(GLuint program, uint64_t key);
+
+/**
+ * @brief Counters and timings of cache hits and misses.
+ */
+const ShaderCacheStats& shaderCacheStats();
+
+/**
+ * @brief Reset the counters.
+ */
+void shaderCacheResetStats();
+
+namespace detail
+{
+    /* called by shaderCreate(...) with the time it took to create a program */
+    void shaderCacheRecord(bool hit, double seconds);
+}
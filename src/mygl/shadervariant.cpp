@@ -0,0 +1,172 @@
+#include "shadervariant.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace detail
+{
+    void shaderPreprocessError(const std::string& message)
+    {
+        std::cerr << "[Shader] " << message << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[Shader] " + message);
+    }
+
+    /* files in include order (their source string numbers) and the chain of files currently being included */
+    struct ShaderPreprocessor
+    {
+        std::vector<std::string> files;
+        std::vector<std::string> stack;
+        std::string defines;
+    };
+
+    bool shaderDirective(const std::string& line, const char* directive, std::string* rest)
+    {
+        std::size_t start = line.find_first_not_of(" \t");
+        if(start == std::string::npos || line.compare(start, std::strlen(directive), directive) != 0)
+        {
+            return false;
+        }
+        *rest = line.substr(start + std::strlen(directive));
+        return true;
+    }
+
+    void shaderPreprocessFile(ShaderPreprocessor& state, const std::string& path, std::string& output)
+    {
+        std::ifstream file(path);
+        if(!file.is_open())
+        {
+            shaderPreprocessError("Couldn't open shader file at " + path);
+        }
+
+        const int index = int(state.files.size());
+        const bool root = index == 0;
+        state.files.push_back(path);
+        state.stack.push_back(path);
+        if(!root)
+        {
+            output += "#line 1 " + std::to_string(index) + "\n";
+        }
+
+        bool versionSeen = false;
+        std::string line, rest;
+        for(int number = 1; std::getline(file, line); number++)
+        {
+            if(shaderDirective(line, "#version", &rest))
+            {
+                if(!root)
+                {
+                    shaderPreprocessError("#version in included file " + path);
+                }
+                /* defines have to follow #version, which has to come first */
+                output += line + "\n" + state.defines + "#line " + std::to_string(number + 1) + " 0\n";
+                versionSeen = true;
+            }
+            else if(shaderDirective(line, "#include", &rest))
+            {
+                std::size_t open = rest.find('"');
+                std::size_t close = open == std::string::npos ? open : rest.find('"', open + 1);
+                if(close == std::string::npos)
+                {
+                    shaderPreprocessError(path + ":" + std::to_string(number) + ": #include expects \"file\"");
+                }
+
+                std::string included = (std::filesystem::path(path).parent_path() / rest.substr(open + 1, close - open - 1))
+                                           .lexically_normal().string();
+                if(std::find(state.stack.begin(), state.stack.end(), included) != state.stack.end())
+                {
+                    shaderPreprocessError(path + ":" + std::to_string(number) + ": " + included + " includes itself");
+                }
+
+                /* every file once, an include of an already included file is an empty line */
+                if(std::find(state.files.begin(), state.files.end(), included) == state.files.end())
+                {
+                    shaderPreprocessFile(state, included, output);
+                    output += "#line " + std::to_string(number + 1) + " " + std::to_string(index) + "\n";
+                }
+                else
+                {
+                    output += "\n";
+                }
+            }
+            else
+            {
+                output += line + "\n";
+            }
+        }
+
+        if(root && !versionSeen && !state.defines.empty())
+        {
+            output = state.defines + "#line 1 0\n" + output;
+        }
+        state.stack.pop_back();
+    }
+
+    /* sorted and without duplicates, so that the same set always finds the same program */
+    std::string shaderVariantKey(const ShaderDefines& defines)
+    {
+        ShaderDefines sorted = defines;
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+        std::string key;
+        for(const std::string& define : sorted)
+        {
+            key += define + ";";
+        }
+        return key;
+    }
+}
+
+std::string shaderPreprocess(const std::string& path, const ShaderDefines& defines)
+{
+    detail::ShaderPreprocessor state;
+    for(const std::string& define : defines)
+    {
+        std::string text = define;
+        std::size_t equals = text.find('=');
+        if(equals != std::string::npos)
+        {
+            text[equals] = ' ';
+        }
+        state.defines += "#define " + text + "\n";
+    }
+
+    std::string output;
+    detail::shaderPreprocessFile(state, path, output);
+    return output;
+}
+
+ShaderVariants shaderVariantsCreate(const std::string& vertexPath, const std::string& fragmentPath)
+{
+    ShaderVariants variants;
+    variants.vertexPath = vertexPath;
+    variants.fragmentPath = fragmentPath;
+    return variants;
+}
+
+ShaderProgram& shaderVariant(ShaderVariants& variants, const ShaderDefines& defines)
+{
+    const std::string key = detail::shaderVariantKey(defines);
+    auto it = variants.programs.find(key);
+    if(it != variants.programs.end())
+    {
+        return it->second;
+    }
+
+    ShaderProgram program = shaderSubmit(shaderPreprocess(variants.vertexPath, defines), shaderPreprocess(variants.fragmentPath, defines));
+    return variants.programs.emplace(key, std::move(program)).first->second;
+}
+
+void shaderVariantsDelete(ShaderVariants& variants)
+{
+    for(auto& entry : variants.programs)
+    {
+        shaderDelete(entry.second);
+    }
+    variants.programs.clear();
+}
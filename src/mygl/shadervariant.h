@@ -0,0 +1,85 @@
+#pragma once
+
+#include "shader.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Compile-time specialization of shader files. The preprocessor resolves #include "file" (relative to the including file,
+ * every file at most once) and injects a set of #defines right after #version. Source string numbers in compile errors
+ * are the files in include order, 0 is the shader file itself.
+ *
+ * Switches of shader/default.vert and shader/default.frag:
+ *   INSTANCED      model matrix and color from the instanced attributes (see meshDrawInstanced), camera from the block
+ *   UNIFORM_COLOR  color from uniform vec4 uColor instead of the vertex color
+ *   WAVES          height of the vertices displaced by the waves in uWaves and uWaveDirections (see waves.glsl)
+ *   LIGHTING       diffuse lighting with flat normals, needs uModel or INSTANCED
+ */
+
+/* defines of a variant, "NAME" or "NAME=VALUE" */
+using ShaderDefines = std::vector<std::string>;
+
+/**
+ * Lazily compiled variants of one vertex and fragment shader pair. A variant is submitted (see shaderSubmit(...)) the
+ * first time it is asked for, permutations nobody draws with are never compiled.
+ */
+struct ShaderVariants
+{
+    std::string vertexPath;
+    std::string fragmentPath;
+
+    /* programs by their sorted define set */
+    std::unordered_map<std::string, ShaderProgram> programs;
+};
+
+/**
+ * @brief Read a shader file, resolve its includes and add defines.
+ *
+ * @param path Path to the shader file.
+ * @param defines Defines added after #version.
+ *
+ * @return Source string ready to compile.
+ */
+std::string shaderPreprocess(const std::string& path, const ShaderDefines& defines = {});
+
+/**
+ * @brief Create an empty variant cache of a shader pair, nothing is compiled yet.
+ *
+ * @param vertexPath Path to vertex shader file.
+ * @param fragmentPath Path to fragment shader file.
+ *
+ * @return Variant cache.
+ *
+ * usage:
+ *
+ *   ShaderVariants variants = shaderVariantsCreate("shader/default.vert", "shader/default.frag");
+ *   // submitted here, looked up once and kept
+ *   ShaderProgram& water = shaderVariant(variants, {"WAVES", "LIGHTING"});
+ *   ...
+ *   // every frame, drawn with the fallback until it is linked
+ *   renderQueueSubmit(queue, shaderSelect(water, fallback), waterMesh, model);
+ *   ...
+ *   shaderVariantsDelete(variants);
+ *
+ */
+ShaderVariants shaderVariantsCreate(const std::string& vertexPath, const std::string& fragmentPath);
+
+/**
+ * @brief Get the program of a define set, submitting it on first use. The order of the defines doesn't matter.
+ *
+ * @param variants Variant cache.
+ * @param defines Defines of the variant.
+ *
+ * @return Shader program, possibly not ready yet (see shaderPoll(...), shaderWait(...)). The reference stays valid until
+ * shaderVariantsDelete(...).
+ */
+ShaderProgram& shaderVariant(ShaderVariants& variants, const ShaderDefines& defines);
+
+/**
+ * @brief Delete all compiled variants.
+ *
+ * @param variants Variant cache.
+ */
+void shaderVariantsDelete(ShaderVariants& variants);
@@ -0,0 +1,21 @@
+#pragma once
+
+/* SSE is part of every x86-64 target, other architectures use the scalar code paths */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MYGL_SSE 1
+#include <immintrin.h>
+#endif
+
+/*
+ * AVX kernels are compiled for the AVX target with a function attribute and only called if the CPU supports it, so the
+ * rest of the code keeps the default target. MSVC needs /arch:AVX for them.
+ */
+#if defined(MYGL_SSE) && (defined(__GNUC__) || defined(__clang__))
+#define MYGL_AVX 1
+#define MYGL_TARGET_AVX __attribute__((target("avx")))
+inline bool simdHasAVX() { return __builtin_cpu_supports("avx"); }
+#elif defined(MYGL_SSE) && defined(__AVX__)
+#define MYGL_AVX 1
+#define MYGL_TARGET_AVX
+inline bool simdHasAVX() { return true; }
+#endif
@@ -0,0 +1,442 @@
+#include "simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace detail
+{
+    /* symmetric 4x4 error quadric, error(p) = p^T A p + 2 b^T p + c */
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+    };
+
+    /* plane dot(n, p) + d = 0 with unit normal n */
+    void quadricAddPlane(Quadric& q, const Vector3D& n, float d)
+    {
+        q.a00 += n.x * n.x; q.a01 += n.x * n.y; q.a02 += n.x * n.z;
+        q.a11 += n.y * n.y; q.a12 += n.y * n.z; q.a22 += n.z * n.z;
+        q.b0 += n.x * d; q.b1 += n.y * d; q.b2 += n.z * d;
+        q.c += double(d) * d;
+    }
+
+    void quadricAdd(Quadric& q, const Quadric& r)
+    {
+        q.a00 += r.a00; q.a01 += r.a01; q.a02 += r.a02;
+        q.a11 += r.a11; q.a12 += r.a12; q.a22 += r.a22;
+        q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+        q.c += r.c;
+    }
+
+    double quadricError(const Quadric& q, const Vector3D& p)
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double e = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z + 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+                 + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+        return std::max(e, 0.0);
+    }
+
+    /*
+     * Manifold vertices collapse along any edge, border vertices only along border edges. Locked vertices (non-manifold
+     * or border corners) don't move but other vertices may collapse onto them. Seam vertices have several corners with
+     * different attributes at the same position and are neither moved nor used as target.
+     */
+    enum class SimplifyVertexKind : uint8_t { Manifold, Border, Locked, Seam };
+
+    struct EdgeCollapse
+    {
+        double cost;
+        unsigned int from;
+        unsigned int to;
+    };
+
+    bool samePosition(const Vector3D& a, const Vector3D& b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    unsigned int simplifyFind(std::vector<unsigned int>& remap, unsigned int v)
+    {
+        unsigned int root = v;
+        while(remap[root] != root) { root = remap[root]; }
+        while(remap[v] != root)
+        {
+            unsigned int next = remap[v];
+            remap[v] = root;
+            v = next;
+        }
+        return root;
+    }
+
+    /* undirected edges of a triangle list as sorted (min, max) pairs with their number of triangles */
+    void simplifyEdges(const std::vector<unsigned int>& triangles, std::vector<std::pair<uint64_t, unsigned int>>& edges)
+    {
+        std::vector<uint64_t> keys;
+        keys.reserve(triangles.size());
+        for(std::size_t i = 0; i < triangles.size(); i += 3)
+        {
+            for(int e = 0; e < 3; e++)
+            {
+                unsigned int a = triangles[i + e], b = triangles[i + (e + 1) % 3];
+                keys.push_back(uint64_t(std::min(a, b)) << 32 | std::max(a, b));
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+
+        edges.clear();
+        for(std::size_t i = 0; i < keys.size();)
+        {
+            std::size_t j = i;
+            while(j < keys.size() && keys[j] == keys[i]) { j++; }
+            edges.push_back({keys[i], unsigned(j - i)});
+            i = j;
+        }
+    }
+
+    bool simplifyIsBorder(const std::vector<std::pair<uint64_t, unsigned int>>& edges, unsigned int a, unsigned int b)
+    {
+        uint64_t key = uint64_t(std::min(a, b)) << 32 | std::max(a, b);
+        auto it = std::lower_bound(edges.begin(), edges.end(), std::make_pair(key, 0u));
+        return it != edges.end() && it->first == key && it->second == 1;
+    }
+
+    /* copy the vertices referenced by indices into a compact vertex buffer */
+    void compactLevel(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                      std::vector<Vertex>& levelVertices, std::vector<unsigned int>& levelIndices)
+    {
+        std::vector<unsigned int> slot(vertices.size(), ~0u);
+        levelVertices.clear();
+        levelIndices.resize(indices.size());
+        for(std::size_t i = 0; i < indices.size(); i++)
+        {
+            unsigned int& s = slot[indices[i]];
+            if(s == ~0u)
+            {
+                s = unsigned(levelVertices.size());
+                levelVertices.push_back(vertices[indices[i]]);
+            }
+            levelIndices[i] = s;
+        }
+    }
+}
+
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                       std::size_t targetIndexCount, float maxError, float* resultError)
+{
+    using detail::SimplifyVertexKind;
+
+    std::vector<unsigned int> result(indices.begin(), indices.end() - indices.size() % 3);
+    if(resultError) { *resultError = 0.0f; }
+    if(result.size() <= targetIndexCount || vertices.empty())
+    {
+        return result;
+    }
+
+    /* corners at the same position share one canonical vertex, the topology is built on canonical vertices */
+    const unsigned int vertexCount = unsigned(vertices.size());
+    std::vector<unsigned int> order(vertexCount);
+    for(unsigned int i = 0; i < vertexCount; i++) { order[i] = i; }
+    auto lessPosition = [&](unsigned int a, unsigned int b)
+    {
+        const Vector3D& p = vertices[a].pos;
+        const Vector3D& q = vertices[b].pos;
+        return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z != q.z ? p.z < q.z : a < b;
+    };
+    std::sort(order.begin(), order.end(), lessPosition);
+
+    std::vector<unsigned int> canonical(vertexCount);
+    std::vector<SimplifyVertexKind> kind(vertexCount, SimplifyVertexKind::Manifold);
+    for(unsigned int i = 0; i < vertexCount;)
+    {
+        unsigned int j = i + 1;
+        while(j < vertexCount && detail::samePosition(vertices[order[i]].pos, vertices[order[j]].pos)) { j++; }
+        for(unsigned int k = i; k < j; k++)
+        {
+            canonical[order[k]] = order[i];
+        }
+        if(j - i > 1)
+        {
+            kind[order[i]] = SimplifyVertexKind::Seam;
+        }
+        i = j;
+    }
+
+    std::vector<unsigned int> triangles(result.size());
+    for(std::size_t i = 0; i < result.size(); i++)
+    {
+        triangles[i] = canonical[result[i]];
+    }
+
+    /* classify vertices by their edges, an edge with one triangle is a border, with more than two non-manifold */
+    std::vector<std::pair<uint64_t, unsigned int>> edges;
+    detail::simplifyEdges(triangles, edges);
+
+    std::vector<unsigned char> borderEdges(vertexCount, 0);
+    for(const auto& edge : edges)
+    {
+        unsigned int a = unsigned(edge.first >> 32), b = unsigned(edge.first & 0xFFFFFFFFu);
+        for(unsigned int v : {a, b})
+        {
+            if(kind[v] == SimplifyVertexKind::Seam) { continue; }
+            if(edge.second > 2) { kind[v] = SimplifyVertexKind::Locked; }
+            if(edge.second == 1 && borderEdges[v] < 255) { borderEdges[v]++; }
+        }
+    }
+    for(unsigned int v = 0; v < vertexCount; v++)
+    {
+        if(kind[v] == SimplifyVertexKind::Manifold && borderEdges[v] > 0)
+        {
+            kind[v] = borderEdges[v] == 2 ? SimplifyVertexKind::Border : SimplifyVertexKind::Locked;
+        }
+    }
+
+    /* face planes, border edges add a perpendicular plane that keeps the outline in place */
+    std::vector<detail::Quadric> quadrics(vertexCount);
+    for(std::size_t i = 0; i < triangles.size(); i += 3)
+    {
+        const Vector3D* p[3] = {&vertices[triangles[i]].pos, &vertices[triangles[i + 1]].pos, &vertices[triangles[i + 2]].pos};
+        Vector3D n = cross(*p[1] - *p[0], *p[2] - *p[0]);
+        float area = length(n);
+        if(area == 0.0f) { continue; }
+        n = n / area;
+
+        detail::Quadric q;
+        detail::quadricAddPlane(q, n, -dot(n, *p[0]));
+        for(int e = 0; e < 3; e++)
+        {
+            detail::quadricAdd(quadrics[triangles[i + e]], q);
+
+            unsigned int a = triangles[i + e], b = triangles[i + (e + 1) % 3];
+            if(detail::simplifyIsBorder(edges, a, b))
+            {
+                Vector3D edgeNormal = cross(*p[(e + 1) % 3] - *p[e], n);
+                float edgeLength = length(edgeNormal);
+                if(edgeLength == 0.0f) { continue; }
+                edgeNormal = edgeNormal / edgeLength;
+
+                detail::Quadric border;
+                detail::quadricAddPlane(border, edgeNormal, -dot(edgeNormal, *p[e]));
+                detail::quadricAdd(quadrics[a], border);
+                detail::quadricAdd(quadrics[b], border);
+            }
+        }
+    }
+
+    std::vector<unsigned int> remap(vertexCount);
+    for(unsigned int i = 0; i < vertexCount; i++) { remap[i] = i; }
+
+    const double maxCost = double(maxError) * double(maxError);
+    const std::size_t targetTriangles = targetIndexCount / 3;
+    std::size_t triangleCount = triangles.size() / 3;
+    double error = 0.0;
+
+    std::vector<detail::EdgeCollapse> collapses;
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1), adjacency;
+    std::vector<unsigned char> touched(vertexCount);
+
+    /* each pass collapses the cheapest independent edges, so every vertex moves at most once per pass */
+    while(triangleCount > targetTriangles)
+    {
+        detail::simplifyEdges(triangles, edges);
+
+        collapses.clear();
+        for(const auto& edge : edges)
+        {
+            unsigned int a = unsigned(edge.first >> 32), b = unsigned(edge.first & 0xFFFFFFFFu);
+            if(kind[a] == SimplifyVertexKind::Seam && kind[b] == SimplifyVertexKind::Seam) { continue; }
+
+            bool border = edge.second == 1;
+            auto allowed = [&](unsigned int from, unsigned int to)
+            {
+                return kind[to] != SimplifyVertexKind::Seam
+                       && (kind[from] == SimplifyVertexKind::Manifold || (kind[from] == SimplifyVertexKind::Border && border));
+            };
+
+            detail::Quadric q = quadrics[a];
+            detail::quadricAdd(q, quadrics[b]);
+            double costAB = allowed(a, b) ? detail::quadricError(q, vertices[b].pos) : -1.0;
+            double costBA = allowed(b, a) ? detail::quadricError(q, vertices[a].pos) : -1.0;
+
+            if(costAB >= 0.0 && (costBA < 0.0 || costAB <= costBA)) { collapses.push_back({costAB, a, b}); }
+            else if(costBA >= 0.0) { collapses.push_back({costBA, b, a}); }
+        }
+        if(collapses.empty())
+        {
+            break;
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const detail::EdgeCollapse& x, const detail::EdgeCollapse& y) { return x.cost < y.cost; });
+
+        /* triangles around each vertex for the flip test */
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+        for(unsigned int v : triangles) { adjacencyOffsets[v + 1]++; }
+        for(unsigned int v = 0; v < vertexCount; v++) { adjacencyOffsets[v + 1] += adjacencyOffsets[v]; }
+        adjacency.resize(triangles.size());
+        {
+            std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for(std::size_t i = 0; i < triangles.size(); i++)
+            {
+                adjacency[fill[triangles[i]]++] = unsigned(i / 3);
+            }
+        }
+
+        std::fill(touched.begin(), touched.end(), 0);
+        std::size_t collapsed = 0;
+        bool errorBound = false;
+
+        for(const detail::EdgeCollapse& collapse : collapses)
+        {
+            if(collapse.cost > maxCost)
+            {
+                errorBound = true;
+                break;
+            }
+            if(touched[collapse.from] || touched[collapse.to])
+            {
+                continue;
+            }
+
+            /* reject collapses that flip a remaining triangle around the moving vertex */
+            bool flips = false;
+            std::size_t removed = 0;
+            for(unsigned int t = adjacencyOffsets[collapse.from]; t < adjacencyOffsets[collapse.from + 1] && !flips; t++)
+            {
+                unsigned int tri = adjacency[t] * 3;
+                unsigned int v[3];
+                for(int k = 0; k < 3; k++) { v[k] = detail::simplifyFind(remap, triangles[tri + k]); }
+                if(v[0] == v[1] || v[1] == v[2] || v[0] == v[2]) { continue; }
+                if(v[0] == collapse.to || v[1] == collapse.to || v[2] == collapse.to)
+                {
+                    removed++;
+                    continue;
+                }
+
+                Vector3D p[3], q[3];
+                for(int k = 0; k < 3; k++)
+                {
+                    p[k] = vertices[v[k]].pos;
+                    q[k] = vertices[v[k] == collapse.from ? collapse.to : v[k]].pos;
+                }
+                Vector3D before = cross(p[1] - p[0], p[2] - p[0]);
+                Vector3D after = cross(q[1] - q[0], q[2] - q[0]);
+                flips = dot(before, after) <= 0.0f;
+            }
+            if(flips)
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            detail::quadricAdd(quadrics[collapse.to], quadrics[collapse.from]);
+            touched[collapse.from] = touched[collapse.to] = 1;
+            error = std::max(error, collapse.cost);
+            triangleCount -= std::min(removed, triangleCount);
+            collapsed++;
+
+            if(triangleCount <= targetTriangles)
+            {
+                break;
+            }
+        }
+
+        /* apply the collapses and drop triangles that became degenerate */
+        std::size_t write = 0;
+        for(std::size_t i = 0; i < triangles.size(); i += 3)
+        {
+            unsigned int v[3];
+            for(int k = 0; k < 3; k++) { v[k] = detail::simplifyFind(remap, triangles[i + k]); }
+            if(v[0] == v[1] || v[1] == v[2] || v[0] == v[2]) { continue; }
+
+            for(int k = 0; k < 3; k++)
+            {
+                /* moved vertices are never seams, so the canonical vertex is the only corner at that position */
+                result[write + k] = v[k] == triangles[i + k] ? result[i + k] : v[k];
+                triangles[write + k] = v[k];
+            }
+            write += 3;
+        }
+        triangles.resize(write);
+        result.resize(write);
+        triangleCount = write / 3;
+
+        if(collapsed == 0 || errorBound)
+        {
+            break;
+        }
+    }
+
+    if(resultError) { *resultError = float(std::sqrt(error)); }
+    return result;
+}
+
+LodChain lodChainCreate(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<float>& ratios,
+                        float maxError, GLenum vertexBufferUsage, GLenum indexBufferUsage)
+{
+    LodChain chain;
+    chain.levels.push_back({meshCreate(vertices, indices, vertexBufferUsage, indexBufferUsage), 0.0f, unsigned(indices.size() / 3)});
+    chain.sphere = chain.levels[0].mesh.bounds.sphere;
+
+    std::vector<Vertex> levelVertices;
+    std::vector<unsigned int> levelIndices;
+    for(float ratio : ratios)
+    {
+        if(ratio >= 1.0f)
+        {
+            continue;
+        }
+
+        /* every level is simplified from the full mesh so its error is relative to the original surface */
+        float error = 0.0f;
+        std::size_t target = std::size_t(double(indices.size() / 3) * ratio) * 3;
+        std::vector<unsigned int> simplified = simplifyMesh(vertices, indices, target, maxError, &error);
+
+        const LodLevel& previous = chain.levels.back();
+        if(simplified.empty() || simplified.size() / 3 > previous.triangles * 9 / 10)
+        {
+            continue;
+        }
+
+        detail::compactLevel(vertices, simplified, levelVertices, levelIndices);
+        LodLevel level;
+        level.mesh = meshCreate(levelVertices, levelIndices, vertexBufferUsage, indexBufferUsage);
+        level.error = std::max(error, previous.error);
+        level.triangles = unsigned(simplified.size() / 3);
+        chain.levels.push_back(level);
+    }
+    return chain;
+}
+
+void lodChainDelete(LodChain& chain)
+{
+    for(LodLevel& level : chain.levels)
+    {
+        meshDelete(level.mesh);
+    }
+    chain.levels.clear();
+}
+
+unsigned int lodSelect(const LodChain& chain, const Matrix4D& model, const Camera& camera, float maxPixelError)
+{
+    if(chain.levels.empty())
+    {
+        return 0;
+    }
+
+    BoundingSphere sphere = sphereTransform(chain.sphere, model);
+    float scale = chain.sphere.radius > 0.0f ? sphere.radius / chain.sphere.radius : 1.0f;
+    float distance = std::max(length(sphere.center - camera.position) - sphere.radius, camera.nearPlane);
+
+    /* pixels covered by one model space unit at that distance */
+    float pixelsPerUnit = scale * camera.height / (2.0f * std::tan(camera.fov * 0.5f) * distance);
+
+    for(unsigned int i = unsigned(chain.levels.size()) - 1; i > 0; i--)
+    {
+        if(chain.levels[i].error * pixelsPerUnit <= maxPixelError)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "mesh.h"
+#include "camera.h"
+
+#include <vector>
+
+/**
+ * One level of detail of a mesh. error is the geometric deviation from the full resolution mesh in model space units.
+ */
+struct LodLevel
+{
+    Mesh mesh;
+    float error = 0.0f;
+    unsigned int triangles = 0;
+};
+
+/**
+ * Chain of levels ordered from full resolution (level 0) to coarsest. sphere bounds the full resolution mesh and is
+ * used to estimate the distance to the camera.
+ */
+struct LodChain
+{
+    std::vector<LodLevel> levels;
+    BoundingSphere sphere;
+};
+
+/**
+ * @brief Simplify a triangle mesh with the quadric error metric (Garland/Heckbert) by collapsing edges onto one of
+ * their vertices. No vertices are moved or created, so the result indexes into the same vertex data. Border vertices
+ * only slide along the border and positions shared by several vertices (seams, e.g. different colors) are kept.
+ *
+ * @param vertices Vertex data of the mesh.
+ * @param indices Triangle indices of the mesh.
+ * @param targetIndexCount Simplification stops once the result has at most this many indices.
+ * @param maxError Simplification stops before an edge collapse would exceed this error (model space units).
+ * @param resultError Optional, receives the error of the simplified mesh.
+ *
+ * @return Indices of the simplified mesh.
+ */
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                       std::size_t targetIndexCount, float maxError, float* resultError = nullptr);
+
+/**
+ * @brief Create a chain of simplified meshes. Each ratio gives the fraction of triangles of one level relative to the
+ * full mesh, levels that can't get noticeably below the previous one within maxError are left out.
+ *
+ * @param vertices Vertex data of the mesh.
+ * @param indices Triangle indices of the mesh.
+ * @param ratios Triangle ratios of the levels in decreasing order, e.g. {1.0f, 0.5f, 0.25f, 0.125f}.
+ * @param maxError Bound on the geometric error of every level (model space units).
+ * @param vertexBufferUsage enum to hint the usage of the vertex buffer (see usage parameter in glBufferData function).
+ * @param indexBufferUsage enum to hint the usage of the index buffer (see usage parameter in glBufferData function).
+ *
+ * @return LOD chain, level 0 is the full mesh.
+ */
+LodChain lodChainCreate(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<float>& ratios,
+                        float maxError, GLenum vertexBufferUsage, GLenum indexBufferUsage);
+
+/**
+ * @brief Delete the meshes of all levels.
+ *
+ * @param chain LOD chain to delete.
+ */
+void lodChainDelete(LodChain& chain);
+
+/**
+ * @brief Select the coarsest level whose error projected onto the screen stays below maxPixelError. The projected size
+ * uses the closest point of the bounding sphere, the vertical field of view and the image height of the camera.
+ *
+ * @param chain LOD chain of the mesh.
+ * @param model Model matrix of the mesh.
+ * @param camera Camera the mesh is rendered with.
+ * @param maxPixelError Largest tolerated error in pixels.
+ *
+ * @return Index of the level to draw.
+ *
+ * usage:
+ *
+ *   const LodLevel& level = myChain.levels[lodSelect(myChain, model, cam)];
+ *   glStateBindVertexArray(level.mesh.vao);
+ *   meshDraw(level.mesh);
+ *
+ */
+unsigned int lodSelect(const LodChain& chain, const Matrix4D& model, const Camera& camera, float maxPixelError = 1.0f);
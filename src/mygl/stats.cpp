@@ -0,0 +1,42 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+double statsPercentile(const std::vector<double>& sorted, double percentile)
+{
+    if(sorted.empty())
+    {
+        return 0.0;
+    }
+    /* smallest value with at least percentile % of all values less or equal, rank counts from 1 */
+    double rank = std::ceil(percentile * double(sorted.size()) / 100.0);
+    std::size_t index = rank > 1.0 ? std::size_t(rank) - 1 : 0;
+    return sorted[std::min(sorted.size() - 1, index)];
+}
+
+TimingStats timingStats(const std::vector<double>& values, std::size_t skip)
+{
+    std::vector<double> sorted(values.begin() + std::min(skip, values.size()), values.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    TimingStats stats;
+    stats.count = sorted.size();
+    if(sorted.empty())
+    {
+        return stats;
+    }
+
+    double sum = 0.0;
+    for(double value : sorted)
+    {
+        sum += value;
+    }
+    stats.mean = sum / double(sorted.size());
+    stats.min = sorted.front();
+    stats.p50 = statsPercentile(sorted, 50.0);
+    stats.p95 = statsPercentile(sorted, 95.0);
+    stats.p99 = statsPercentile(sorted, 99.0);
+    stats.max = sorted.back();
+    return stats;
+}
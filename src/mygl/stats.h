@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/* summary of a series of timings, all 0 for an empty series */
+struct TimingStats
+{
+    std::size_t count = 0;
+    double mean = 0.0;
+    double min = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/**
+ * @brief Nearest rank percentile, the value at rank ceil(percentile / 100 * n) of the n sorted values (counting from 1)
+ * without interpolation. The median of 2 values is the smaller one, p99 of 100 values the 99th.
+ *
+ * @param sorted Values in ascending order.
+ * @param percentile Percentile in [0, 100].
+ *
+ * @return Value at the percentile, 0 if there are no values.
+ */
+double statsPercentile(const std::vector<double>& sorted, double percentile);
+
+/**
+ * @brief Compute mean, min, max and the 50th, 95th and 99th percentile of a series.
+ *
+ * @param values Values in any order.
+ * @param skip Number of values at the front left out, e.g. warm-up frames.
+ *
+ * @return Statistics over values from skip on.
+ *
+ * usage:
+ *
+ *   TimingStats frames = timingStats(frameMs, warmupFrames);
+ *   std::cout << "mean " << frames.mean << " ms, p99 " << frames.p99 << " ms" << std::endl;
+ *
+ */
+TimingStats timingStats(const std::vector<double>& values, std::size_t skip = 0);
@@ -0,0 +1,78 @@
+#include "threadpool.h"
+
+#include <algorithm>
+
+namespace detail
+{
+    void workerLoop(ThreadPool* pool)
+    {
+        while(true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(pool->mutex);
+                pool->taskAvailable.wait(lock, [pool]() { return pool->stop || !pool->tasks.empty(); });
+                if(pool->tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(pool->tasks.front());
+                pool->tasks.pop_front();
+                pool->running++;
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(pool->mutex);
+                pool->running--;
+            }
+            pool->taskDone.notify_all();
+        }
+    }
+}
+
+ThreadPool* threadPoolCreate(unsigned int threads)
+{
+    if(threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    ThreadPool* pool = new ThreadPool;
+    for(unsigned int i = 0; i < threads; i++)
+    {
+        pool->workers.emplace_back(detail::workerLoop, pool);
+    }
+    return pool;
+}
+
+void threadPoolDelete(ThreadPool* pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stop = true;
+    }
+    pool->taskAvailable.notify_all();
+
+    for(std::thread& worker : pool->workers)
+    {
+        worker.join();
+    }
+    delete pool;
+}
+
+void threadPoolSubmit(ThreadPool* pool, std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->tasks.push_back(std::move(task));
+    }
+    pool->taskAvailable.notify_one();
+}
+
+void threadPoolWait(ThreadPool* pool)
+{
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->taskDone.wait(lock, [pool]() { return pool->tasks.empty() && pool->running == 0; });
+}
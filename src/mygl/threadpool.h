@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads executing tasks from a shared FIFO queue.
+ */
+struct ThreadPool
+{
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable taskDone;
+    unsigned int running = 0;
+    bool stop = false;
+};
+
+/**
+ * @brief Create a thread pool and start its worker threads.
+ *
+ * @param threads Number of worker threads, 0 uses one thread per hardware thread.
+ *
+ * @return Thread pool, has to be deleted with threadPoolDelete(...).
+ */
+ThreadPool* threadPoolCreate(unsigned int threads = 0);
+
+/**
+ * @brief Stop all worker threads after the queued tasks are finished and delete the pool.
+ *
+ * @param pool Thread pool to delete.
+ */
+void threadPoolDelete(ThreadPool* pool);
+
+/**
+ * @brief Queue a task for execution on one of the worker threads.
+ *
+ * @param pool Thread pool.
+ * @param task Task to execute.
+ */
+void threadPoolSubmit(ThreadPool* pool, std::function<void()> task);
+
+/**
+ * @brief Block until all queued and running tasks are finished.
+ *
+ * @param pool Thread pool.
+ */
+void threadPoolWait(ThreadPool* pool);
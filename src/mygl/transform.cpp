@@ -0,0 +1,31 @@
+#include "transform.h"
+#include "simd.h"
+
+Matrix4D matrixMultiply(const Matrix4D& a, const Matrix4D& b)
+{
+    Matrix4D result;
+#ifdef MYGL_SSE
+    const __m128 a0 = _mm_loadu_ps(a.n[0]);
+    const __m128 a1 = _mm_loadu_ps(a.n[1]);
+    const __m128 a2 = _mm_loadu_ps(a.n[2]);
+    const __m128 a3 = _mm_loadu_ps(a.n[3]);
+    for(int j = 0; j < 4; j++)
+    {
+        /* same summation order as the scalar product */
+        __m128 column = _mm_mul_ps(a0, _mm_set1_ps(b.n[j][0]));
+        column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b.n[j][1])));
+        column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b.n[j][2])));
+        column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(b.n[j][3])));
+        _mm_storeu_ps(result.n[j], column);
+    }
+#else
+    for(int j = 0; j < 4; j++)
+    {
+        for(int i = 0; i < 4; i++)
+        {
+            result.n[j][i] = a.n[0][i] * b.n[j][0] + a.n[1][i] * b.n[j][1] + a.n[2][i] * b.n[j][2] + a.n[3][i] * b.n[j][3];
+        }
+    }
+#endif
+    return result;
+}
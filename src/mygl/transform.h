@@ -0,0 +1,20 @@
+#pragma once
+
+#include "base.h"
+
+/**
+ * @brief Matrix product A * B, with SSE every column of the result is a sum of the columns of A scaled by one column
+ * of B. Gives the same result as Matrix4D's operator * without the per-element accessor calls, e.g. for the
+ * model-view-projection matrix of every draw.
+ *
+ * @param a Left matrix.
+ * @param b Right matrix.
+ *
+ * @return Product.
+ *
+ * usage:
+ *
+ *   Matrix4D mvp = matrixMultiply(cameraViewProjection(cam), model);
+ *
+ */
+Matrix4D matrixMultiply(const Matrix4D& a, const Matrix4D& b);
@@ -0,0 +1,163 @@
+#include "uniformbuffer.h"
+#include "glstate.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace detail
+{
+    /* std140 shape of a type: columns of columnBytes each, columns (and array elements) of matrices are 16 byte aligned */
+    struct Std140Shape
+    {
+        std::size_t alignment;
+        std::size_t columns;
+        std::size_t columnBytes;
+    };
+
+    Std140Shape std140Shape(Std140Type type)
+    {
+        switch(type)
+        {
+            case Std140Type::Float:
+            case Std140Type::Int:
+            case Std140Type::UInt: return {4, 1, 4};
+            case Std140Type::Vec2: return {8, 1, 8};
+            case Std140Type::Vec3: return {16, 1, 12};
+            case Std140Type::Vec4: return {16, 1, 16};
+            case Std140Type::Mat3: return {16, 3, 12};
+            case Std140Type::Mat4: return {16, 4, 16};
+        }
+        return {4, 1, 4};
+    }
+
+    std::size_t std140RoundUp(std::size_t value, std::size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    /* bytes between two array elements (or matrix columns) in the block */
+    std::size_t std140Stride(const Std140Member& member)
+    {
+        Std140Shape shape = std140Shape(member.type);
+        std::size_t columnStride = shape.columns > 1 ? 16 : shape.columnBytes;
+        std::size_t elementSize = shape.columns * columnStride;
+        return member.count > 1 ? std140RoundUp(elementSize, 16) : elementSize;
+    }
+}
+
+Std140Layout std140Layout(const std::vector<Std140Member>& members)
+{
+    Std140Layout layout;
+    layout.members = members;
+
+    std::size_t offset = 0;
+    for(const Std140Member& member : members)
+    {
+        /* arrays are aligned like vec4 */
+        std::size_t alignment = member.count > 1 ? 16 : detail::std140Shape(member.type).alignment;
+        offset = detail::std140RoundUp(offset, alignment);
+        layout.offsets.push_back(offset);
+        offset += detail::std140Stride(member) * member.count;
+    }
+    layout.size = detail::std140RoundUp(offset, 16);
+    return layout;
+}
+
+void std140Pack(const Std140Layout& layout, const void* source, void* destination)
+{
+    const unsigned char* from = static_cast<const unsigned char*>(source);
+    unsigned char* to = static_cast<unsigned char*>(destination);
+
+    /* padding is left as it is, the shader never reads it */
+    for(std::size_t i = 0; i < layout.members.size(); i++)
+    {
+        const Std140Member& member = layout.members[i];
+        const detail::Std140Shape shape = detail::std140Shape(member.type);
+        const std::size_t stride = detail::std140Stride(member);
+
+        const unsigned char* element = from + member.source;
+        for(unsigned int e = 0; e < member.count; e++)
+        {
+            unsigned char* target = to + layout.offsets[i] + e * stride;
+            for(std::size_t c = 0; c < shape.columns; c++)
+            {
+                std::memcpy(target + c * 16, element, shape.columnBytes);
+                element += shape.columnBytes;
+            }
+        }
+    }
+}
+
+UniformRing uniformRingCreate(const Std140Layout& layout, GLuint binding, unsigned int segments)
+{
+    if(segments == 0)
+    {
+        std::cerr << "[UniformBuffer] A uniform ring needs at least one segment" << std::endl;
+        std::cerr.flush();
+        throw std::runtime_error("[UniformBuffer] A uniform ring needs at least one segment");
+    }
+
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+    UniformRing ring;
+    ring.binding = binding;
+    ring.layout = layout;
+    ring.stride = GLsizeiptr(detail::std140RoundUp(layout.size, std::size_t(std::max(alignment, 1))));
+    ring.segments = segments;
+    ring.current = segments - 1;
+    ring._fences.resize(segments, nullptr);
+
+    glGenBuffers(1, &ring.buffer);
+    glStateBindBuffer(GL_UNIFORM_BUFFER, ring.buffer);
+    glBufferData(GL_UNIFORM_BUFFER, ring.stride * segments, nullptr, GL_STREAM_DRAW);
+    return ring;
+}
+
+void uniformRingWrite(UniformRing& ring, const void* source)
+{
+    /* draws reading the current segment are submitted by now, fence them before moving on */
+    if(!ring._fences[ring.current])
+    {
+        ring._fences[ring.current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    ring.current = (ring.current + 1) % ring.segments;
+
+    /* only blocks if the GPU is more than segments - 1 writes behind */
+    GLsync& fence = ring._fences[ring.current];
+    if(fence)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    const GLintptr offset = GLintptr(ring.current) * ring.stride;
+    glStateBindBuffer(GL_UNIFORM_BUFFER, ring.buffer);
+    void* memory = glMapBufferRange(GL_UNIFORM_BUFFER, offset, GLsizeiptr(ring.layout.size),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if(memory)
+    {
+        std140Pack(ring.layout, source, memory);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+
+    /* also binds the buffer to the generic target, which the state cache already knows */
+    glBindBufferRange(GL_UNIFORM_BUFFER, ring.binding, ring.buffer, offset, GLsizeiptr(ring.layout.size));
+}
+
+void uniformRingDelete(UniformRing& ring)
+{
+    for(GLsync& fence : ring._fences)
+    {
+        if(fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    glStateDeleteBuffer(ring.buffer);
+    ring = UniformRing();
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "base.h"
+
+#include <cstddef>
+#include <vector>
+
+/* GLSL types of std140 block members */
+enum class Std140Type
+{
+    Float,
+    Int,
+    UInt,
+    Vec2,
+    Vec3,
+    Vec4,
+    Mat3,
+    Mat4
+};
+
+/* member of a C++ struct that is uploaded into a uniform block, in declaration order of the block */
+struct Std140Member
+{
+    Std140Type type;
+
+    /* offsetof(...) of the member in the C++ struct */
+    std::size_t source;
+
+    /* array length, 1 for plain members */
+    unsigned int count = 1;
+};
+
+/**
+ * std140 layout of a uniform block computed from a C++ struct description. The C++ members are tightly packed (float,
+ * int, unsigned int, Vector2D/3D/4D, Matrix3D, Matrix4D and arrays of them), std140 aligns vec3 and matrix columns to 16
+ * bytes and every array element to 16 bytes, so the data has to be repacked on upload.
+ */
+struct Std140Layout
+{
+    std::vector<Std140Member> members;
+
+    /* std140 byte offset of each member */
+    std::vector<std::size_t> offsets;
+
+    /* block size, rounded up to 16 bytes */
+    std::size_t size = 0;
+};
+
+/**
+ * Uniform buffer holding several copies (segments) of one block, e.g. one per frame in flight. Every write goes to the
+ * next segment, so the CPU never overwrites data the GPU may still read, a fence per segment guards the wrap around.
+ */
+struct UniformRing
+{
+    GLuint buffer = 0;
+    GLuint binding = 0;
+    Std140Layout layout;
+
+    /* distance of the segments, the block size rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT */
+    GLsizeiptr stride = 0;
+    unsigned int segments = 0;
+    unsigned int current = 0;
+
+    std::vector<GLsync> _fences;
+};
+
+/**
+ * @brief Compute the std140 offsets of a block.
+ *
+ * @param members Members in the order of the block declaration.
+ *
+ * @return Layout.
+ *
+ * usage:
+ *
+ *   struct Light { Vector3D position; float radius; Vector4D colors[4]; };
+ *   Std140Layout layout = std140Layout({{Std140Type::Vec3, offsetof(Light, position)},
+ *                                       {Std140Type::Float, offsetof(Light, radius)},
+ *                                       {Std140Type::Vec4, offsetof(Light, colors), 4}});
+ *
+ */
+Std140Layout std140Layout(const std::vector<Std140Member>& members);
+
+/**
+ * @brief Repack a C++ struct into std140 layout.
+ *
+ * @param layout Layout of the block.
+ * @param source C++ struct described by the layout.
+ * @param destination Memory of at least layout.size bytes.
+ */
+void std140Pack(const Std140Layout& layout, const void* source, void* destination);
+
+/**
+ * @brief Create a ring buffered uniform block.
+ *
+ * @param layout Layout of the block.
+ * @param binding Uniform buffer binding point the current segment is bound to.
+ * @param segments Number of copies, at least the number of frames in flight.
+ *
+ * @return Uniform ring.
+ */
+UniformRing uniformRingCreate(const Std140Layout& layout, GLuint binding, unsigned int segments = 3);
+
+/**
+ * @brief Pack a C++ struct into the next segment and bind that segment to the binding point. Called once per frame,
+ * all programs using the block read the new data, no matter how many there are.
+ *
+ * @param ring Uniform ring.
+ * @param source C++ struct described by the layout of the ring.
+ */
+void uniformRingWrite(UniformRing& ring, const void* source);
+
+/**
+ * @brief Delete the buffer and fences of a uniform ring.
+ *
+ * @param ring Uniform ring.
+ */
+void uniformRingDelete(UniformRing& ring);
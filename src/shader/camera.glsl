@@ -0,0 +1,9 @@
+/* per-frame camera data, see CameraBlock */
+layout(std140) uniform Camera
+{
+    mat4 uView;
+    mat4 uProj;
+    mat4 uViewProj;
+    vec3 uCameraPosition;
+    float uTime;
+};
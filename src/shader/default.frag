@@ -1,10 +1,18 @@
 #version 330 core
 
+/* variants: LIGHTING (see shadervariant.h) */
 in vec4 tColor;
 in vec3 tFragPos;
+
 out vec4 FragColor;
 
 void main(void)
 {
     FragColor = tColor;
+#ifdef LIGHTING
+    /* flat normal of the triangle from the screen space derivatives of the world position */
+    vec3 normal = normalize(cross(dFdx(tFragPos), dFdy(tFragPos)));
+    float diffuse = abs(dot(normal, normalize(vec3(0.5, 1.0, 0.3))));
+    FragColor.rgb *= 0.3 + 0.7 * diffuse;
+#endif
 }
@@ -1,18 +1,58 @@
 #version 330 core
 
+/* variants: INSTANCED, UNIFORM_COLOR, WAVES, LIGHTING (see shadervariant.h) */
+#include "camera.glsl"
+
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec4 aColor;
 
+#ifdef INSTANCED
+/* per-instance attributes, see meshDrawInstanced */
+layout(location = 2) in mat4 aModel;
+layout(location = 6) in vec4 aInstanceColor;
+#else
+/* projection * view * model, combined on the CPU once per draw */
+uniform mat4 uMVP;
+#endif
+
+#ifdef UNIFORM_COLOR
+uniform vec4 uColor;
+#endif
+
+#ifdef WAVES
+#include "waves.glsl"
+#endif
+
+#ifndef INSTANCED
+/* only for tFragPos, the linker drops both if the fragment shader doesn't read it */
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProj;
+#endif
 
 out vec4 tColor;
 out vec3 tFragPos;
 
 void main(void)
 {
-    gl_Position = uProj * uView * uModel * vec4(aPosition, 1.0);
+    vec3 position = aPosition;
+#ifdef WAVES
+    position.y += waveHeight(position.xz, uTime);
+#endif
+
+#ifdef INSTANCED
+    vec4 worldPos = aModel * vec4(position, 1.0);
+    gl_Position = uViewProj * worldPos;
+#else
+    gl_Position = uMVP * vec4(position, 1.0);
+    vec4 worldPos = uModel * vec4(position, 1.0);
+#endif
+
+#ifdef UNIFORM_COLOR
+    tColor = uColor;
+#else
     tColor = aColor;
-    tFragPos = vec3(uModel * vec4(aPosition, 1.0));
+#endif
+#ifdef INSTANCED
+    tColor *= aInstanceColor;
+#endif
+    tFragPos = worldPos.xyz;
 }
@@ -0,0 +1,13 @@
+/* sum of three sine waves, see WaveParams: amplitude, phi and omega in xyz */
+uniform vec3 uWaves[3];
+uniform vec2 uWaveDirections[3];
+
+float waveHeight(vec2 position, float time)
+{
+    float height = 0.0;
+    for(int i = 0; i < 3; i++)
+    {
+        height += uWaves[i].x * sin(dot(uWaveDirections[i], position) * uWaves[i].z + time * uWaves[i].y);
+    }
+    return height;
+}
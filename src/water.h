@@ -43,14 +43,14 @@ struct Water
  * usage:
  *
  *   Water myWater = waterCreate({0.0, 0.0, 1.0, 0.5})
- *   glBindVertexArray(myWater.mesh.vao);
- *   glDrawElements(GL_TRIANGLES, myWater.size_ibo, GL_UNSIGNED_INT, nullptr);
+ *   glStateBindVertexArray(myWater.mesh.vao);
+ *   meshDraw(myWater.mesh);
  *
  */
 Water waterCreate(const Vector4D &color);
 
 /**
- * @brief Cleanup and delete all OpenGL buffers of the water mesh. Has to be called for each water after it is not used anymore.
+ * @brief Cleanup and release the pool ranges of the water mesh. Has to be called for each water after it is not used anymore.
  *
  * @param water Water to delete.
  */
@@ -0,0 +1,76 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "mygl/geometry.h"
+#include "mygl/importer.h"
+#include "mygl/meshfile.h"
+
+/* converts OBJ/PLY files or the built-in geometry into the binary mesh format (*.vcm) */
+void printUsage(const char* program)
+{
+    std::cerr << "usage: " << program << " <input.obj|input.ply> <output.vcm>\n"
+              << "       " << program << " --builtin <cube|quad|grid> <output.vcm>" << std::endl;
+}
+
+bool builtinGeometry(const std::string& name, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    const Vector4D white = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    if(name == "cube")
+    {
+        vertices = cube::vertices;
+        indices = cube::indices;
+    }
+    else if(name == "quad" || name == "grid")
+    {
+        const auto& positions = name == "quad" ? quad::vertexPos : grid::vertexPos;
+        indices = name == "quad" ? quad::indices : grid::indices;
+        vertices.clear();
+        for(const Vector3D& p : positions) { vertices.push_back({p, white}); }
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::string output;
+
+    try
+    {
+        if(argc == 4 && std::strcmp(argv[1], "--builtin") == 0)
+        {
+            if(!builtinGeometry(argv[2], vertices, indices))
+            {
+                std::cerr << "Unknown built-in geometry " << argv[2] << std::endl;
+                return EXIT_FAILURE;
+            }
+            output = argv[3];
+        }
+        else if(argc == 3)
+        {
+            importMesh(argv[1], vertices, indices);
+            output = argv[2];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        meshFileWrite(output, vertices, indices);
+    }
+    catch(const std::exception&)
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::cout << output << ": " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles" << std::endl;
+    return EXIT_SUCCESS;
+}